@@ -0,0 +1,106 @@
+#include <vector>
+#include "Rcpp.h"
+#include "CoefBatch.h"
+#include "GammaGen.h"
+
+
+
+
+// `idx` are the indices in `gamma` of the coefficients in the batch, and the
+// type of each coefficient is given by its specifications in the same way as
+// in `GammaGen::create_arr`.  `fuse_a_tilde` should only be true for the
+// day-level coefficients when the covariate patterns aren't in use.
+
+CoefBatch::CoefBatch(GammaGen** gamma,
+		     const Rcpp::List& gamma_specs,
+		     const std::vector<int>& idx,
+		     bool fuse_a_tilde) :
+    // initialization list
+    m_fuse_a_tilde(fuse_a_tilde) {
+
+    for (size_t k = 0; k < idx.size(); ++k) {
+
+	const int j = idx[k];
+	const Rcpp::NumericVector curr_specs = gamma_specs[j];
+
+	switch((int) curr_specs["type"]) {
+	case GAMMA_GEN_TYPE_CATEG:
+	    m_categ.push_back(static_cast<GammaCateg*>(gamma[j]));
+	    m_categ_idx.push_back(j);
+	    break;
+	case GAMMA_GEN_TYPE_CONT_MH:
+	    m_cont_mh.push_back(static_cast<GammaContMH*>(gamma[j]));
+	    m_cont_mh_idx.push_back(j);
+	    break;
+	case GAMMA_GEN_TYPE_CONT_AUX:
+	    m_cont_aux.push_back(static_cast<GammaContAux*>(gamma[j]));
+	    m_cont_aux_idx.push_back(j);
+	    break;
+	default:
+	    Rcpp::stop("unknown gamma type");
+	}
+    }
+
+    m_a_tilde.assign(m_categ.size(), 0.0);
+}
+
+
+
+
+// sample the coefficients in the batch, and store the new values of `gamma_h`
+// in `vals` at the indices of the coefficients
+
+void CoefBatch::sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X, double* vals) {
+
+    if (m_fuse_a_tilde && (! m_categ.empty())) {
+	calc_a_tilde(W);
+	for (size_t k = 0; k < m_categ.size(); ++k) {
+	    vals[ m_categ_idx[k] ] = m_categ[k]->sample_day(m_a_tilde[k], xi, ubeta, X);
+	}
+    }
+    else {
+	for (size_t k = 0; k < m_categ.size(); ++k) {
+	    vals[ m_categ_idx[k] ] = m_categ[k]->GammaCateg::sample(W, xi, ubeta, X);
+	}
+    }
+
+    for (size_t k = 0; k < m_cont_mh.size(); ++k) {
+	vals[ m_cont_mh_idx[k] ] = m_cont_mh[k]->GammaContMH::sample(W, xi, ubeta, X);
+    }
+
+    for (size_t k = 0; k < m_cont_aux.size(); ++k) {
+	vals[ m_cont_aux_idx[k] ] = m_cont_aux[k]->GammaContAux::sample(W, xi, ubeta, X);
+    }
+}
+
+
+
+
+// calculate `a_tilde` for each of the categorical coefficients in a single pass
+// over the days in the pregnancy cycles (see `GammaCateg::calc_a_tilde`)
+
+void CoefBatch::calc_a_tilde(const WGen& W) {
+
+    const int* w_vals = W.vals();
+    const int* w_days_idx = W.days_idx();
+    const int n_categ = m_categ.size();
+
+    for (int k = 0; k < n_categ; ++k) {
+	m_a_tilde[k] = m_categ[k]->m_hyp_a;
+    }
+
+    for (dsp_idx_t t = 0; t < W.n_preg_days(); ++t) {
+
+	const dsp_idx_t r = w_days_idx[t];
+	const int w_val = w_vals[t];
+	if (! w_val) {
+	    continue;
+	}
+
+	for (int k = 0; k < n_categ; ++k) {
+	    if (m_categ[k]->m_Uh[r]) {
+		m_a_tilde[k] += w_val;
+	    }
+	}
+    }
+}
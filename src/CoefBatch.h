@@ -0,0 +1,55 @@
+#ifndef DSP_BAYES_SRC_COEF_BATCH_H
+#define DSP_BAYES_SRC_COEF_BATCH_H
+
+#include <vector>
+#include "Rcpp.h"
+#include "GammaGen.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+
+// a group of the coefficients that are sampled together, e.g. the day-level
+// coefficients, grouped by the type of their sampler.
+//
+// The coefficients of each type are stored contiguously and their samplers are
+// called directly rather than through the virtual `GammaGen::sample`, so that
+// the calls are able to be inlined.  This also allows calculations that don't
+// depend on the values of the coefficients to be performed for all of the
+// coefficients of a type in a single pass over the data.  Currently this is
+// done for `a_tilde` for the day-level categorical coefficients (see
+// `GammaCateg::calc_a_tilde`), which only depends on `W`.
+//
+// Note that the coefficients are sampled one type at a time, so that the order
+// in which the coefficients are sampled may differ from the order in `idx`.
+
+class CoefBatch {
+
+public:
+
+    // the coefficients of each type, and the indices of the coefficients in
+    // the array of all of the coefficients.  The coefficients are not owned by
+    // the object.
+    std::vector<GammaCateg*> m_categ;
+    std::vector<int> m_categ_idx;
+    std::vector<GammaContMH*> m_cont_mh;
+    std::vector<int> m_cont_mh_idx;
+    std::vector<GammaContAux*> m_cont_aux;
+    std::vector<int> m_cont_aux_idx;
+
+    // whether `a_tilde` is calculated for all of the categorical coefficients
+    // in a single pass, and storage for the values
+    const bool m_fuse_a_tilde;
+    std::vector<double> m_a_tilde;
+
+    CoefBatch(GammaGen** gamma,
+	      const Rcpp::List& gamma_specs,
+	      const std::vector<int>& idx,
+	      bool fuse_a_tilde);
+
+    void sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X, double* vals);
+    void calc_a_tilde(const WGen& W);
+};
+
+
+#endif
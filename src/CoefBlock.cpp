@@ -0,0 +1,392 @@
+#include <cmath>
+#include <vector>
+#include "Rcpp.h"
+#include "CoefBlock.h"
+#include "DayChunks.h"
+#include "global_vars.h"
+
+
+
+
+// `idx` are the indices in `gamma` of the coefficients in the block
+
+CoefBlock::CoefBlock(GammaGen** gamma, const std::vector<int>& idx, dsp_idx_t n_days) :
+    // initialization list
+    m_n_days(n_days),
+    m_n_coefs(idx.size()),
+    m_scales(idx.size(), 1.0),
+    m_scales_init(false),
+    m_step(COEF_BLOCK_INIT_STEP),
+    m_accept_ctr(0),
+    m_prop_ctr(0),
+    m_adapt() {
+
+    for (size_t k = 0; k < idx.size(); ++k) {
+	m_gamma.push_back(gamma[ idx[k] ]);
+    }
+
+    m_active.reserve(m_n_coefs);
+    m_beta_curr.reserve(m_n_coefs);
+    m_beta_prop.reserve(m_n_coefs);
+    m_beta_diff.reserve(m_n_coefs);
+    m_grad_curr.reserve(m_n_coefs);
+    m_grad_prop.reserve(m_n_coefs);
+    m_u_row.reserve(m_n_coefs);
+}
+
+
+
+
+// jointly update the coefficients in the block that are currently in the
+// continuous part of their prior.  The proposal is
+//
+//     beta* = beta + (eps^2 / 2) * S^2 * grad(beta) + eps * S * z
+//
+// for `eps` the step size, `S` the diagonal matrix of the scales, and `z` a
+// vector of standard normal random variables.
+
+void CoefBlock::sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X) {
+
+    if (! m_scales_init) {
+	init_scales(xi, ubeta, X);
+    }
+
+    m_active.clear();
+    for (int k = 0; k < m_n_coefs; ++k) {
+	if (m_gamma[k]->m_gam_val != 1.0) {
+	    m_active.push_back(k);
+	}
+    }
+
+    const int n_active = m_active.size();
+    if (n_active == 0) {
+	return;
+    }
+
+    m_beta_curr.resize(n_active);
+    m_beta_prop.resize(n_active);
+    m_beta_diff.resize(n_active);
+    m_grad_curr.resize(n_active);
+    m_grad_prop.resize(n_active);
+    m_u_row.resize(n_active);
+
+    calc_grad_curr(W, xi, ubeta, X);
+
+    // sample the proposal value, which is rejected without evaluating the
+    // likelihood if it is outside of the support of the prior
+    const double half_sq_step = 0.5 * m_step * m_step;
+    bool is_in_bnds = true;
+    for (int a = 0; a < n_active; ++a) {
+
+	const GammaGen* gamma = m_gamma[ m_active[a] ];
+	const double scale = m_scales[ m_active[a] ];
+
+	m_beta_curr[a] = gamma->m_beta_val;
+	m_beta_prop[a] = (m_beta_curr[a]
+			  + half_sq_step * scale * scale * m_grad_curr[a]
+			  + m_step * scale * R::norm_rand());
+	m_beta_diff[a] = m_beta_prop[a] - m_beta_curr[a];
+
+	const double gam_prop = exp(m_beta_prop[a]);
+	if ((gam_prop <= gamma->m_bnd_l) || (gam_prop >= gamma->m_bnd_u)) {
+	    is_in_bnds = false;
+	}
+    }
+
+    // calculate the log acceptance ratio
+    double log_r = R_NegInf;
+    if (is_in_bnds) {
+	log_r = calc_prop(W, xi, ubeta, X);
+	for (int a = 0; a < n_active; ++a) {
+	    log_r += log_prior_diff(a);
+	}
+	log_r += (log_proposal_den(m_beta_curr, m_beta_prop, m_grad_prop)
+		  - log_proposal_den(m_beta_prop, m_beta_curr, m_grad_curr));
+    }
+
+    // accept proposal value `min(r, 1)-th` of the time
+    const bool is_accept = (log_r >= 0) || (log(R::unif_rand()) < log_r);
+    if (is_accept) {
+	commit(ubeta);
+	for (int a = 0; a < n_active; ++a) {
+	    GammaGen* gamma = m_gamma[ m_active[a] ];
+	    gamma->m_beta_val = m_beta_prop[a];
+	    gamma->m_gam_val = exp(m_beta_prop[a]);
+	}
+    }
+
+    // tune the step size during the burn-in phase, and otherwise track the
+    // acceptance rate
+    if (g_burn_status) {
+	m_step = MhAdapt::adapt_step(m_step, m_adapt.next_gain(), log_r, MH_ADAPT_TARGET_MALA);
+    }
+    else {
+	++m_prop_ctr;
+	m_accept_ctr += is_accept;
+    }
+}
+
+
+
+
+// calculate the gradient of the log-likelihood at the current values of the
+// coefficients, and add the gradient of the log prior
+
+void CoefBlock::calc_grad_curr(const WGen& W, const XiGen& xi, const UProdBeta& ubeta, const int* X) {
+
+    const int* w_vals                 = W.vals();
+    const int* w_days_idx             = W.days_idx();
+    const double* xi_vals             = xi.vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    const int n_active                = m_active.size();
+
+    for (int a = 0; a < n_active; ++a) {
+	m_grad_curr[a] = 0.0;
+    }
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+
+	    // if intercourse did not occur on this day then the day doesn't
+	    // contribute to the log-likelihood.  Note that `w_days_idx` has a
+	    // sentinal value appended to the end of the data.
+	    if (! X[r]) {
+		continue;
+	    }
+
+	    double resid = -X[r] * xi_vals[ d2s[r] ] * ubeta_exp_vals[r];
+	    if (*w_days_idx == r) {
+		resid += *w_vals;
+		++w_vals;
+		++w_days_idx;
+	    }
+
+	    for (int a = 0; a < n_active; ++a) {
+		m_grad_curr[a] += m_gamma[ m_active[a] ]->m_Uh[r] * resid;
+	    }
+	}
+    }
+
+    for (int a = 0; a < n_active; ++a) {
+	m_grad_curr[a] += log_prior_grad(a, m_gamma[ m_active[a] ]->m_beta_val);
+    }
+}
+
+
+
+
+// calculate `log p(W | beta*, xi) - log p(W | beta, xi)` and the gradient of
+// the log posterior at the proposal value.
+//
+// As a side-effect, the values of `exp(U * beta)` under the proposal are
+// written to the scratch space in `ubeta` for the days where the proposal
+// changes `U * beta`, so that they are able to be reused by `commit` if the
+// proposal is accepted.
+
+double CoefBlock::calc_prop(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X) {
+
+    const int* w_vals                 = W.vals();
+    const int* w_days_idx             = W.days_idx();
+    const double* xi_vals             = xi.vals();
+    const dsp_store_t* ubeta_vals     = ubeta.vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    dsp_store_t* ubeta_exp_prop       = ubeta.exp_prop();
+    const int n_active                = m_active.size();
+
+    for (int a = 0; a < n_active; ++a) {
+	m_grad_prop[a] = 0.0;
+    }
+
+    double sum_log_lik = 0.0;
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+
+	    // the change in `u_ijk^T beta` under the proposal
+	    double delta = 0.0;
+	    for (int a = 0; a < n_active; ++a) {
+		m_u_row[a] = m_gamma[ m_active[a] ]->m_Uh[r];
+		delta += m_u_row[a] * m_beta_diff[a];
+	    }
+	    if (delta != 0.0) {
+		ubeta_exp_prop[r] = exp(ubeta_vals[r] + delta);
+	    }
+
+	    if (! X[r]) {
+		continue;
+	    }
+
+	    const double exp_prop = (delta != 0.0) ? ubeta_exp_prop[r] : ubeta_exp_vals[r];
+	    const double x_xi = X[r] * xi_vals[ d2s[r] ];
+
+	    // the terms `w_ijk * (u_ijk^T beta* - u_ijk^T beta)` and `-X_ijk *
+	    // xi_i * [exp(u_ijk^T beta*) - exp(u_ijk^T beta)]` of the
+	    // log-likelihood ratio
+	    double w_val = 0.0;
+	    if (*w_days_idx == r) {
+		w_val = *w_vals;
+		++w_vals;
+		++w_days_idx;
+	    }
+	    sum_log_lik += (w_val * delta) - (x_xi * (exp_prop - ubeta_exp_vals[r]));
+
+	    const double resid = w_val - (x_xi * exp_prop);
+	    for (int a = 0; a < n_active; ++a) {
+		m_grad_prop[a] += m_u_row[a] * resid;
+	    }
+	}
+    }
+
+    for (int a = 0; a < n_active; ++a) {
+	m_grad_prop[a] += log_prior_grad(a, m_beta_prop[a]);
+    }
+
+    return sum_log_lik;
+}
+
+
+
+
+// update `U * beta` and `exp(U * beta)` based upon accepting the proposal
+// value, where the values of `exp(U * beta)` under the proposal were saved by
+// `calc_prop`
+
+void CoefBlock::commit(UProdBeta& ubeta) {
+
+    dsp_store_t* ubeta_vals     = ubeta.vals();
+    dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    const dsp_store_t* ubeta_exp_prop = ubeta.exp_prop();
+    const int n_active          = m_active.size();
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+
+	    double delta = 0.0;
+	    for (int a = 0; a < n_active; ++a) {
+		delta += m_gamma[ m_active[a] ]->m_Uh[r] * m_beta_diff[a];
+	    }
+	    if (delta != 0.0) {
+		ubeta_vals[r] += delta;
+		ubeta_exp_vals[r] = ubeta_exp_prop[r];
+	    }
+	}
+    }
+}
+
+
+
+
+// calculate the scale of each of the coefficients as the inverse square root
+// of
+//
+//     sum_{ijk} U_ijkh^2 * X_ijk * xi_i * exp(u_ijk^T beta) + b_h * gamma_h
+//
+// which is the negative of the second derivative of the log posterior with
+// respect to `beta_h`
+
+void CoefBlock::init_scales(const XiGen& xi, const UProdBeta& ubeta, const int* X) {
+
+    const double* xi_vals             = xi.vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+
+    std::vector<double> info(m_n_coefs, 0.0);
+    for (int k = 0; k < m_n_coefs; ++k) {
+	info[k] = m_gamma[k]->m_hyp_b * m_gamma[k]->m_gam_val;
+    }
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+	    if (! X[r]) {
+		continue;
+	    }
+	    const double mean_val = X[r] * xi_vals[ d2s[r] ] * ubeta_exp_vals[r];
+	    for (int k = 0; k < m_n_coefs; ++k) {
+		const double u_val = m_gamma[k]->m_Uh[r];
+		info[k] += u_val * u_val * mean_val;
+	    }
+	}
+    }
+
+    for (int k = 0; k < m_n_coefs; ++k) {
+	m_scales[k] = (info[k] > 0.0) ? (1.0 / sqrt(info[k])) : 1.0;
+    }
+    m_scales_init = true;
+}
+
+
+
+
+// calculate `log p(gamma_h*) - log p(gamma_h)` for the `a`-th coefficient
+// updated in the current scan, where both values are in the continuous part
+// of the prior.  This is the same expression as is used by
+// `GammaContMH::get_gam_log_lik`, so that the joint update has the same target
+// distribution as the `GammaContMH` steps.
+
+double CoefBlock::log_prior_diff(int a) const {
+
+    const GammaGen* gamma = m_gamma[ m_active[a] ];
+    return (((gamma->m_hyp_a - 1) * m_beta_diff[a])
+	    - (gamma->m_hyp_b * (exp(m_beta_prop[a]) - gamma->m_gam_val)));
+}
+
+
+
+
+// the derivative of the log prior of the `a`-th coefficient updated in the
+// current scan with respect to `beta_h`, evaluated at `beta`
+
+double CoefBlock::log_prior_grad(int a, double beta) const {
+
+    const GammaGen* gamma = m_gamma[ m_active[a] ];
+    return (gamma->m_hyp_a - 1) - (gamma->m_hyp_b * exp(beta));
+}
+
+
+
+
+// the log density of the proposal distribution, up to a constant, of moving to
+// `to` from `from` where `grad_from` is the gradient at `from`
+
+double CoefBlock::log_proposal_den(const std::vector<double>& to,
+				   const std::vector<double>& from,
+				   const std::vector<double>& grad_from) const {
+
+    const double half_sq_step = 0.5 * m_step * m_step;
+    double sum_sq = 0.0;
+    for (size_t a = 0; a < m_active.size(); ++a) {
+	const double sq_scale = m_scales[ m_active[a] ] * m_scales[ m_active[a] ];
+	const double dev = to[a] - from[a] - (half_sq_step * sq_scale * grad_from[a]);
+	sum_sq += dev * dev / sq_scale;
+    }
+
+    return -sum_sq / (2.0 * m_step * m_step);
+}
+
+
+
+
+// the step size and the acceptance rate after the burn-in phase
+
+Rcpp::NumericVector CoefBlock::tuning() const {
+    return Rcpp::NumericVector::create(
+	Rcpp::Named("step")        = m_step,
+	Rcpp::Named("accept_rate") = (m_prop_ctr > 0) ?
+	    ((double) m_accept_ctr) / m_prop_ctr :
+	    NA_REAL);
+}
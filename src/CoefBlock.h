@@ -0,0 +1,96 @@
+#ifndef DSP_BAYES_SRC_COEF_BLOCK_H
+#define DSP_BAYES_SRC_COEF_BLOCK_H
+
+#include <vector>
+#include "Rcpp.h"
+#include "GammaGen.h"
+#include "IdxType.h"
+#include "MhAdapt.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+// the initial step size of the proposal, relative to the scale of each of the
+// coefficients
+#define COEF_BLOCK_INIT_STEP 0.5
+
+
+// a joint update of a block of the day-level coefficients that are sampled by
+// a `GammaContMH` step.
+//
+// Updating the coefficients one at a time mixes slowly when the columns are
+// correlated, so once per scan the coefficients in the block that are
+// currently in the continuous part of their prior (i.e. with `gamma_h != 1`)
+// are updated jointly by a Metropolis-adjusted Langevin step on the
+// W-augmented log-likelihood
+//
+//     sum_{ijk} W_ijk * u_ijk^T beta - X_ijk * xi_i * exp(u_ijk^T beta)
+//
+// plus the log prior of each of the coefficients, with the other coefficients
+// held fixed.  The gradient with respect to `beta_h` is
+//
+//     sum_{ijk} U_ijkh * (W_ijk - X_ijk * xi_i * exp(u_ijk^T beta))
+//
+// plus the gradient of the log prior, so that the gradient for all of the
+// coefficients in the block is calculated in a single sweep over the days.
+// Since the proposal is continuous the coefficients stay in the continuous
+// part of their prior, and the moves to and from `gamma_h = 1` are left to the
+// `GammaContMH` step for each of the coefficients, which is performed after
+// the joint update.
+//
+// The proposal is preconditioned by a scale for each of the coefficients,
+// given by the inverse square root of the diagonal of the information matrix
+// at the start of the chain, and the step size is adapted during the burn-in
+// phase (see MhAdapt.h).
+
+class CoefBlock {
+
+public:
+
+    // the coefficients in the block.  Not owned by the object.
+    std::vector<GammaGen*> m_gamma;
+
+    const dsp_idx_t m_n_days;
+    const int m_n_coefs;
+
+    // the indices in `m_gamma` of the coefficients updated in the current
+    // scan, and for each of these the current and proposal values, the
+    // difference between them, and the gradient at the current and proposal
+    // values.  `m_u_row` holds the values of the columns for one day.
+    std::vector<int> m_active;
+    std::vector<double> m_beta_curr;
+    std::vector<double> m_beta_prop;
+    std::vector<double> m_beta_diff;
+    std::vector<double> m_grad_curr;
+    std::vector<double> m_grad_prop;
+    std::vector<double> m_u_row;
+
+    // the scale of each of the coefficients, which is calculated at the first
+    // scan
+    std::vector<double> m_scales;
+    bool m_scales_init;
+
+    // the step size, and the number of accepted proposals and number of
+    // proposals after the burn-in phase
+    double m_step;
+    int m_accept_ctr;
+    int m_prop_ctr;
+    MhAdapt m_adapt;
+
+    CoefBlock(GammaGen** gamma, const std::vector<int>& idx, dsp_idx_t n_days);
+
+    void sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X);
+    void calc_grad_curr(const WGen& W, const XiGen& xi, const UProdBeta& ubeta, const int* X);
+    double calc_prop(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X);
+    void commit(UProdBeta& ubeta);
+    void init_scales(const XiGen& xi, const UProdBeta& ubeta, const int* X);
+    double log_prior_diff(int a) const;
+    double log_prior_grad(int a, double beta) const;
+    double log_proposal_den(const std::vector<double>& to,
+			    const std::vector<double>& from,
+			    const std::vector<double>& grad_from) const;
+    Rcpp::NumericVector tuning() const;
+};
+
+
+#endif
@@ -1,22 +1,143 @@
+#include <algorithm>
 #include "Rcpp.h"
 #include "CoefGen.h"
 #include "GammaGen.h"
 #include "WGen.h"
 #include "XiGen.h"
+#include "XiMarg.h"
+#include "CycLik.h"
 #include "UProdBeta.h"
 
 extern bool g_record_status;
+extern bool g_burn_status;
 
 
 
 
 CoefGen::CoefGen(Rcpp::NumericMatrix& U, Rcpp::List& gamma_specs, int n_samp) :
+    CoefGen(U.begin(), U.nrow(), gamma_specs, n_samp, NULL, NULL, NULL, true) {
+}
+
+
+
+
+CoefGen::CoefGen(const double* U,
+		 dsp_idx_t n_days,
+		 Rcpp::List& gamma_specs,
+		 int n_samp,
+		 ULevels* levels,
+		 FwDays* fw,
+		 UPatterns* patterns,
+		 bool record_status) :
     // initialization list
-    m_gamma(GammaGen::create_arr(U, gamma_specs)),
-    m_vals_rcpp(Rcpp::NumericVector(Rcpp::no_init(gamma_specs.size() * n_samp))),
+    m_gamma(GammaGen::create_arr(U, n_days, gamma_specs, levels, fw, &m_parent_cache)),
+    m_levels(levels),
+    m_fw(fw),
+    m_patterns(patterns),
+    m_block(NULL),
+    m_record_status(record_status),
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    m_vals_rcpp(Rcpp::NumericVector(Rcpp::no_init(gamma_specs.size()))),
+    m_vals(m_vals_rcpp.begin()),
+    m_draws((dsp_idx_t) gamma_specs.size() * (record_status ? n_samp : 0)),
+#else
+    m_vals_rcpp(Rcpp::NumericVector(Rcpp::no_init((dsp_idx_t) gamma_specs.size() * (record_status ? n_samp : 1)))),
     m_vals(m_vals_rcpp.begin()),
+#endif
+    m_rb_sums(gamma_specs.size(), 0.0),
+    m_rb_n(0),
     m_n_psi(0),
     m_n_gamma(gamma_specs.size()) {
+
+    for (int j = 0; j < m_n_gamma; ++j) {
+	if (m_gamma[j]->m_fw_pos >= 0) {
+	    m_fw_idx.push_back(j);
+	}
+	else {
+	    m_level_idx[ m_gamma[j]->m_level ].push_back(j);
+	}
+    }
+
+    // the k-th day-level coefficient corresponds to the k-th column of the
+    // patterns (see `create_patterns` in Dsp.cpp)
+    if (m_patterns) {
+	const std::vector<int>& day_idx = m_level_idx[U_LEVEL_DAY];
+	for (size_t k = 0; k < day_idx.size(); ++k) {
+	    m_gamma[ day_idx[k] ]->set_patterns(m_patterns, k);
+	}
+    }
+
+    // the day-level coefficients that are sampled with xi integrated out are
+    // sampled separately from the rest of the day-level coefficients
+    m_marg_idx = get_marg_idx(gamma_specs, m_level_idx[U_LEVEL_DAY]);
+    std::vector<int> day_batch_idx;
+    for (size_t k = 0; k < m_level_idx[U_LEVEL_DAY].size(); ++k) {
+	const int j = m_level_idx[U_LEVEL_DAY][k];
+	if (std::find(m_marg_idx.begin(), m_marg_idx.end(), j) == m_marg_idx.end()) {
+	    day_batch_idx.push_back(j);
+	}
+    }
+
+    // the calculations for the day-level categorical coefficients that only
+    // depend on `W` are fused when the covariate patterns aren't in use
+    for (int l = 0; l < 3; ++l) {
+	const bool fuse_a_tilde = (l == U_LEVEL_DAY) && (m_patterns == NULL);
+	m_level_batch[l] = new CoefBatch(m_gamma,
+					 gamma_specs,
+					 (l == U_LEVEL_DAY) ? day_batch_idx : m_level_idx[l],
+					 fuse_a_tilde);
+    }
+    m_fw_batch = new CoefBatch(m_gamma, gamma_specs, m_fw_idx, false);
+
+    const std::vector<int> block_idx = get_block_idx(gamma_specs, m_level_idx[U_LEVEL_DAY]);
+    if (! block_idx.empty()) {
+	m_block = new CoefBlock(m_gamma, block_idx, n_days);
+    }
+}
+
+
+
+
+// the indices of the day-level coefficients that are jointly updated (see
+// CoefBlock.h), which are those with a nonzero `block` entry in their
+// specifications that are sampled by a `GammaContMH` step
+
+std::vector<int> CoefGen::get_block_idx(const Rcpp::List& gamma_specs, const std::vector<int>& day_idx) {
+
+    std::vector<int> block_idx;
+    for (size_t k = 0; k < day_idx.size(); ++k) {
+	const Rcpp::NumericVector curr_specs = gamma_specs[ day_idx[k] ];
+	if (curr_specs.containsElementNamed("block")
+	    && ((int) curr_specs["block"])
+	    && (((int) curr_specs["type"]) == GAMMA_GEN_TYPE_CONT_MH)) {
+	    block_idx.push_back(day_idx[k]);
+	}
+    }
+
+    return block_idx;
+}
+
+
+
+
+// the indices of the day-level coefficients that are sampled with xi integrated
+// out when the sampler is collapsed (see XiMarg.h), which are those with a
+// nonzero `collapse` entry in their specifications that are sampled by a
+// `GammaContMH` step
+
+std::vector<int> CoefGen::get_marg_idx(const Rcpp::List& gamma_specs, const std::vector<int>& day_idx) {
+
+    std::vector<int> marg_idx;
+    for (size_t k = 0; k < day_idx.size(); ++k) {
+	const Rcpp::NumericVector curr_specs = gamma_specs[ day_idx[k] ];
+	if (curr_specs.containsElementNamed("collapse")
+	    && ((int) curr_specs["collapse"])
+	    && (((int) curr_specs["type"]) == GAMMA_GEN_TYPE_CONT_MH)) {
+	    marg_idx.push_back(day_idx[k]);
+	}
+    }
+
+    return marg_idx;
 }
 
 
@@ -27,22 +148,247 @@ CoefGen::~CoefGen() {
     	delete m_gamma[h];
     }
     delete[] m_gamma;
+    delete m_block;
+    for (int l = 0; l < 3; ++l) {
+	delete m_level_batch[l];
+    }
+    delete m_fw_batch;
 }
 
 
 
 
-void CoefGen::sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X) {
+// update the coefficients.  If `marg` is not NULL then the coefficients in
+// `m_marg_idx` are sampled with xi integrated out, given the value `phi_val` of
+// phi, after all of the other coefficients have been sampled.  In this case
+// `marg` is left containing the sums for the new values of `U * beta`, which
+// are used by `PhiGen::sample_marg`.  Otherwise the coefficients are sampled in
+// the usual way.
+
+void CoefGen::sample(const WGen& W,
+		     const XiGen& xi,
+		     UProdBeta& ubeta,
+		     const int* X,
+		     XiMarg* marg,
+		     double phi_val) {
 
     // if we're past the burn-in phase then update `m_vals` so that we don't
     // overwrite the previous samples in the current scan
-    if (g_record_status) {
+#ifndef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status && g_record_status) {
 	m_vals += m_n_gamma;
     }
+#endif
 
     // each iteration updates one gamma_h term and correspondingly udjusts
-    // the value of `ubeta`.
+    // the value of `ubeta`.  When the covariate patterns are in use, the
+    // pattern sums are calculated in a single sweep and the changes are
+    // applied to `ubeta` in a single sweep (see UPatterns.h).
+    if (m_patterns) {
+	m_patterns->calc_stats(W, xi, ubeta, X);
+	m_level_batch[U_LEVEL_DAY]->sample(W, xi, ubeta, X, m_vals);
+	m_patterns->apply(ubeta);
+    }
+    else {
+	// the coefficients in the block are first updated jointly, and then
+	// each of the day-level coefficients is updated as usual, which
+	// provides the moves to and from `gamma_h = 1`
+	if (m_block) {
+	    m_block->sample(W, xi, ubeta, X);
+	}
+	m_level_batch[U_LEVEL_DAY]->sample(W, xi, ubeta, X, m_vals);
+    }
+
+    // the fertile window day effects are sampled using the sums for each
+    // position, which are calculated in a single sweep (see FwDays.h)
+    if (m_fw) {
+	m_fw->calc_stats(W, xi, ubeta, X);
+	m_fw_batch->sample(W, xi, ubeta, X, m_vals);
+	m_fw->apply(ubeta);
+    }
+
+    // the cycle-level and subject-level coefficients are sampled using the
+    // cycle and subject sums, which are calculated after the coefficients that
+    // the sums depend upon have been sampled (see ULevels.h)
+    if (m_levels) {
+
+	m_levels->calc_cyc_stats(W, ubeta, X);
+	m_level_batch[U_LEVEL_CYC]->sample(W, xi, ubeta, X, m_vals);
+
+	m_levels->calc_subj_stats();
+	m_level_batch[U_LEVEL_SUBJ]->sample(W, xi, ubeta, X, m_vals);
+
+	m_levels->compose(ubeta);
+    }
+
+    if (marg) {
+	marg->calc_stats(W, ubeta, X);
+	for (size_t k = 0; k < m_marg_idx.size(); ++k) {
+	    const int j = m_marg_idx[k];
+	    m_vals[j] = static_cast<GammaContMH*>(m_gamma[j])->sample_marg(W, *marg, phi_val, ubeta, X);
+	}
+    }
+    else {
+	for (size_t k = 0; k < m_marg_idx.size(); ++k) {
+	    const int j = m_marg_idx[k];
+	    m_vals[j] = m_gamma[j]->sample(W, xi, ubeta, X);
+	}
+    }
+
+    // accumulate the conditional expectations for the Rao-Blackwellized
+    // estimates of the posterior means
+    if (! g_burn_status) {
+	for (int j = 0; j < m_n_gamma; ++j) {
+	    m_rb_sums[j] += m_gamma[j]->cond_mean();
+	}
+	++m_rb_n;
+    }
+
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status && ! g_burn_status) {
+	m_draws.record(m_vals, m_n_gamma);
+    }
+#endif
+}
+
+
+
+
+// update the coefficients against the likelihood of the pregnancy outcomes of
+// the cycles with `W` integrated out (see CycLik.h).  The sums in `lik` are
+// recalculated for the current value of `U * beta` and then kept up to date by
+// each of the coefficient samplers, so that `lik` is left containing the sums
+// for the new values of `U * beta`, which are used by `XiGen::sample_lik`.
+// Each of the coefficients, including those of the cycle-level and
+// subject-level columns and the fertile window day effects, is sampled in this
+// way.  It is expected that `check_lik` has been called.
+
+void CoefGen::sample_lik(CycLik& lik, const XiGen& xi, UProdBeta& ubeta, const int* X) {
+
+#ifndef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status && g_record_status) {
+	m_vals += m_n_gamma;
+    }
+#endif
+
+    lik.calc_stats(ubeta, X);
     for (int j = 0; j < m_n_gamma; ++j) {
-	m_vals[j] = m_gamma[j]->sample(W, xi, ubeta, X);
+	m_vals[j] = static_cast<GammaContMH*>(m_gamma[j])->sample_lik(lik, xi, ubeta, X);
+    }
+
+    if (! g_burn_status) {
+	for (int j = 0; j < m_n_gamma; ++j) {
+	    m_rb_sums[j] += m_gamma[j]->cond_mean();
+	}
+	++m_rb_n;
     }
+
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status && ! g_burn_status) {
+	m_draws.record(m_vals, m_n_gamma);
+    }
+#endif
+}
+
+
+
+
+// the likelihood engine samples each coefficient by a `GammaContMH` step, so
+// the other samplers aren't supported (see `get_gamma_specs` in
+// R/mcmc_gamma_specs.R)
+
+void CoefGen::check_lik() const {
+
+    for (int j = 0; j < m_n_gamma; ++j) {
+	if (! dynamic_cast<GammaContMH*>(m_gamma[j])) {
+	    Rcpp::stop("the likelihood engine requires the Metropolis-Hastings sampler for each coefficient");
+	}
+    }
+}
+
+
+
+
+// exchange the current values of the coefficients with those of `other`, which
+// is used to swap the states of two chains of a temperature ladder (see
+// TemperLadder.h).  As for `XiGen::swap_state` the recorded values for the
+// scan are replaced by the values after the swap, and so are the terms for the
+// scan in the Rao-Blackwellized sums.  The ladder is only used with the
+// likelihood engine, for which the terms are the sampled values (see
+// `GammaGen::cond_mean`).
+
+void CoefGen::swap_state(CoefGen& other) {
+
+    for (int j = 0; j < m_n_gamma; ++j) {
+	const double gam_diff = other.m_gamma[j]->m_gam_val - m_gamma[j]->m_gam_val;
+	std::swap(m_gamma[j]->m_beta_val, other.m_gamma[j]->m_beta_val);
+	std::swap(m_gamma[j]->m_gam_val, other.m_gamma[j]->m_gam_val);
+	m_vals[j] = m_gamma[j]->m_gam_val;
+	other.m_vals[j] = other.m_gamma[j]->m_gam_val;
+	if (! g_burn_status) {
+	    m_rb_sums[j] += gam_diff;
+	    other.m_rb_sums[j] -= gam_diff;
+	}
+    }
+
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status && ! g_burn_status) {
+	m_draws.replace_last(m_vals, m_n_gamma);
+    }
+    if (other.m_record_status && ! g_burn_status) {
+	other.m_draws.replace_last(other.m_vals, m_n_gamma);
+    }
+#endif
+}
+
+
+
+
+// the recorded samples of the coefficients.  See Precision.h for the form of
+// the return value when the samples are recorded in single precision.
+
+Rcpp::RObject CoefGen::recorded_draws() const {
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    return m_draws.rcpp();
+#else
+    return m_vals_rcpp;
+#endif
+}
+
+
+
+
+// the Rao-Blackwellized estimates of the posterior means of the coefficients,
+// given by the average over the scans after the burn-in phase of the expected
+// values of the full conditional distributions.  For the coefficients without
+// a closed form expected value this is the average of the samples.
+
+Rcpp::NumericVector CoefGen::rb_means() const {
+
+    Rcpp::NumericVector out(m_n_gamma);
+    for (int j = 0; j < m_n_gamma; ++j) {
+	out[j] = (m_rb_n > 0) ? (m_rb_sums[j] / m_rb_n) : NA_REAL;
+    }
+
+    return out;
+}
+
+
+
+
+// the Metropolis-Hastings tuning parameters and acceptance rate of each of the
+// coefficients (see `GammaGen::tuning`), with one row per coefficient
+
+Rcpp::NumericMatrix CoefGen::tuning() const {
+
+    Rcpp::NumericMatrix out(m_n_gamma, 3);
+    for (int j = 0; j < m_n_gamma; ++j) {
+	const Rcpp::NumericVector curr_tuning = m_gamma[j]->tuning();
+	for (int k = 0; k < 3; ++k) {
+	    out(j, k) = curr_tuning[k];
+	}
+    }
+    Rcpp::colnames(out) = Rcpp::CharacterVector::create("mh_delta", "mh_p", "accept_rate");
+
+    return out;
 }
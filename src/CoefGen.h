@@ -1,9 +1,18 @@
 #ifndef DSP_BAYES_SRC_COEF_GEN_H
 #define DSP_BAYES_SRC_COEF_GEN_H
 
+#include <vector>
 #include "Rcpp.h"
+#include "CoefBatch.h"
+#include "CoefBlock.h"
 #include "GammaGen.h"
+#include "Precision.h"
+#include "ULevels.h"
+#include "FwDays.h"
+#include "UPatterns.h"
 #include "XiGen.h"
+#include "XiMarg.h"
+#include "CycLik.h"
 #include "UProdBeta.h"
 
 
@@ -11,19 +20,95 @@ class CoefGen {
 
 public:
 
+    // the parents of the interaction columns, which are shared by the
+    // interaction columns with the same parent (see `GammaGen::create_uh`).
+    // Declared before `m_gamma` so that it is constructed first.
+    UCol::ParentCache m_parent_cache;
+
     GammaGen** m_gamma;
 
+    // the cycle-level and subject-level data, or NULL if all of the columns
+    // are day-level.  Not owned by the object.
+    ULevels* m_levels;
+
+    // the indices of the coefficients for the day-level, cycle-level, and
+    // subject-level columns, respectively, which determine the order in which
+    // the coefficients are sampled
+    std::vector<int> m_level_idx[3];
+
+    // the fertile window day effects, or NULL if there are none.  Not owned by
+    // the object.  The indices of the corresponding coefficients are not
+    // included in `m_level_idx`.
+    FwDays* m_fw;
+    std::vector<int> m_fw_idx;
+
+    // the covariate patterns of the day-level columns, or NULL if they aren't
+    // in use.  Not owned by the object.  When in use, the day-level
+    // coefficients are sampled using the pattern sums (see UPatterns.h).
+    UPatterns* m_patterns;
+
+    // the joint update of the day-level coefficients that are specified to be
+    // in the block, or NULL if there are none (see CoefBlock.h)
+    CoefBlock* m_block;
+
+    // the indices of the day-level coefficients that are sampled with xi
+    // integrated out when the sampler is collapsed (see XiMarg.h), which are
+    // sampled after all of the other coefficients.  These are not included in
+    // `m_level_batch`.
+    std::vector<int> m_marg_idx;
+
+    // the coefficients in `m_level_idx` and `m_fw_idx`, respectively, grouped
+    // by the type of their sampler (see CoefBatch.h).  Owned by the object.
+    // The day-level batch doesn't include the coefficients in `m_marg_idx`.
+    CoefBatch* m_level_batch[3];
+    CoefBatch* m_fw_batch;
+
+    // whether the samples are recorded.  If not, then `m_vals_rcpp` only
+    // stores the current values of the coefficients.
+    const bool m_record_status;
     Rcpp::NumericVector m_vals_rcpp;
     Rcpp::NumericVector::iterator m_vals;
 
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    // when recording samples in single precision, `m_vals_rcpp` only stores
+    // the current values of the coefficients, and the samples are recorded in
+    // `m_draws`
+    FloatDraws m_draws;
+#endif
+
+    // the sum over the scans after the burn-in phase of the expected value of
+    // each coefficient given the other parameters (see `GammaGen::cond_mean`),
+    // and the number of such scans
+    std::vector<double> m_rb_sums;
+    int m_rb_n;
+
     const int m_n_psi;
     const int m_n_gamma;
 
     CoefGen(Rcpp::NumericMatrix& U, Rcpp::List& gamma_specs, int n_samp);
+    CoefGen(const double* U,
+	    dsp_idx_t n_days,
+	    Rcpp::List& gamma_specs,
+	    int n_samp,
+	    ULevels* levels,
+	    FwDays* fw,
+	    UPatterns* patterns,
+	    bool record_status);
     ~CoefGen();
 
-    void sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X);
+    void sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X) {
+	sample(W, xi, ubeta, X, NULL, 0.0);
+    }
+    void sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X, XiMarg* marg, double phi_val);
+    void sample_lik(CycLik& lik, const XiGen& xi, UProdBeta& ubeta, const int* X);
+    void check_lik() const;
+    void swap_state(CoefGen& other);
 
+    Rcpp::RObject recorded_draws() const;
+    Rcpp::NumericVector rb_means() const;
+    Rcpp::NumericMatrix tuning() const;
+    static std::vector<int> get_block_idx(const Rcpp::List& gamma_specs, const std::vector<int>& day_idx);
+    static std::vector<int> get_marg_idx(const Rcpp::List& gamma_specs, const std::vector<int>& day_idx);
     const double* vals() const { return m_vals; }
 };
 
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Rcpp.h"
+#include "CycLik.h"
+#include "DayBlock.h"
+#include "DayChunks.h"
+#include "global_vars.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+
+
+
+CycLik::CycLik(const WGen& W, const XiGen& xi, dsp_idx_t n_days) :
+    // initialization list
+    m_preg_cyc(W.m_preg_cyc),
+    m_n_preg_cyc(W.m_n_preg_cyc),
+    m_n_subj(xi.m_n_subj),
+    m_n_days(n_days),
+    m_subj_cyc(xi.m_n_subj + 1, 0),
+    m_cyc_sums(W.m_n_preg_cyc, 0.0),
+    m_cyc_diffs(W.m_n_preg_cyc, 0.0),
+    m_subj_sums(xi.m_n_subj, 0.0),
+    m_subj_diffs(xi.m_n_subj, 0.0),
+    m_inv_temp(1.0) {
+
+    // the pregnancy cycles are in the same order as the days, so that the
+    // cycles of each subject are contiguous
+    int q = 0;
+    for (int i = 0; i < m_n_subj; ++i) {
+	m_subj_cyc[i] = q;
+	while ((q < m_n_preg_cyc) && (m_preg_cyc[q].subj_idx == i)) {
+	    ++q;
+	}
+    }
+    m_subj_cyc[m_n_subj] = q;
+
+    if (q != m_n_preg_cyc) {
+	Rcpp::stop("the pregnancy cycles must be in the same order as the subjects");
+    }
+}
+
+
+
+
+// calculate `L_ij` for each pregnancy cycle and `A_i` for each subject in a
+// single sweep over the days.  The pregnancy cycles are visited in the same
+// order as the days.
+
+void CycLik::calc_stats(const UProdBeta& ubeta, const int* X) {
+
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+
+    std::fill(m_cyc_sums.begin(), m_cyc_sums.end(), 0.0);
+    std::fill(m_subj_sums.begin(), m_subj_sums.end(), 0.0);
+
+    int q = 0;
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+
+	    if (! X[r]) {
+		continue;
+	    }
+
+	    while ((q < m_n_preg_cyc) && (r >= m_preg_cyc[q].beg_idx + m_preg_cyc[q].n_days)) {
+		++q;
+	    }
+
+	    const double curr_val = X[r] * ubeta_exp_vals[r];
+	    if ((q < m_n_preg_cyc) && (r >= m_preg_cyc[q].beg_idx)) {
+		m_cyc_sums[q] += curr_val;
+	    }
+	    else {
+		m_subj_sums[ d2s[r] ] += curr_val;
+	    }
+	}
+    }
+}
+
+
+
+
+// set the changes in `L_ij` and `A_i` to 0 before they are accumulated for a
+// proposal
+
+void CycLik::reset_diffs() {
+    std::fill(m_cyc_diffs.begin(), m_cyc_diffs.end(), 0.0);
+    std::fill(m_subj_diffs.begin(), m_subj_diffs.end(), 0.0);
+}
+
+
+
+
+// the log-likelihood ratio of a proposal value of a coefficient, for which the
+// changes in `L_ij` and `A_i` are `D_ij` and `E_i`, given by
+//
+//     sum_{ij: Y_ij = 1} log{ (1 - exp(-xi_i * (L_ij + D_ij))) / (1 - exp(-xi_i * L_ij)) }
+//         - sum_i xi_i * E_i
+//
+// multiplied by the inverse temperature
+
+double CycLik::log_lik_diff(const double* xi_vals) const {
+
+    double sum_log_lik = 0.0;
+    for (int q = 0; q < m_n_preg_cyc; ++q) {
+	const double cyc_diff = m_cyc_diffs[q];
+	if (cyc_diff != 0.0) {
+	    const double xi_val = xi_vals[ m_preg_cyc[q].subj_idx ];
+	    sum_log_lik += (log(-expm1(-xi_val * (m_cyc_sums[q] + cyc_diff)))
+			    - log(-expm1(-xi_val * m_cyc_sums[q])));
+	}
+    }
+
+    for (int i = 0; i < m_n_subj; ++i) {
+	sum_log_lik -= xi_vals[i] * m_subj_diffs[i];
+    }
+
+    return m_inv_temp * sum_log_lik;
+}
+
+
+
+
+// update `L_ij` and `A_i` based upon accepting a proposal value of a
+// coefficient
+
+void CycLik::commit() {
+    for (int q = 0; q < m_n_preg_cyc; ++q) {
+	m_cyc_sums[q] += m_cyc_diffs[q];
+    }
+    for (int i = 0; i < m_n_subj; ++i) {
+	m_subj_sums[i] += m_subj_diffs[i];
+    }
+}
+
+
+
+
+// the log-likelihood, which isn't tempered, given by
+//
+//     sum_i { -xi_i * A_i + sum_{j: Y_ij = 1} log(1 - exp(-xi_i * L_ij)) }
+
+double CycLik::log_lik(const double* xi_vals) const {
+
+    double sum_log_lik = 0.0;
+    for (int q = 0; q < m_n_preg_cyc; ++q) {
+	sum_log_lik += log(-expm1(-xi_vals[ m_preg_cyc[q].subj_idx ] * m_cyc_sums[q]));
+    }
+    for (int i = 0; i < m_n_subj; ++i) {
+	sum_log_lik -= xi_vals[i] * m_subj_sums[i];
+    }
+
+    return sum_log_lik;
+}
+
+
+
+
+// sample `xi_i` from its full conditional distribution by a slice sampler,
+// given the current value `xi_val`.  The full conditional distribution isn't a
+// standard distribution, but it is close to the `Gamma(phi + t * n_i, phi + t *
+// (A_i + sum_j L_ij))` distribution where `n_i` is the number of pregnancy
+// cycles and `t` is the inverse temperature, so the standard deviation of this
+// distribution is used as the width of the initial interval.
+
+double CycLik::sample_xi(int i, double xi_val, double phi_val) const {
+
+    double sum_cyc = 0.0;
+    for (int q = m_subj_cyc[i]; q < m_subj_cyc[i + 1]; ++q) {
+	sum_cyc += m_cyc_sums[q];
+    }
+    const double shape = phi_val + (m_inv_temp * (m_subj_cyc[i + 1] - m_subj_cyc[i]));
+    const double width = sqrt(shape) / (phi_val + (m_inv_temp * (m_subj_sums[i] + sum_cyc)));
+
+    // the height of the slice
+    const double log_y = log_post_xi(i, xi_val, phi_val) - R::exp_rand();
+
+    // randomly position an interval around the current value and step it out
+    // until both ends are outside of the slice, with at most
+    // `CYC_LIK_SLICE_MAX_STEPS` steps in total (see `PhiGen::sample_slice`)
+    double lower = xi_val - (width * R::unif_rand());
+    double upper = lower + width;
+    int n_lower_steps = (int) (CYC_LIK_SLICE_MAX_STEPS * R::unif_rand());
+    int n_upper_steps = CYC_LIK_SLICE_MAX_STEPS - 1 - n_lower_steps;
+    while ((n_lower_steps > 0) && (lower > 0.0) && (log_post_xi(i, lower, phi_val) > log_y)) {
+	lower -= width;
+	--n_lower_steps;
+    }
+    while ((n_upper_steps > 0) && (log_post_xi(i, upper, phi_val) > log_y)) {
+	upper += width;
+	--n_upper_steps;
+    }
+    lower = std::fmax(0.0, lower);
+
+    // sample uniformly from the interval, shrinking the interval towards the
+    // current value after each value that is outside of the slice
+    while (true) {
+	const double proposal_val = R::runif(lower, upper);
+	if (log_post_xi(i, proposal_val, phi_val) > log_y) {
+	    return proposal_val;
+	}
+	if (proposal_val < xi_val) {
+	    lower = proposal_val;
+	}
+	else {
+	    upper = proposal_val;
+	}
+    }
+}
+
+
+
+
+// the log of the full conditional density of `xi_i` up to a constant, given by
+//
+//     (phi - 1) * log(xi_i) - phi * xi_i
+//         + t * { -A_i * xi_i + sum_{j: Y_ij = 1} log(1 - exp(-xi_i * L_ij)) }
+//
+// where `t` is the inverse temperature
+
+double CycLik::log_post_xi(int i, double xi_val, double phi_val) const {
+
+    if (xi_val <= 0.0) {
+	return R_NegInf;
+    }
+
+    double log_lik = -m_subj_sums[i] * xi_val;
+    for (int q = m_subj_cyc[i]; q < m_subj_cyc[i + 1]; ++q) {
+	log_lik += log(-expm1(-xi_val * m_cyc_sums[q]));
+    }
+
+    return ((phi_val - 1.0) * log(xi_val)) - (phi_val * xi_val) + (m_inv_temp * log_lik);
+}
@@ -0,0 +1,73 @@
+#ifndef DSP_BAYES_SRC_CYC_LIK_H
+#define DSP_BAYES_SRC_CYC_LIK_H
+
+#include <vector>
+#include "DayBlock.h"
+#include "IdxType.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+#define CYC_LIK_SLICE_MAX_STEPS 50
+
+
+// the sufficient statistics for the likelihood of the pregnancy outcomes of the
+// cycles with `W` integrated out.
+//
+// A cycle results in a pregnancy if and only if at least one of the `W_ijk` in
+// the cycle is nonzero, so that
+//
+//     P(Y_ij = 1 | xi_i, beta) = 1 - exp(-xi_i * L_ij)
+//
+// where `L_ij = sum_k X_ijk * exp(u_ijk^T beta)`.  The likelihood is then, up to
+// terms that don't depend on xi or beta,
+//
+//     prod_i { exp(-xi_i * A_i) * prod_{j: Y_ij = 1} (1 - exp(-xi_i * L_ij)) }
+//
+// where `A_i` is the sum of `X_ijk * exp(u_ijk^T beta)` over the days in the
+// cycles without a pregnancy.  The object stores `L_ij` for each pregnancy cycle
+// and `A_i` for each subject, so that the likelihood for a proposal value of a
+// coefficient or of `xi_i` is able to be calculated without `W` (see
+// `GammaContMH::sample_lik` and `XiGen::sample_lik`).
+//
+// The likelihood is raised to the power `m_inv_temp`, which is 1 other than
+// for the tempered chains of a temperature ladder (see TemperLadder.h).
+
+class CycLik {
+
+public:
+
+    // the elements of `m_preg_cyc` each map a pregnancy cycle to a block of
+    // days from the day-specific data.  Not owned by the object.
+    const PregCyc* m_preg_cyc;
+    const int m_n_preg_cyc;
+    const int m_n_subj;
+    const dsp_idx_t m_n_days;
+
+    // the index of the first pregnancy cycle of each subject, with the total
+    // number of pregnancy cycles appended
+    std::vector<int> m_subj_cyc;
+
+    // `L_ij` for each pregnancy cycle and `A_i` for each subject, and storage
+    // for the changes in these under a proposal value of a coefficient
+    std::vector<double> m_cyc_sums;
+    std::vector<double> m_cyc_diffs;
+    std::vector<double> m_subj_sums;
+    std::vector<double> m_subj_diffs;
+
+    // the inverse of the temperature of the chain
+    double m_inv_temp;
+
+    CycLik(const WGen& W, const XiGen& xi, dsp_idx_t n_days);
+
+    void calc_stats(const UProdBeta& ubeta, const int* X);
+    void reset_diffs();
+    double log_lik_diff(const double* xi_vals) const;
+    void commit();
+    double log_lik(const double* xi_vals) const;
+    double sample_xi(int i, double xi_val, double phi_val) const;
+    double log_post_xi(int i, double xi_val, double phi_val) const;
+};
+
+
+#endif
@@ -1,3 +1,4 @@
+#include <string>
 #include "Rcpp.h"
 #include "DayBlock.h"
 
@@ -7,6 +8,39 @@ using Rcpp::as;
 
 
 
+// the number of blocks described by `block_descr`, which is either the length
+// of the list or the number of rows in the matrix as described in DayBlock.h
+
+int block_descr_size(SEXP block_descr) {
+    return Rf_isMatrix(block_descr) ?
+	Rcpp::IntegerMatrix(block_descr).nrow() :
+	Rcpp::List(block_descr).size();
+}
+
+
+
+
+// obtain a pointer to the beginning of the column in `block_mat` with name
+// `col_nm`.  The column names are only searched once per call, so the cost of
+// the lookup doesn't scale with the number of blocks.
+
+const int* block_mat_col(Rcpp::IntegerMatrix& block_mat, const char* col_nm) {
+
+    Rcpp::CharacterVector block_nm = Rcpp::colnames(block_mat);
+
+    for (int j = 0; j < block_nm.size(); ++j) {
+	if (std::string(block_nm[j]) == col_nm) {
+	    return block_mat.begin() + j * block_mat.nrow();
+	}
+    }
+
+    Rcpp::stop(std::string("block matrix is missing column ") + col_nm);
+    return 0;
+}
+
+
+
+
 // construct an array of `DayBlock`s based upon an `Rcpp::List` that provides
 // the specifications for each block.  In more detail, an array of `DayBlock`s
 // is created with length given by the length of `block_list`.  Furthermore, it
@@ -23,7 +57,7 @@ DayBlock* DayBlock::list_to_arr(Rcpp::List& block_list) {
     // provided by the t-th element of `block_list`
     for (int t = 0; t < block_list.size(); ++t) {
 
-	block_arr[t] = DayBlock(as<IntegerVector>(block_list[t])["beg_idx"],
+	block_arr[t] = DayBlock((int) as<IntegerVector>(block_list[t])["beg_idx"],
 				as<IntegerVector>(block_list[t])["n_days"]);
     }
 
@@ -33,6 +67,32 @@ DayBlock* DayBlock::list_to_arr(Rcpp::List& block_list) {
 
 
 
+// similar to `DayBlock::list_to_arr`, but now the blocks are specified by the
+// rows of an integer matrix with columns named `beg_idx` and `n_days`.  The
+// columns are located once, after which the array is filled in by a single pass
+// over the column data.
+
+DayBlock* DayBlock::mat_to_arr(Rcpp::IntegerMatrix& block_mat) {
+
+    const int n_blocks = block_mat.nrow();
+    DayBlock* block_arr = new DayBlock[n_blocks];
+    if (n_blocks == 0) {
+	return block_arr;
+    }
+
+    const int* beg_idx = block_mat_col(block_mat, "beg_idx");
+    const int* n_days  = block_mat_col(block_mat, "n_days");
+
+    for (int t = 0; t < n_blocks; ++t) {
+	block_arr[t] = DayBlock(beg_idx[t], n_days[t]);
+    }
+
+    return block_arr;
+}
+
+
+
+
 // similar to `DayBlock::list_to_arr`, but now each element in `block_list`
 // stores integer values that can be accessed using names `beg_idx`, `n_days`,
 // and `subj_idx`, and which are used to initialize the struct's member values
@@ -47,7 +107,7 @@ PregCyc* PregCyc::list_to_arr(Rcpp::List& block_list) {
     // provided by the t-th element of `block_list`
     for (int t = 0; t < block_list.size(); ++t) {
 
-	block_arr[t] = PregCyc(as<IntegerVector>(block_list[t])["beg_idx"],
+	block_arr[t] = PregCyc((int) as<IntegerVector>(block_list[t])["beg_idx"],
 			       as<IntegerVector>(block_list[t])["n_days"],
 			       as<IntegerVector>(block_list[t])["subj_idx"]);
     }
@@ -58,6 +118,31 @@ PregCyc* PregCyc::list_to_arr(Rcpp::List& block_list) {
 
 
 
+// similar to `DayBlock::mat_to_arr`, but now `block_mat` also has a column
+// named `subj_idx`
+
+PregCyc* PregCyc::mat_to_arr(Rcpp::IntegerMatrix& block_mat) {
+
+    const int n_blocks = block_mat.nrow();
+    PregCyc* block_arr = new PregCyc[n_blocks];
+    if (n_blocks == 0) {
+	return block_arr;
+    }
+
+    const int* beg_idx  = block_mat_col(block_mat, "beg_idx");
+    const int* n_days   = block_mat_col(block_mat, "n_days");
+    const int* subj_idx = block_mat_col(block_mat, "subj_idx");
+
+    for (int t = 0; t < n_blocks; ++t) {
+	block_arr[t] = PregCyc(beg_idx[t], n_days[t], subj_idx[t]);
+    }
+
+    return block_arr;
+}
+
+
+
+
 // // similar to `DayBlock::list_to_arr` and `PregCyc::list_to_arr`, but now each
 // // element in `block_list` stores integer values that can be accessed using
 // // names `beg_idx`, `n_days`, `subj_idx`, and `n_miss`, and which are used to
@@ -2,21 +2,26 @@
 #define DSP_BAYES_SRC_DAY_BLOCK_H
 
 #include "Rcpp.h"
+#include "IdxType.h"
 
 
+// the number of days in a block is small, but the index of the first day in
+// the block may be arbitrarily large
+
 struct DayBlock {
 
-    int beg_idx;
+    dsp_idx_t beg_idx;
     int n_days;
 
     DayBlock() : beg_idx(0), n_days(0) {}
 
-    DayBlock(int beg_idx, int n_days) :
+    DayBlock(dsp_idx_t beg_idx, int n_days) :
 	beg_idx(beg_idx),
 	n_days(n_days) {
     }
 
     static DayBlock* list_to_arr(Rcpp::List& block_list);
+    static DayBlock* mat_to_arr(Rcpp::IntegerMatrix& block_mat);
 };
 
 
@@ -28,12 +33,13 @@ struct PregCyc : public DayBlock {
 
     PregCyc() : DayBlock(), subj_idx(0) {}
 
-    PregCyc(int beg_idx, int n_days, int subj_idx) :
+    PregCyc(dsp_idx_t beg_idx, int n_days, int subj_idx) :
 	DayBlock(beg_idx, n_days),
 	subj_idx(subj_idx) {
     }
 
     static PregCyc* list_to_arr(Rcpp::List& block_list);
+    static PregCyc* mat_to_arr(Rcpp::IntegerMatrix& block_mat);
 };
 
 
@@ -56,4 +62,35 @@ struct PregCyc : public DayBlock {
 // };
 
 
+
+
+
+// the block descriptions passed in from R may either be an `Rcpp::List` with
+// one named integer vector per block, or an integer matrix with one row per
+// block and with column names given by the names of the struct members.  The
+// latter form is preferred since it can be ingested without an R coercion and a
+// name lookup for every field of every block.  The following functions accept
+// either form.
+
+int block_descr_size(SEXP block_descr);
+const int* block_mat_col(Rcpp::IntegerMatrix& block_mat, const char* col_nm);
+
+
+// construct an array of `T`s from either form of block description by
+// dispatching to `T::mat_to_arr` or `T::list_to_arr` as appropriate
+
+template <typename T>
+T* block_descr_to_arr(SEXP block_descr) {
+
+    if (Rf_isMatrix(block_descr)) {
+	Rcpp::IntegerMatrix block_mat(block_descr);
+	return T::mat_to_arr(block_mat);
+    }
+    else {
+	Rcpp::List block_list(block_descr);
+	return T::list_to_arr(block_list);
+    }
+}
+
+
 #endif
@@ -0,0 +1,96 @@
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <cstdint>
+#include "DayBlock.h"
+#include "DayChunks.h"
+
+
+
+
+// partition the days into chunks with each chunk made up of the days for a
+// consecutive run of subjects, where subjects are added to a chunk until adding
+// the next subject would result in more than `max_chunk_days` days in the
+// chunk.  A subject with more than `max_chunk_days` days gets a chunk of its
+// own.  It is assumed that the subjects' days are stored consecutively and in
+// order in the day-specific data.
+
+void DayChunks::configure(const DayBlock* subj, int n_subj, int max_chunk_days) {
+
+    reset();
+
+    int curr_n_days = 0;
+    for (int i = 0; i < n_subj; ++i) {
+
+	// case: start a new chunk with the current subject
+	if ((i == 0) || (curr_n_days + subj[i].n_days > max_chunk_days)) {
+	    m_day_beg.push_back(subj[i].beg_idx);
+	    m_subj_beg.push_back(i);
+	    curr_n_days = 0;
+	}
+
+	curr_n_days += subj[i].n_days;
+    }
+
+    // the sentinal values
+    if (n_subj > 0) {
+	m_day_beg.push_back(subj[n_subj - 1].beg_idx + subj[n_subj - 1].n_days);
+	m_subj_beg.push_back(n_subj);
+    }
+}
+
+
+
+
+void DayChunks::add_array(const void* base, size_t elem_size, int n_cols, size_t n_days) {
+
+    DayArray arr = { static_cast<const char*>(base), elem_size, n_cols, n_days };
+    m_arrays.push_back(arr);
+}
+
+
+
+
+void DayChunks::reset() {
+    m_day_beg.clear();
+    m_subj_beg.clear();
+    m_arrays.clear();
+}
+
+
+
+
+// request that the operating system read the portion of each of the registered
+// day-specific arrays corresponding to the `c`-th chunk into memory.  The
+// request is asynchronous, so the function returns immediately.  Does nothing
+// if `c` is not a valid chunk index or if chunking is not in use.
+
+void DayChunks::prefetch(int c) const {
+
+#ifndef _WIN32
+    if ((! is_chunked()) || (c >= n_chunks())) {
+	return;
+    }
+
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+
+    for (size_t t = 0; t < m_arrays.size(); ++t) {
+
+	const DayArray& arr = m_arrays[t];
+
+	for (int j = 0; j < arr.n_cols; ++j) {
+
+	    // the beginning and one past the end of the chunk in the current
+	    // column, with the beginning rounded down to a page boundary as
+	    // required by `madvise`
+	    const char* col = arr.base + j * arr.n_days * arr.elem_size;
+	    uintptr_t beg = (uintptr_t) (col + m_day_beg[c] * arr.elem_size);
+	    uintptr_t end = (uintptr_t) (col + m_day_beg[c + 1] * arr.elem_size);
+	    beg -= beg % page_size;
+
+	    madvise((void*) beg, end - beg, MADV_WILLNEED);
+	}
+    }
+#endif
+}
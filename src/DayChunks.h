@@ -0,0 +1,78 @@
+#ifndef DSP_BAYES_SRC_DAY_CHUNKS_H
+#define DSP_BAYES_SRC_DAY_CHUNKS_H
+
+#include <cstddef>
+#include <vector>
+#include "DayBlock.h"
+
+
+// partitions the day-specific data into chunks of consecutive days, where each
+// chunk is made up of the days for a consecutive run of subjects, and provides
+// a way to request that the day-specific arrays for an upcoming chunk be read
+// into memory ahead of time.
+//
+// This is used for running the sampler on data that is too large to fit in
+// memory (see `dsp_from_file_`).  In this case the day-specific arrays are
+// backed by files, and the sweeps over the days are performed one chunk at a
+// time, with a readahead request issued for the next chunk before the current
+// chunk is processed.  This way the operating system is able to evict the
+// pages for the chunks that have already been processed, and reading the data
+// from disk overlaps with the computations.
+//
+// A default-constructed object consists of a single chunk spanning all of the
+// days, so that loops of the form
+//
+//     for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+//         g_day_chunks.prefetch(c + 1);
+//         for (int r = g_day_chunks.day_beg(c); r < g_day_chunks.day_end(c, n_days); ++r) {
+//             ...
+//         }
+//     }
+//
+// reduce to the usual loop over all of the days when chunking is not in use.
+
+class DayChunks {
+
+public:
+
+    // describes a day-specific array that is prefetched a chunk at a time.  The
+    // array has `n_cols` columns each with one element of size `elem_size` per
+    // day, and stored in column-major order.
+    struct DayArray {
+	const char* base;
+	size_t elem_size;
+	int n_cols;
+	size_t n_days;
+    };
+
+    // the day-specific index of the first day in each chunk followed by one
+    // past the index of the last day, and similarly for the subject-specific
+    // indices.  Both are empty when chunking is not in use.
+    std::vector<dsp_idx_t> m_day_beg;
+    std::vector<int> m_subj_beg;
+
+    std::vector<DayArray> m_arrays;
+
+    DayChunks() {}
+
+    void configure(const DayBlock* subj, int n_subj, int max_chunk_days);
+    void add_array(const void* base, size_t elem_size, int n_cols, size_t n_days);
+    void reset();
+
+    bool is_chunked() const { return ! m_day_beg.empty(); }
+    int n_chunks() const { return is_chunked() ? m_day_beg.size() - 1 : 1; }
+
+    dsp_idx_t day_beg(int c) const { return is_chunked() ? m_day_beg[c] : 0; }
+    dsp_idx_t day_end(int c, dsp_idx_t n_days) const { return is_chunked() ? m_day_beg[c + 1] : n_days; }
+    int subj_beg(int c) const { return is_chunked() ? m_subj_beg[c] : 0; }
+    int subj_end(int c, int n_subj) const { return is_chunked() ? m_subj_beg[c + 1] : n_subj; }
+
+    void prefetch(int c) const;
+};
+
+
+// the chunking in use by the sampler.  Defined in Dsp.cpp.
+extern DayChunks g_day_chunks;
+
+
+#endif
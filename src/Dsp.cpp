@@ -1,27 +1,437 @@
+#include <memory>
+#include <string>
 #include "Rcpp.h"
 #include "CoefGen.h"
+#include "DayBlock.h"
+#include "DayChunks.h"
+#include "FwDays.h"
+#include "IdxType.h"
+#include "ModelFile.h"
 #include "PhiGen.h"
+#include "TemperLadder.h"
 #include "UGen.h"
+#include "ULevels.h"
+#include "UPatterns.h"
+#include "VarBayes.h"
 #include "WGen.h"
 #include "XGen.h"
 #include "XiGen.h"
+#include "XiMarg.h"
+#include "CycLik.h"
 
 #define DSP_BAYES_N_INTERRUPT_CHECK 1000
+#define DSP_BAYES_N_EXP_SYNC 50
+
+// the engines that are able to be used by the sampler (see `sample_chain`).
+// These are the same as the `ENGINE_*` values in R/mcmc_dsp.R.
+#define DSP_BAYES_ENGINE_AUG 0
+#define DSP_BAYES_ENGINE_COLLAPSED 1
+#define DSP_BAYES_ENGINE_LIK 2
+#define DSP_BAYES_ENGINE_VB 3
 
 int* d2s;
 bool g_record_status = false;
+bool g_burn_status = false;
+DayChunks g_day_chunks;
 
 // Rcpp::List collect_output(const CoefGen& regr_coefs,
 // 			  const XiGen& xi,
 // 			  const PhiGen& phi);
 
-// w_day_blocks          used when sampling W
+// performs `n_burn` burn-in scans followed by `n_samp` recorded scans of the
+// sampler on the model data objects.  The tuning parameters of the
+// Metropolis-Hastings steps are adapted during the burn-in scans and then held
+// fixed (see MhAdapt.h).  This is shared by `dsp_` and `dsp_from_file_`,
+// which differ only in where the model data is read from.
+//
+// `engine` selects how the latent variables are handled.  For
+// `DSP_BAYES_ENGINE_AUG` each scan updates `W` and then the other parameters
+// given `W`.
+//
+// For `DSP_BAYES_ENGINE_COLLAPSED` the sampler is partially collapsed: the
+// coefficients that are specified to be collapsed and phi are sampled from
+// their full conditional distributions with xi integrated out (see XiMarg.h),
+// and xi is sampled at the end of the scan.  Each of these steps samples the
+// parameter jointly with xi, and since none of the steps after them and before
+// xi is sampled depend on xi, the values of xi from these steps need not be
+// drawn.  The remaining updates are conditional on the value of xi from the
+// end of the previous scan.  The interweaving step for phi (see
+// `PhiGen::sample_asis`) isn't needed in this case.
+//
+// For `DSP_BAYES_ENGINE_LIK` `W` is never sampled: the coefficients and xi are
+// sampled against the likelihood of the pregnancy outcomes of the cycles with
+// `W` integrated out (see CycLik.h), followed by phi given xi.  Each of the
+// coefficients is sampled by a Metropolis-Hastings step, including those of the
+// cycle-level and subject-level columns and the fertile window day effects.
+// The interweaving step for phi isn't used.  When there is missing data, `W` is
+// sampled given the new values of the other parameters at the end of the scan,
+// since the imputations of the missing data are conditional on `W`.  This is a
+// partially collapsed Gibbs sampler: `W` is sampled immediately before the
+// only updates that use it, so that the coefficients and xi are still sampled
+// with `W` integrated out.
+//
+// If `ladder` is not NULL then the likelihood engine is run on each of the
+// chains of a temperature ladder, with swaps of the states of the chains (see
+// TemperLadder.h).  This requires the likelihood engine and that there is no
+// missing data.
+//
+// `DSP_BAYES_ENGINE_VB` doesn't use the sampler: the output is instead taken
+// from a variational approximation to the posterior (see `create_vb`).
+
+void sample_chain(WGen& W,
+		  XiGen& xi,
+		  CoefGen& coefs,
+		  PhiGen& phi,
+		  UProdBeta& ubeta,
+		  XGen& X,
+		  UProdTau& utau,
+		  UGen& U,
+		  int n_burn,
+		  int n_samp,
+		  int engine,
+		  TemperLadder* ladder) {
+
+    g_burn_status = (n_burn > 0);
+    std::unique_ptr<XiMarg> marg((engine == DSP_BAYES_ENGINE_COLLAPSED) ? new XiMarg(xi) : NULL);
+    std::unique_ptr<CycLik> lik;
+    const bool has_miss = (X.m_n_miss_cyc > 0) || (U.m_n_vars > 0);
+    if (engine == DSP_BAYES_ENGINE_LIK) {
+	coefs.check_lik();
+	lik.reset(new CycLik(W, xi, ubeta.n_days()));
+    }
+    if (ladder && (engine != DSP_BAYES_ENGINE_LIK)) {
+	Rcpp::stop("the temperature ladder requires the likelihood engine");
+    }
+    else if (ladder && has_miss) {
+	Rcpp::stop("the temperature ladder doesn't support missing data");
+    }
+
+    // begin sampler loop
+    for (int s = 0; s < n_burn + n_samp; s++) {
+
+	if (ladder) {
+
+	    // perform the scan below for each of the chains of the ladder, and
+	    // periodically propose swaps of their states
+	    ladder->sample(X.vals(), s);
+	}
+	else if (lik) {
+
+	    // update the regression coefficients and then xi with `W`
+	    // integrated out, and then phi given xi
+	    coefs.sample_lik(*lik, xi, ubeta, X.vals());
+	    xi.sample_lik(*lik, phi);
+	    phi.sample(xi);
+	}
+	else if (marg) {
+
+	    // update the latent day-specific pregnancy variables W
+	    W.sample(xi, ubeta, X);
+
+	    // update the regression coefficients, the collapsed ones last, and
+	    // then phi, all with xi integrated out
+	    coefs.sample(W, xi, ubeta, X.vals(), marg.get(), phi.val());
+	    phi.sample_marg(xi, *marg);
+
+	    // update the woman-specific fecundability multipliers xi
+	    xi.sample(W, phi, ubeta, X);
+	}
+	else {
+
+	    // update the latent day-specific pregnancy variables W
+	    W.sample(xi, ubeta, X);
+
+	    // update the woman-specific fecundability multipliers xi
+	    xi.sample(W, phi, ubeta, X);
+
+	    // when the interweaving step is in use, phi is updated before the
+	    // coefficients since the step uses the sums for each subject from
+	    // sampling xi (see `PhiGen::sample_asis`)
+	    if (phi.m_use_asis) {
+		phi.sample(xi);
+		phi.sample_asis(xi);
+	    }
+
+	    // update the regression coefficients gamma and psi, and update the
+	    // resulting values of the `U * beta`
+	    coefs.sample(W, xi, ubeta, X.vals());
+
+	    // update phi, the variance parameter for xi
+	    if (! phi.m_use_asis) {
+		phi.sample(xi);
+	    }
+	}
+
+	// the coefficient samplers keep `exp(U * beta)` up to date by
+	// multiplicative updates, so it is only recalculated every
+	// `DSP_BAYES_N_EXP_SYNC` iterations to remove the accumulated rounding
+	// error
+	if ((s % DSP_BAYES_N_EXP_SYNC) == 0) {
+	    ubeta.update_exp();
+	    if (ladder) ladder->update_exp();
+	}
+
+	// for the likelihood engine `W` is only needed for the imputations of
+	// the missing data
+	if (lik && has_miss) {
+	    W.sample(xi, ubeta, X);
+	}
+
+	// update missing values for the intercourse variables X
+	X.sample(W, xi, ubeta, utau);
+
+	// // update missing values for the covariate data U
+	U.sample(W, xi, coefs, X, ubeta, utau);
+
+	// case: burn-in phase is over so record samples.  Note that this occurs
+	// after the samples in this scan have been taken; this is because
+	// `g_record_status` has the effect of informing the various classes to
+	// not overwrite previous data.  The first recorded scan is the one after
+	// the last burn-in scan.
+	if (s == n_burn - 1) g_burn_status = false;
+	if (s == n_burn) g_record_status = true;
+
+	// check for user interrupt every `DSP_BAYES_N_INTER_CHECK` iterations
+	if ((s % DSP_BAYES_N_INTERRUPT_CHECK) == 0) Rcpp::checkUserInterrupt();
+    }
+}
+
+
+
+
+// the final tuning parameters and the acceptance rates after the burn-in phase
+// for the Metropolis-Hastings steps.  `coefs` has one row per coefficient, with
+// missing values for the coefficients that aren't sampled by a
+// Metropolis-Hastings step.  `patterns` is whether the day-level coefficients
+// were sampled from the sums for the covariate patterns (see UPatterns.h), and
+// `block` is only included when some of the coefficients are jointly updated
+// (see CoefBlock.h).  The variational engine doesn't run the sampler, so there
+// are no tuning parameters and the return value is NULL.
+
+Rcpp::RObject collect_tuning(const CoefGen& coefs, const PhiGen& phi, int engine) {
+
+    if (engine == DSP_BAYES_ENGINE_VB) {
+	return Rcpp::RObject();
+    }
+
+    Rcpp::List out = Rcpp::List::create(Rcpp::Named("coefs")    = coefs.tuning(),
+					Rcpp::Named("phi")      = phi.tuning(),
+					Rcpp::Named("patterns") = (coefs.m_patterns != NULL));
+    if (coefs.m_block) {
+	out.push_back(coefs.m_block->tuning(), "block");
+    }
+
+    return out;
+}
+
+
+
+
+// check that the buffers used to record the samples and the design matrix are
+// able to be indexed, before any of them are allocated.  The indices of the
+// days and of the pregnancy days are stored in R integer vectors (e.g. `d2s`
+// and `w_to_days_idx`), so their numbers must also fit in an `int`.
+
+void check_sizes(double n_days, double n_preg_days, double n_subj, double n_coefs, double n_samp) {
+    check_int_size(n_days, "days");
+    check_int_size(n_preg_days, "days in pregnancy cycles");
+    check_idx_size(n_days * n_coefs, "the design matrix");
+    check_idx_size(n_subj * n_samp, "the xi samples");
+    check_idx_size(n_coefs * n_samp, "the coefficient samples");
+}
+
+
+
+
+// the cycle-level and subject-level columns of the design matrix (see
+// ULevels.h), or NULL if there are none so that all of the coefficients are
+// sampled using the day-level data
+
+ULevels* create_levels(const double* u_cyc,
+		       int n_cyc,
+		       int n_cyc_cols,
+		       const double* u_subj,
+		       int n_subj,
+		       int n_subj_cols,
+		       const int* d2c,
+		       dsp_idx_t n_days) {
+
+    if ((n_cyc_cols == 0) && (n_subj_cols == 0)) {
+	return NULL;
+    }
+
+    return new ULevels(u_cyc, n_cyc, u_subj, n_subj, d2c, n_days);
+}
+
+
+
+
+// the fertile window day effects (see FwDays.h), or NULL if `fw_pos` is NULL,
+// i.e. the model doesn't have the effects or they are included as ordinary
+// columns of the design matrix
+
+FwDays* create_fw(const int* fw_pos, dsp_idx_t n_days) {
+    return (fw_pos == NULL) ? NULL : new FwDays(fw_pos, n_days);
+}
+
+
+
+
+// the covariate patterns of the day-level columns (see UPatterns.h), or NULL if
+// the patterns can't be used.  This requires that each of the day-level
+// columns other than the fertile window day effects is a 0/1 column with a
+// categorical coefficient, and that none of the covariates are imputed by the
+// sampler, since the imputation changes the values of `U`.  `levels` and `fw`
+// are needed for the interaction columns with a cycle-level, subject-level, or
+// fertile window parent.
+
+UPatterns* create_patterns(const double* U,
+			   dsp_idx_t n_days,
+			   const Rcpp::List& gamma_specs,
+			   const Rcpp::List& u_miss_info,
+			   const ULevels* levels,
+			   const FwDays* fw) {
+
+    if (u_miss_info.size() > 0) {
+	return NULL;
+    }
+
+    std::vector<UCol> cols;
+    for (int j = 0; j < gamma_specs.size(); ++j) {
+
+	const Rcpp::NumericVector& curr_specs = Rcpp::as<Rcpp::NumericVector>(gamma_specs[j]);
+	if ((GammaGen::get_level(curr_specs) != U_LEVEL_DAY) ||
+	    (GammaGen::get_fw_pos(curr_specs) >= 0)) {
+	    continue;
+	}
+	else if ((int) curr_specs["type"] != GAMMA_GEN_TYPE_CATEG) {
+	    return NULL;
+	}
+
+	cols.push_back(GammaGen::create_uh(U, n_days, curr_specs, levels, fw, NULL));
+    }
+
+    if (cols.empty() || ! UPatterns::is_binary(cols, n_days)) {
+	return NULL;
+    }
+
+    return new UPatterns(cols, n_days);
+}
+
+
+
+
+// the variational approximation (see VarBayes.h) fitted from the initial values
+// of the sampler objects, or NULL if neither the variational engine is used nor
+// `vb_specs` specifies that the approximation is used to initialize the
+// sampler.  After it is fitted the sampler objects have the values of the
+// expectations under the approximation.  `U` and `gamma_specs` are the data
+// and specifications that `coefs` was constructed from.
+
+VarBayes* create_vb(const Rcpp::NumericVector& vb_specs,
+		    int engine,
+		    const WGen& W,
+		    XiGen& xi,
+		    CoefGen& coefs,
+		    PhiGen& phi,
+		    UProdBeta& ubeta,
+		    const XGen& X,
+		    const UGen& U_gen,
+		    const double* U,
+		    dsp_idx_t n_days,
+		    const Rcpp::List& gamma_specs) {
+
+    const bool is_init = (vb_specs.size() > 0) && (((int) vb_specs["init"]) != 0);
+    if ((engine != DSP_BAYES_ENGINE_VB) && (! is_init)) {
+	return NULL;
+    }
+
+    if ((X.m_n_miss_cyc > 0) || (U_gen.m_n_vars > 0)) {
+	Rcpp::stop("the variational approximation doesn't support missing data");
+    }
+
+    VarBayes* vb = new VarBayes(vb_specs, W, xi, coefs, phi, ubeta, X.vals(), U, n_days, gamma_specs);
+    vb->fit();
+
+    return vb;
+}
+
+
+
+
+// the recorded samples and the Rao-Blackwellized estimates from the sampler,
+// or for the variational engine the draws from the approximation and the
+// expectations under it.  `vb` describes the approximation if it was fitted.
+
+Rcpp::List collect_draws(const CoefGen& coefs,
+			 const XiGen& xi,
+			 const PhiGen& phi,
+			 VarBayes* vb,
+			 int engine,
+			 int n_samp) {
+
+    if (engine == DSP_BAYES_ENGINE_VB) {
+	return vb->output(n_samp);
+    }
+
+    return Rcpp::List::create(Rcpp::Named("coefs")    = coefs.recorded_draws(),
+			      Rcpp::Named("xi")       = xi.recorded_draws(),
+			      Rcpp::Named("phi")      = phi.m_vals_rcpp,
+			      Rcpp::Named("coefs_rb") = coefs.rb_means(),
+			      Rcpp::Named("xi_rb")    = xi.rb_means(),
+			      Rcpp::Named("vb")       = vb ? vb->params() : Rcpp::List());
+}
+
+
+
+
+// the temperature ladder for parallel tempering (see TemperLadder.h), or NULL
+// if `pt_specs` specifies a single chain
+
+TemperLadder* create_ladder(const Rcpp::NumericVector& pt_specs,
+			    const WGen& W,
+			    XiGen& xi,
+			    CoefGen& coefs,
+			    PhiGen& phi,
+			    UProdBeta& ubeta,
+			    const double* U,
+			    dsp_idx_t n_days,
+			    Rcpp::List& gamma_specs,
+			    const Rcpp::NumericVector& phi_specs,
+			    int n_samp) {
+
+    if ((pt_specs.size() == 0) || (((int) pt_specs["n_temps"]) <= 1)) {
+	return NULL;
+    }
+
+    // the objects for the tempered chains are only able to be constructed for
+    // data that the likelihood engine supports
+    coefs.check_lik();
+
+    return new TemperLadder(pt_specs, W, xi, coefs, phi, ubeta, U, n_days, gamma_specs, phi_specs, n_samp);
+}
+
+
+
+
+// w_day_blocks          used when sampling W.  Either a list or an integer matrix
+//                       (see DayBlock.h); the same is true of `subj_day_blocks`
 // w_to_days_idx         categorical gamma: a_tilde
 // w_cyc_to_subj_idx     used when sampling xi (first term)
 // fw_len                how much memory to set aside when sampling W in a cycle
 // subj_day_block        used when sampling xi (second term)
+// day_to_cyc_idx        maps the days to cycles for the cycle-level and
+//                       subject-level columns in `u_cyc` and `u_subj`
+// fw_pos                the fertile window position of each day, or an empty
+//                       vector if there are no fertile window day effects
 // gamma_specs           gamma hyperparameters
 // phi_specs             phi hyperparameters
+// engine                how the latent variables are handled (see
+//                       `sample_chain`)
+// pt_specs              the temperature ladder specifications, or an empty
+//                       vector for a single chain (see TemperLadder.h)
+// vb_specs              the variational approximation specifications (see
+//                       VarBayes.h)
 
 
 
@@ -29,11 +439,15 @@ bool g_record_status = false;
 // [[Rcpp::export]]
 Rcpp::List dsp_(Rcpp::NumericMatrix u_rcpp,
 		Rcpp::IntegerVector x_rcpp,
-		Rcpp::List          w_day_blocks,
+		SEXP                w_day_blocks,
 		Rcpp::IntegerVector w_to_days_idx,
 		Rcpp::IntegerVector w_cyc_to_subj_idx,
-		Rcpp::List          subj_day_blocks,
+		SEXP                subj_day_blocks,
 		Rcpp::IntegerVector day_to_subj_idx,
+		Rcpp::IntegerVector day_to_cyc_idx,
+		Rcpp::NumericMatrix u_cyc,
+		Rcpp::NumericMatrix u_subj,
+		Rcpp::IntegerVector fw_pos,
 		Rcpp::List          gamma_specs,
 		Rcpp::NumericVector phi_specs,
 		Rcpp::IntegerVector x_miss,
@@ -46,58 +460,285 @@ Rcpp::List dsp_(Rcpp::NumericMatrix u_rcpp,
 		Rcpp::IntegerVector u_sex_map,
 		int fw_len,
 		int n_burn,
-		int n_samp) {
+		int n_samp,
+		int engine,
+		Rcpp::NumericVector pt_specs,
+		Rcpp::NumericVector vb_specs) {
 
     // initialize global variable in case the value was set to true elsewhere
     g_record_status = false;
+    g_day_chunks.reset();
     bool is_verbose = true;
     d2s = day_to_subj_idx.begin();
+    check_sizes(u_rcpp.nrow(),
+		w_to_days_idx.size() - 1,
+		block_descr_size(subj_day_blocks),
+		gamma_specs.size(),
+		n_samp);
 
     // create data objects
     WGen W(w_day_blocks, w_to_days_idx, w_cyc_to_subj_idx, fw_len);
     XiGen xi(subj_day_blocks, n_samp, is_verbose);
-    CoefGen coefs(u_rcpp, gamma_specs, n_samp);
+    std::unique_ptr<ULevels> levels(create_levels(u_cyc.begin(),
+						  u_cyc.nrow(),
+						  u_cyc.ncol(),
+						  u_subj.begin(),
+						  u_subj.nrow(),
+						  u_subj.ncol(),
+						  day_to_cyc_idx.begin(),
+						  u_rcpp.nrow()));
+    std::unique_ptr<FwDays> fw(create_fw((fw_pos.size() > 0) ? fw_pos.begin() : NULL,
+					 u_rcpp.nrow()));
+    std::unique_ptr<UPatterns> patterns(create_patterns(u_rcpp.begin(),
+							u_rcpp.nrow(),
+							gamma_specs,
+							u_miss_info,
+							levels.get(),
+							fw.get()));
+    CoefGen coefs(u_rcpp.begin(),
+		  u_rcpp.nrow(),
+		  gamma_specs,
+		  n_samp,
+		  levels.get(),
+		  fw.get(),
+		  patterns.get(),
+		  true);
     PhiGen phi(phi_specs, n_samp, is_verbose);  // TODO: need a variable for keeping samples
     UProdBeta ubeta(u_rcpp.nrow());
     XGen X(x_rcpp, x_miss_cyc, x_miss_day, tau_coefs["cohort_sex_prob"], tau_coefs["sex_coef"]);
     UProdTau utau(utau_rcpp, tau_coefs);
     UGen U(u_rcpp, u_miss_info, u_miss_type, u_preg_map, u_sex_map, is_verbose);
 
-    // begin sampler loop
-    for (int s = 0; s < n_samp; s++) {
+    std::unique_ptr<VarBayes> vb(create_vb(vb_specs,
+					   engine,
+					   W,
+					   xi,
+					   coefs,
+					   phi,
+					   ubeta,
+					   X,
+					   U,
+					   u_rcpp.begin(),
+					   u_rcpp.nrow(),
+					   gamma_specs));
+    std::unique_ptr<TemperLadder> ladder(create_ladder(pt_specs,
+						       W,
+						       xi,
+						       coefs,
+						       phi,
+						       ubeta,
+						       u_rcpp.begin(),
+						       u_rcpp.nrow(),
+						       gamma_specs,
+						       phi_specs,
+						       n_samp));
 
-    	// update the latent day-specific pregnancy variables W
-    	W.sample(xi, ubeta, X);
+    if (engine != DSP_BAYES_ENGINE_VB) {
+	sample_chain(W, xi, coefs, phi, ubeta, X, utau, U, n_burn, n_samp, engine, ladder.get());
+    }
+    Rcpp::List draws = collect_draws(coefs, xi, phi, vb.get(), engine, n_samp);
 
-    	// update the woman-specific fecundability multipliers xi
-    	xi.sample(W, phi, ubeta, X);
+    return Rcpp::List::create(Rcpp::Named("coefs")      = draws["coefs"],
+			      Rcpp::Named("xi")         = draws["xi"],
+			      Rcpp::Named("phi")        = draws["phi"],
+			      Rcpp::Named("ugen")       = U.realized_samples(),
+			      Rcpp::Named("tuning")     = collect_tuning(coefs, phi, engine),
+			      Rcpp::Named("coefs_rb")   = draws["coefs_rb"],
+			      Rcpp::Named("xi_rb")      = draws["xi_rb"],
+			      Rcpp::Named("swap_rates") = ladder ? ladder->swap_rates() : Rcpp::NumericVector(0),
+			      Rcpp::Named("vb")         = draws["vb"]);
+}
 
-    	// update the regression coefficients gamma and psi, and update the
-    	// resulting values of the `U * beta`
-    	coefs.sample(W, xi, ubeta, X.vals());
-	ubeta.update_exp();  // <--- TODO: let's put this inside sample()
 
-    	// update phi, the variance parameter for xi
-    	phi.sample(xi);
 
-	// update missing values for the intercourse variables X
-	X.sample(W, xi, ubeta, utau);
 
-	// // update missing values for the covariate data U
-	U.sample(W, xi, coefs, X, ubeta, utau);
+// runs the sampler using the model data stored in the binary file `model_file`
+// (see `write_model_file` in R/data_model_file.R for the file format).  The
+// day-specific data, i.e. `U`, `X`, `utau`, and the day and pregnancy day
+// indices, are used directly from the file mapping rather than being copied
+// into R vectors first, so that the process only pays for the pages of the file
+// that it touches and that jobs running on the same file share those pages
+// until they are modified.  The block descriptions and the covariate missing
+// information are small and are copied.
+//
+// If `chunk_days` is positive then the sampler runs out-of-core: the sweeps
+// over the days are performed in subject-aligned chunks of at most `chunk_days`
+// days with the next chunk read ahead of time (see DayChunks.h), and the `U *
+// beta` storage is backed by a scratch file in `scratch_dir`.  In this case
+// only the subject-specific and cycle-specific data must fit in memory.
 
-	// case: burn-in phase is over so record samples.  Note that this occurs
-	// after the samples in this scan have been taken; this is because
-	// `g_record_status` has the effect of informing the various classes to
-	// not overwrite previous data.
-	if (s == 0) g_record_status = true;
+// [[Rcpp::export]]
+Rcpp::List dsp_from_file_(std::string         model_file,
+			  Rcpp::List          gamma_specs,
+			  Rcpp::NumericVector phi_specs,
+			  int fw_len,
+			  int n_burn,
+			  int n_samp,
+			  int chunk_days,
+			  std::string         scratch_dir,
+			  int engine,
+			  Rcpp::NumericVector pt_specs,
+			  Rcpp::NumericVector vb_specs) {
 
-	// check for user interrupt every `DSP_BAYES_N_INTER_CHECK` iterations
-	if ((s % DSP_BAYES_N_INTERRUPT_CHECK) == 0) Rcpp::checkUserInterrupt();
+    // initialize global variables in case the values were set elsewhere
+    g_record_status = false;
+    g_day_chunks.reset();
+    bool is_verbose = true;
+    const bool is_chunked = chunk_days > 0;
+
+    ModelFile file(model_file);
+    if (is_chunked) {
+	file.advise_sequential();
+    }
+    d2s = file.int_data("day_to_subj_idx");
+
+    // the design matrix
+    double* U = file.dbl_data("U");
+    const dsp_idx_t n_days = file.n_rows("U");
+
+    // pregnancy cycle information used when sampling W
+    Rcpp::IntegerMatrix w_day_blocks = file.block_mat("w_day_blocks");
+    Rcpp::IntegerMatrix subj_day_blocks = file.block_mat("subj_day_blocks");
+
+    // missing intercourse information
+    Rcpp::IntegerMatrix x_miss_cyc = file.block_mat("x_miss_cyc");
+    Rcpp::IntegerMatrix x_miss_day = file.block_mat("x_miss_day");
+
+    // missing covariate information.  The sections for the k-th variable with
+    // missing data are prefixed by "u_miss_info.k." (1-based).
+    Rcpp::IntegerVector u_miss_type(file.int_data("u_miss_type"),
+				    file.int_data("u_miss_type") + file.n_rows("u_miss_type"));
+    Rcpp::List u_miss_info(u_miss_type.size());
+    for (int k = 0; k < u_miss_type.size(); ++k) {
+
+	const std::string prefix = "u_miss_info." + std::to_string(k + 1) + ".";
+	const std::string probs_nm = prefix + "log_u_prior_probs";
+	const double* probs = file.dbl_data(probs_nm.c_str());
+
+	u_miss_info[k] = Rcpp::List::create(
+	    Rcpp::Named("var_info")          = file.named_int_vec((prefix + "var_info").c_str()),
+	    Rcpp::Named("log_u_prior_probs") = Rcpp::NumericVector(probs, probs + file.n_rows(probs_nm.c_str())),
+	    Rcpp::Named("var_block_list")    = file.block_mat((prefix + "var_block_list").c_str()));
+    }
+
+    check_sizes(n_days,
+		((double) file.n_rows("w_to_days_idx")) - 1,
+		subj_day_blocks.nrow(),
+		gamma_specs.size(),
+		n_samp);
+
+    // the cycle-level and subject-level columns are optional sections
+    const bool has_levels = file.has("day_to_cyc_idx");
+    std::unique_ptr<ULevels> levels(
+	has_levels ?
+	create_levels(file.dbl_data("u_cyc"),
+		      file.n_rows("u_cyc"),
+		      file.n_cols("u_cyc"),
+		      file.dbl_data("u_subj"),
+		      file.n_rows("u_subj"),
+		      file.n_cols("u_subj"),
+		      file.int_data("day_to_cyc_idx"),
+		      n_days) :
+	NULL);
+
+    // the fertile window day effects are similarly optional
+    std::unique_ptr<FwDays> fw(create_fw(file.has("fw_pos") ? file.int_data("fw_pos") : NULL,
+					 n_days));
+
+    // create data objects
+    WGen W(PregCyc::mat_to_arr(w_day_blocks),
+	   w_day_blocks.nrow(),
+	   file.int_data("w_to_days_idx"),
+	   file.n_rows("w_to_days_idx") - 1,
+	   file.int_data("w_cyc_to_subj_idx"),
+	   fw_len);
+    XiGen xi(DayBlock::mat_to_arr(subj_day_blocks), subj_day_blocks.nrow(), n_samp, is_verbose);
+    std::unique_ptr<UPatterns> patterns(create_patterns(U,
+							n_days,
+							gamma_specs,
+							u_miss_info,
+							levels.get(),
+							fw.get()));
+    CoefGen coefs(U, n_days, gamma_specs, n_samp, levels.get(), fw.get(), patterns.get(), true);
+    PhiGen phi(phi_specs, n_samp, is_verbose);
+    std::unique_ptr<UProdBeta> ubeta(is_chunked ?
+				     new UProdBeta(n_days, scratch_dir) :
+				     new UProdBeta(n_days));
+    XGen X(file.int_data("X"),
+	   file.n_rows("X"),
+	   XGen::XMissCyc::mat_to_arr(x_miss_cyc),
+	   x_miss_cyc.nrow(),
+	   XGen::XMissDay::mat_to_arr(x_miss_day),
+	   file.dbl_scalar("tau_cohort_sex_prob"),
+	   file.dbl_scalar("tau_sex_coef"));
+    UProdTau utau(file.dbl_data("utau"), file.n_rows("utau"), file.dbl_data("tau_u_coefs"));
+    UGen U_gen(U,
+	       n_days,
+	       u_miss_info,
+	       u_miss_type,
+	       file.int_data("cov_miss_w_idx"),
+	       file.int_data("cov_miss_x_idx"),
+	       is_verbose);
+
+    // register the day-specific arrays that are read by the sweeps over the
+    // days with the chunking
+    if (is_chunked) {
+	g_day_chunks.configure(xi.m_subj, xi.m_n_subj, chunk_days);
+	g_day_chunks.add_array(U, sizeof(double), file.n_cols("U"), n_days);
+	g_day_chunks.add_array(X.vals(), sizeof(int), 1, n_days);
+	g_day_chunks.add_array(d2s, sizeof(int), 1, n_days);
+	if (has_levels) {
+	    g_day_chunks.add_array(file.int_data("day_to_cyc_idx"), sizeof(int), 1, n_days);
+	}
+	if (fw) {
+	    g_day_chunks.add_array(fw->m_pos, sizeof(signed char), 1, n_days);
+	}
+	if (patterns) {
+	    g_day_chunks.add_array(patterns->m_day_pat, sizeof(int), 1, n_days);
+	}
+	g_day_chunks.add_array(ubeta->vals(), sizeof(dsp_store_t), 1, n_days);
+	g_day_chunks.add_array(ubeta->exp_vals(), sizeof(dsp_store_t), 1, n_days);
+	g_day_chunks.add_array(ubeta->exp_prop(), sizeof(dsp_store_t), 1, n_days);
+    }
+
+    std::unique_ptr<VarBayes> vb(create_vb(vb_specs,
+					   engine,
+					   W,
+					   xi,
+					   coefs,
+					   phi,
+					   *ubeta,
+					   X,
+					   U_gen,
+					   U,
+					   n_days,
+					   gamma_specs));
+    std::unique_ptr<TemperLadder> ladder(create_ladder(pt_specs,
+						       W,
+						       xi,
+						       coefs,
+						       phi,
+						       *ubeta,
+						       U,
+						       n_days,
+						       gamma_specs,
+						       phi_specs,
+						       n_samp));
+
+    if (engine != DSP_BAYES_ENGINE_VB) {
+	sample_chain(W, xi, coefs, phi, *ubeta, X, utau, U_gen, n_burn, n_samp, engine, ladder.get());
     }
+    Rcpp::List draws = collect_draws(coefs, xi, phi, vb.get(), engine, n_samp);
+    g_day_chunks.reset();
 
-    return Rcpp::List::create(Rcpp::Named("coefs") = coefs.m_vals_rcpp,
-			      Rcpp::Named("xi")    = xi.m_vals_rcpp,
-			      Rcpp::Named("phi")   = phi.m_vals_rcpp,
-			      Rcpp::Named("ugen")  = U.realized_samples());
+    return Rcpp::List::create(Rcpp::Named("coefs")      = draws["coefs"],
+			      Rcpp::Named("xi")         = draws["xi"],
+			      Rcpp::Named("phi")        = draws["phi"],
+			      Rcpp::Named("ugen")       = U_gen.realized_samples(),
+			      Rcpp::Named("coef_nms")   = file.char_vec("U_colnames"),
+			      Rcpp::Named("tuning")     = collect_tuning(coefs, phi, engine),
+			      Rcpp::Named("coefs_rb")   = draws["coefs_rb"],
+			      Rcpp::Named("xi_rb")      = draws["xi_rb"],
+			      Rcpp::Named("swap_rates") = ladder ? ladder->swap_rates() : Rcpp::NumericVector(0),
+			      Rcpp::Named("vb")         = draws["vb"]);
 }
@@ -0,0 +1,155 @@
+#include <cmath>
+#include "Rcpp.h"
+#include "DayChunks.h"
+#include "FwDays.h"
+#include "global_vars.h"
+
+// the largest number of positions that can be stored in a `signed char`
+#define FW_DAYS_MAX_N_POS 127
+
+
+// `fw_pos` provides the 0-based fertile window position of each day, or -1 for
+// the days without any of the effects
+
+FwDays::FwDays(const int* fw_pos, dsp_idx_t n_days) :
+    // initialization list
+    m_pos(new signed char[n_days]),
+    m_n_pos(calc_n_pos(fw_pos, n_days)),
+    m_n_days(n_days),
+    m_beta_vals(new double[m_n_pos]),
+    m_beta_new(new double[m_n_pos]),
+    m_w_sums(new double[m_n_pos]),
+    m_exp_sums(new double[m_n_pos])
+{
+    for (dsp_idx_t r = 0; r < m_n_days; ++r) {
+	m_pos[r] = (signed char) fw_pos[r];
+    }
+
+    // the coefficients start out at 0, in agreement with the initial values of
+    // `U * beta` in `UProdBeta`
+    for (int k = 0; k < m_n_pos; ++k) {
+	m_beta_vals[k] = 0.0;
+	m_beta_new[k] = 0.0;
+    }
+}
+
+
+
+
+FwDays::~FwDays() {
+    delete[] m_pos;
+    delete[] m_beta_vals;
+    delete[] m_beta_new;
+    delete[] m_w_sums;
+    delete[] m_exp_sums;
+}
+
+
+
+
+// the number of fertile window positions, i.e. one more than the largest
+// position
+
+int FwDays::calc_n_pos(const int* fw_pos, dsp_idx_t n_days) {
+
+    int max_pos = -1;
+    for (dsp_idx_t r = 0; r < n_days; ++r) {
+	if (fw_pos[r] > max_pos) {
+	    max_pos = fw_pos[r];
+	}
+    }
+
+    if (max_pos >= FW_DAYS_MAX_N_POS) {
+	Rcpp::stop("too many fertile window days");
+    }
+
+    return max_pos + 1;
+}
+
+
+
+
+// calculate the sufficient statistics for each position.  Note that `U * beta`
+// in `ubeta` includes the coefficients in `m_beta_vals`, so that the terms are
+// calculated from `exp(U * beta)` by dividing by the exponentiated coefficient
+// for the position.
+
+void FwDays::calc_stats(const WGen& W, const XiGen& xi, const UProdBeta& ubeta, const int* X) {
+
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    const double* xi_vals = xi.vals();
+    double inv_gam_vals[FW_DAYS_MAX_N_POS];
+
+    for (int k = 0; k < m_n_pos; ++k) {
+	m_w_sums[k] = 0.0;
+	m_exp_sums[k] = 0.0;
+	inv_gam_vals[k] = exp(-m_beta_vals[k]);
+    }
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+	    const int pos = m_pos[r];
+	    if ((pos >= 0) && X[r]) {
+		m_exp_sums[pos] += X[r] * xi_vals[ d2s[r] ] * ubeta_exp_vals[r] * inv_gam_vals[pos];
+	    }
+	}
+    }
+
+    // `W` is only nonzero for the days in a pregnancy cycle
+    const int* w_vals = W.vals();
+    const int* w_days_idx = W.days_idx();
+    for (dsp_idx_t t = 0; t < W.n_preg_days(); ++t) {
+	const int pos = m_pos[ w_days_idx[t] ];
+	if (pos >= 0) {
+	    m_w_sums[pos] += w_vals[t];
+	}
+    }
+}
+
+
+
+
+// apply the changes in the coefficients since the last call to the values of `U
+// * beta` and `exp(U * beta)` in `ubeta`.  `exp(U * beta)` is updated by
+// multiplying by the exponentiated differences, so that only one call to `exp`
+// is needed per position.
+
+void FwDays::apply(UProdBeta& ubeta) {
+
+    dsp_store_t* ubeta_vals = ubeta.vals();
+    dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    double gam_ratios[FW_DAYS_MAX_N_POS];
+
+    // `m_beta_new` temporarily holds the differences
+    bool is_changed = false;
+    for (int k = 0; k < m_n_pos; ++k) {
+	m_beta_new[k] -= m_beta_vals[k];
+	m_beta_vals[k] += m_beta_new[k];
+	gam_ratios[k] = exp(m_beta_new[k]);
+	is_changed = is_changed || (m_beta_new[k] != 0.0);
+    }
+
+    if (is_changed) {
+	for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	    g_day_chunks.prefetch(c + 1);
+	    const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	    for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+		const int pos = m_pos[r];
+		if (pos >= 0) {
+		    ubeta_vals[r] += m_beta_new[pos];
+		    ubeta_exp_vals[r] *= gam_ratios[pos];
+		}
+	    }
+	}
+    }
+
+    for (int k = 0; k < m_n_pos; ++k) {
+	m_beta_new[k] = m_beta_vals[k];
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef DSP_BAYES_SRC_FW_DAYS_H
+#define DSP_BAYES_SRC_FW_DAYS_H
+
+#include "IdxType.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+
+// the fertile window day effects, i.e. the day-specific probabilities of the
+// model.
+//
+// Rather than a set of 0/1 columns of the design matrix, with at most one of
+// the columns having a value of 1 for any given day, the effects are
+// represented by the position of each day in the fertile window.  The position
+// is stored as a small integer for each day, with a value of -1 for the days
+// that don't have any of the effects (e.g. the reference day).
+//
+// Since each day has at most one of the effects, the sufficient statistics for
+// the coefficient for the k-th position only depend on the days at the k-th
+// position, and are unaffected by the coefficients for the other positions.
+// Thus the statistics for all of the positions are calculated in a single sweep
+// over the days by `calc_stats`, after which all of the coefficients are
+// sampled, and the changes are then applied to `U * beta` in a single sweep by
+// `apply`.  This replaces the two sweeps per coefficient that are otherwise
+// needed.
+
+class FwDays {
+
+public:
+
+    // the fertile window position of each day, or -1
+    signed char* m_pos;
+
+    const int m_n_pos;
+    const dsp_idx_t m_n_days;
+
+    // the coefficients for each position as of the last call to `apply`, and
+    // the newly sampled coefficients
+    double* m_beta_vals;
+    double* m_beta_new;
+
+    // for each position, the sum of `W` over the days at the position, and the
+    // sum of `xi_i * exp(U * beta)` over the intercourse days at the position
+    // with the coefficient for the position removed from `U * beta`
+    double* m_w_sums;
+    double* m_exp_sums;
+
+    FwDays(const int* fw_pos, dsp_idx_t n_days);
+    ~FwDays();
+
+    void calc_stats(const WGen& W, const XiGen& xi, const UProdBeta& ubeta, const int* X);
+    void apply(UProdBeta& ubeta);
+
+    static int calc_n_pos(const int* fw_pos, dsp_idx_t n_days);
+};
+
+
+#endif
@@ -1,6 +1,8 @@
+#include <cmath>
 #include "Rcpp.h"
 
 // TODO: missing header files
+#include "DayChunks.h"
 #include "GammaGen.h"
 #include "global_vars.h"
 
@@ -10,12 +12,25 @@ using R::lgammafn_sign;
 
 
 GammaCateg::GammaCateg(const Rcpp::NumericMatrix& U, const Rcpp::NumericVector& gamma_specs) :
-    GammaGen(U, gamma_specs),
+    GammaCateg(U.begin(), U.nrow(), gamma_specs, NULL, NULL) {
+}
+
+
+
+
+GammaCateg::GammaCateg(const double* U,
+		       dsp_idx_t n_days,
+		       const Rcpp::NumericVector& gamma_specs,
+		       ULevels* levels,
+		       FwDays* fw,
+		       UCol::ParentCache* parent_cache) :
+    GammaGen(U, n_days, gamma_specs, levels, fw, parent_cache),
     m_bnd_l_is_zero(m_bnd_l == 0.0),
     m_bnd_u_is_inf(m_bnd_u == R_PosInf),
     m_is_trunc(!m_bnd_l_is_zero || !m_bnd_u_is_inf),
     m_incl_one(m_hyp_p != 0.0),
-    m_log_d2_const_terms(calc_log_d2_const_terms()) {
+    m_log_d2_const_terms(calc_log_d2_const_terms()),
+    m_cond_mean(m_gam_val) {
 }
 
 
@@ -28,8 +43,79 @@ double GammaCateg::sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, cons
 
     double a_tilde, b_tilde, p_tilde;
 
-    // calculate a_tilde
-    a_tilde = calc_a_tilde(W);
+    // case: a day-level column and the covariate patterns are in use, so
+    // a_tilde and b_tilde are given by the sums over the patterns that include
+    // the column (see UPatterns.h).  The change in `beta_h` is applied to
+    // `ubeta` by `UPatterns::apply`.
+    if (m_patterns) {
+
+	a_tilde = m_hyp_a + m_patterns->w_sum(m_pat_col);
+	b_tilde = m_hyp_b + m_patterns->exp_sum(m_pat_col) / m_gam_val;
+	p_tilde = m_incl_one ? calc_p_tilde(a_tilde, b_tilde) : 0;
+
+	const double beta_prev = m_beta_val;
+	const double gam_prev = m_gam_val;
+	m_gam_val = sample_gamma(a_tilde, b_tilde, p_tilde);
+	m_beta_val = log(m_gam_val);
+	m_patterns->update(m_pat_col, m_beta_val - beta_prev, m_gam_val / gam_prev);
+
+	return m_gam_val;
+    }
+
+    // case: a fertile window day effect, so a_tilde and b_tilde are given by
+    // the sums for the column's position (see FwDays.h).  The change in
+    // `beta_h` is applied to `ubeta` by `FwDays::apply`.
+    if (m_fw_pos >= 0) {
+
+	a_tilde = m_hyp_a + m_fw->m_w_sums[m_fw_pos];
+	b_tilde = m_hyp_b + m_fw->m_exp_sums[m_fw_pos];
+	p_tilde = m_incl_one ? calc_p_tilde(a_tilde, b_tilde) : 0;
+
+	m_gam_val = sample_gamma(a_tilde, b_tilde, p_tilde);
+	m_beta_val = log(m_gam_val);
+	m_fw->m_beta_new[m_fw_pos] = m_beta_val;
+
+	return m_gam_val;
+    }
+
+    // case: a cycle-level or subject-level column, so the calculations are
+    // performed using the cycle or subject sums (see ULevels.h)
+    if (m_level != U_LEVEL_DAY) {
+
+	a_tilde = calc_a_tilde_level();
+	b_tilde = calc_b_tilde_level(xi);
+	p_tilde = m_incl_one ? calc_p_tilde(a_tilde, b_tilde) : 0;
+
+	m_gam_val = sample_gamma(a_tilde, b_tilde, p_tilde);
+	m_beta_val = log(m_gam_val);
+
+	// update the cycle or subject terms of `U * beta`.  The changes are
+	// applied to `ubeta` by `ULevels::compose`.
+	double* level_vals = m_levels->vals(m_level);
+	const int n_units = m_levels->n_units(m_level);
+	for (int u = 0; u < n_units; ++u) {
+	    if (m_Uh[u]) {
+		level_vals[u] += m_beta_val;
+	    }
+	}
+
+	return m_gam_val;
+    }
+
+    // case: a day-level column
+    return sample_day(calc_a_tilde(W), xi, ubeta, X);
+}
+
+
+
+
+// sample a new value for gamma_h for a day-level column when the covariate
+// patterns aren't in use, where `a_tilde` has already been calculated (either
+// by `calc_a_tilde` or for several coefficients at once by `CoefBatch`)
+
+double GammaCateg::sample_day(double a_tilde, const XiGen& xi, UProdBeta& ubeta, const int* X) {
+
+    double b_tilde, p_tilde;
 
     // calculate b_tilde and p_tilde.  Note that `calc_b_tilde(ubeta)` has the
     // side-effect of changing the values of the data pointed to by `ubeta` to
@@ -42,9 +128,9 @@ double GammaCateg::sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, cons
     m_beta_val = log(m_gam_val);
 
     // change the values of the data pointed to by `ubeta` to take the values of
-    // `U * beta` using the newly sampled value of `gamma_h`
+    // `U * beta` and `exp(U * beta)` using the newly sampled value of `gamma_h`
     // TODO: check that gamma isn't 1 before calling
-    ubeta.add_uh_prod_beta_h(m_Uh, m_beta_val);
+    ubeta.add_uh_prod_beta_h(m_Uh, m_beta_val, m_gam_val);
 
     return m_gam_val;
 }
@@ -56,6 +142,11 @@ double GammaCateg::sample_gamma(double a_tilde, double b_tilde, double p_tilde)
 
     double unif_bnd_l, unif_bnd_u, unif_rv;
 
+    // the conditional expectation is only needed after the burn-in phase
+    if (! g_burn_status) {
+	m_cond_mean = calc_cond_mean(a_tilde, b_tilde, p_tilde);
+    }
+
     // case: with probability `p_tilde`, sample a value of 1
     if (R::unif_rand() < p_tilde) {
 	return 1;
@@ -94,6 +185,42 @@ double GammaCateg::sample_gamma(double a_tilde, double b_tilde, double p_tilde)
 
 
 
+// the expected value of the distribution sampled from by `sample_gamma`, given
+// by
+//
+//     p_tilde + (1 - p_tilde) * E(G)
+//
+// where `G` has a `Gamma(a_tilde, b_tilde)` distribution truncated to `(bnd_l,
+// bnd_u)`.  Using `x * G(x; a, b) = (a / b) * G(x; a + 1, b)`, the expected
+// value of `G` is
+//
+//     a_tilde   F(bnd_u; a_tilde + 1, b_tilde) - F(bnd_l; a_tilde + 1, b_tilde)
+//     ------- * ---------------------------------------------------------------
+//     b_tilde       F(bnd_u; a_tilde, b_tilde) - F(bnd_l; a_tilde, b_tilde)
+
+double GammaCateg::calc_cond_mean(double a_tilde, double b_tilde, double p_tilde) {
+
+    double gam_mean = a_tilde / b_tilde;
+
+    if (m_is_trunc) {
+	const double scale = 1.0 / b_tilde;
+	const double F_upp_1 = m_bnd_u_is_inf ? 1.0 : R::pgamma(m_bnd_u, a_tilde + 1, scale, 1, 0);
+	const double F_low_1 = m_bnd_l_is_zero ? 0.0 : R::pgamma(m_bnd_l, a_tilde + 1, scale, 1, 0);
+	const double trunc_prob = exp(log_dgamma_trunc_const(a_tilde, b_tilde));
+
+	// case: the probability of the interval underflows, in which case the
+	// mass is concentrated at the nearer bound
+	gam_mean = (trunc_prob > 0.0) ?
+	    gam_mean * (F_upp_1 - F_low_1) / trunc_prob :
+	    std::fmax(m_bnd_l, std::fmin(m_bnd_u, gam_mean));
+    }
+
+    return p_tilde + ((1 - p_tilde) * gam_mean);
+}
+
+
+
+
 // calculate the value of a_h tilde for fixed h, which is defined as:
 //
 //     a_h + sum_ijk u_ijkh * W_ijk
@@ -143,37 +270,98 @@ double GammaCateg::calc_a_tilde(const WGen& W) {
 // is equal to `U * beta - U_h * beta_h`, a fact that is used in the
 // calculations below.
 //
+// Since `exp(sum_{l != h} U_{ijkl} * beta_l)` is `exp(U * beta) / gamma_h` for
+// the days with `U_ijkh` equal to 1, the terms are calculated from the values of
+// `exp(U * beta)` without any calls to `exp`.
+//
 // Nota bene: this function has the side effect of changing the values of the
 // data pointed to by `U * beta` to instead have the values given by `U * beta -
-// U_h * beta_h`.
+// U_h * beta_h`, and similarly for `exp(U * beta)`.
 
 double GammaCateg::calc_b_tilde(UProdBeta& ubeta, const XiGen& xi, const int* X) {
 
-    double* ubeta_vals = ubeta.vals();
+    dsp_store_t* ubeta_vals = ubeta.vals();
+    dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
     const double* xi_vals = xi.vals();
+    const double inv_gam_val = 1.0 / m_gam_val;
 
     // initialize `sum_val` to take the first term in the expression
     double sum_val = m_hyp_b;
 
     // each iteration checks whether `r` corresponding to index ijk satisfies
     // the consitions of the outer sum, and if so, adds the value of the
-    // expression inside of the outer sum to the running total
-    for (int r = 0; r < m_n_days; ++r) {
+    // expression inside of the outer sum to the running total.  The days are
+    // processed a chunk at a time (see DayChunks.h).
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
 
 	// case: U_{ijkh} has a value of 1, so update the ijk-th element of
 	// `ubeta_vals` to have the value of the ijk-th element of `U*beta -
 	// U_h*beta_h`.  If U_{ijkh} has a value of 0 then no update is needed.
 	// TODO: check that gamma_h isn't 1
-	if (m_Uh[r]) {
+	m_Uh.for_each_nz(g_day_chunks.day_beg(c), chunk_end, [&](dsp_idx_t r, double) {
+
+		ubeta_vals[r] -= m_beta_val;
+		ubeta_exp_vals[r] *= inv_gam_val;
+
+		// case: the index ijk that `r` corresponds to is one of the
+		// terms included in the outer sum, so add the value of the
+		// expression to the running total
+		if (X[r]) {
+		    sum_val += X[r] * xi_vals[ d2s[r] ] * ubeta_exp_vals[r];
+		}
+	    });
+    }
 
-	    ubeta_vals[r] -= m_beta_val;
+    return sum_val;
+}
 
-	    // case: the index ijk that `r` corresponds to is one of the terms
-	    // included in the outer sum, so add the value of the expression to
-	    // the running total
-	    if (X[r]) {
-		sum_val += exp(log(xi_vals[ d2s[r] ]) + ubeta_vals[r]);
-	    }
+
+
+
+// the analogue of `calc_a_tilde` for a cycle-level or subject-level column,
+// where `sum_ijk u_ijkh * W_ijk` is calculated as the sum over the cycles or
+// subjects with `u_h` equal to 1 of the sum of `W` over the days in the cycle
+// or subject
+
+double GammaCateg::calc_a_tilde_level() {
+
+    const double* w_sums = m_levels->w_sums(m_level);
+    const int n_units = m_levels->n_units(m_level);
+
+    double sum_val = m_hyp_a;
+    for (int u = 0; u < n_units; ++u) {
+	if (m_Uh[u]) {
+	    sum_val += w_sums[u];
+	}
+    }
+
+    return sum_val;
+}
+
+
+
+
+// the analogue of `calc_b_tilde` for a cycle-level or subject-level column.
+// The sum over the intercourse days of the cycles or subjects with `u_h` equal
+// to 1 is calculated one cycle or subject at a time by `ULevels::unit_mean`.
+//
+// Nota bene: this function has the side effect of removing `beta_h` from the
+// cycle or subject terms of `U * beta`.
+
+double GammaCateg::calc_b_tilde_level(const XiGen& xi) {
+
+    double* level_vals = m_levels->vals(m_level);
+    const int n_units = m_levels->n_units(m_level);
+    const double* xi_vals = xi.vals();
+
+    double sum_val = m_hyp_b;
+    for (int u = 0; u < n_units; ++u) {
+	if (m_Uh[u]) {
+	    level_vals[u] -= m_beta_val;
+	    sum_val += m_levels->unit_mean(m_level, u, xi_vals);
 	}
     }
 
@@ -0,0 +1,273 @@
+#include <cmath>
+#include "Rcpp.h"
+
+#include "DayChunks.h"
+#include "GammaGen.h"
+#include "global_vars.h"
+#include "WGen.h"
+#include "XiGen.h"
+#include "UProdBeta.h"
+
+
+
+
+GammaContAux::GammaContAux(const Rcpp::NumericMatrix& U,
+			   const Rcpp::NumericVector& gamma_specs) :
+    GammaContAux(U.begin(), U.nrow(), gamma_specs, NULL, NULL) {
+}
+
+
+
+
+GammaContAux::GammaContAux(const double* U,
+			   dsp_idx_t n_days,
+			   const Rcpp::NumericVector& gamma_specs,
+			   ULevels* levels,
+			   FwDays* fw,
+			   UCol::ParentCache* parent_cache) :
+    GammaGen(U, n_days, gamma_specs, levels, fw, parent_cache),
+    m_log_norm_const(log_dgamma_trunc_norm_const()),
+    m_beta_l(R_NegInf),
+    m_beta_u(R_PosInf),
+    m_w_sum(0.0) {
+
+    if (m_fw_pos >= 0) {
+	Rcpp::stop("fertile window day coefficients can't use the auxiliary variable sampler");
+    }
+}
+
+
+
+
+// sample a new value for gamma_h.  As a side-effect, updates `ubeta` (or the
+// cycle or subject terms of `U * beta`), `m_beta_val`, and `m_gam_val` to
+// reflect the newly sampled value of gamma_h.
+
+double GammaContAux::sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X) {
+
+    // sample the auxiliary variables and calculate the interval for `beta_h`
+    // that they imply, and the sum of `W * U_h`
+    if (m_level == U_LEVEL_DAY) {
+	calc_stats(W, xi, ubeta, X);
+    }
+    else {
+	calc_stats_level(xi);
+    }
+
+    // the continuous part of the full conditional is a gamma distribution with
+    // shape `a_h + sum W * U_h`.  If this isn't positive, which is possible for
+    // a column with negative values, then `gamma_h^(sum W * U_h)` is also
+    // replaced by a constraint using one more auxiliary variable.
+    double shape = m_hyp_a + m_w_sum;
+    if (shape <= 0.0) {
+	m_beta_u = std::fmin(m_beta_u, m_beta_val - (R::exp_rand() / m_w_sum));
+	shape = m_hyp_a;
+    }
+
+    const double gam_l = std::fmax(exp(m_beta_l), m_bnd_l);
+    const double gam_u = std::fmin(exp(m_beta_u), m_bnd_u);
+
+    // the log of the probabilities, up to a common constant, of the point mass
+    // at 1 and of the continuous part
+    //
+    //     p_h * 1(beta_l < 0 < beta_u)
+    //
+    //     (1 - p_h) * norm_const * gammafn(shape) / b_h^shape * P(gam_l < G < gam_u)
+    //
+    // where `G` has a `Gamma(shape, b_h)` distribution
+    const double log_p_one = ((m_hyp_p > 0.0) && (m_beta_l < 0.0) && (0.0 < m_beta_u)) ?
+	log(m_hyp_p) :
+	R_NegInf;
+    const double log_p_cont = (gam_l < gam_u) ?
+	(log(1 - m_hyp_p)
+	 + m_log_norm_const
+	 + R::lgammafn_sign(shape, NULL)
+	 - (shape * log(m_hyp_b))
+	 + log_trunc_prob(shape, gam_l, gam_u)) :
+	R_NegInf;
+
+    // the probability of the point mass, calculated so as to avoid overflow
+    const double p_one = (log_p_one == R_NegInf) ?
+	0.0 :
+	1.0 / (1.0 + exp(log_p_cont - log_p_one));
+
+    const double beta_prev = m_beta_val;
+    if (R::unif_rand() < p_one) {
+	m_gam_val = 1.0;
+	m_beta_val = 0.0;
+    }
+    else {
+	m_gam_val = sample_gamma(shape, gam_l, gam_u);
+	m_beta_val = log(m_gam_val);
+    }
+
+    // update the terms of `U * beta`.  For a cycle-level or subject-level
+    // column the changes are applied to `ubeta` by `ULevels::compose`.
+    if (m_beta_val != beta_prev) {
+	if (m_level == U_LEVEL_DAY) {
+	    ubeta.update(m_Uh, m_beta_val, beta_prev);
+	}
+	else {
+	    double* level_vals = m_levels->vals(m_level);
+	    const int n_units = m_levels->n_units(m_level);
+	    const double beta_diff = m_beta_val - beta_prev;
+	    for (int u = 0; u < n_units; ++u) {
+		level_vals[u] += m_Uh[u] * beta_diff;
+	    }
+	}
+    }
+
+    return m_gam_val;
+}
+
+
+
+
+// sample the auxiliary variables for a day-level column and calculate the
+// interval for `beta_h` in a single sweep over the days with a nonzero value of
+// `U_h`, and the sum of `W * U_h` over the pregnancy days.  Note that `c_ijk *
+// gamma_h^U_ijkh` for the current value of gamma_h is `X_ijk * xi_i *
+// exp(u_ijk^T beta)`.
+
+void GammaContAux::calc_stats(const WGen& W, const XiGen& xi, const UProdBeta& ubeta, const int* X) {
+
+    const int* w_vals                 = W.vals();
+    const int* w_days_idx             = W.days_idx();
+    const double* xi_vals             = xi.vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+
+    m_beta_l = R_NegInf;
+    m_beta_u = R_PosInf;
+
+    // `W` is only nonzero for the days in a pregnancy cycle
+    m_w_sum = 0.0;
+    for (dsp_idx_t t = 0; t < W.n_preg_days(); ++t) {
+	m_w_sum += w_vals[t] * m_Uh[ w_days_idx[t] ];
+    }
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	m_Uh.for_each_nz(g_day_chunks.day_beg(c), chunk_end, [&](dsp_idx_t r, double u_hr) {
+		if (X[r]) {
+		    add_bnd(X[r] * xi_vals[ d2s[r] ] * ubeta_exp_vals[r], u_hr);
+		}
+	    });
+    }
+}
+
+
+
+
+// the analogue of `calc_stats` for a cycle-level or subject-level column, for
+// which the factors for the days in a cycle or subject combine into one factor
+// `exp(-c_u * gamma_h^U_uh)` (see `GammaContMH::get_w_log_lik_level`)
+
+void GammaContAux::calc_stats_level(const XiGen& xi) {
+
+    const double* w_sums = m_levels->w_sums(m_level);
+    const int n_units = m_levels->n_units(m_level);
+    const double* xi_vals = xi.vals();
+
+    m_beta_l = R_NegInf;
+    m_beta_u = R_PosInf;
+    m_w_sum = 0.0;
+
+    for (int u = 0; u < n_units; ++u) {
+
+	const double u_val = m_Uh[u];
+	if (! u_val) {
+	    continue;
+	}
+
+	m_w_sum += w_sums[u] * u_val;
+	const double c_val = m_levels->unit_mean(m_level, u, xi_vals);
+	if (c_val > 0.0) {
+	    add_bnd(c_val, u_val);
+	}
+    }
+}
+
+
+
+
+// sample the auxiliary variable for a factor `exp(-c * gamma_h^(u_val))` of the
+// full conditional, where `c_val` is the value of `c * gamma_h^(u_val)` for the
+// current value of gamma_h, and narrow the interval for `beta_h` accordingly.
+//
+// The auxiliary variable is uniform on `(0, exp(-c_val))`, so that its negative
+// log is `c_val + E` for `E` an exponential random variable, and the constraint
+// `c * gamma_h^(u_val) < c_val + E` is equivalent to
+//
+//     u_val * (beta_h - beta_h^(s)) < log(1 + E / c_val).
+
+inline void GammaContAux::add_bnd(double c_val, double u_val) {
+
+    const double bnd = m_beta_val + (log1p(R::exp_rand() / c_val) / u_val);
+    if (u_val > 0.0) {
+	m_beta_u = std::fmin(m_beta_u, bnd);
+    }
+    else {
+	m_beta_l = std::fmax(m_beta_l, bnd);
+    }
+}
+
+
+
+
+// sample from a `Gamma(shape, b_h)` distribution truncated to `(gam_l, gam_u)`
+// by inverting the CDF.  The upper tail probabilities are used when the
+// interval is in the upper tail of the distribution so that the probabilities
+// aren't rounded to 1.
+
+double GammaContAux::sample_gamma(double shape, double gam_l, double gam_u) const {
+
+    const double scale = 1.0 / m_hyp_b;
+    const int lower_tail = (R::pgamma(gam_l, shape, scale, 1, 0) < 0.5);
+
+    const double p_l = R::pgamma(gam_l, shape, scale, lower_tail, 0);
+    const double p_u = R::pgamma(gam_u, shape, scale, lower_tail, 0);
+    const double unif_rv = R::runif(std::fmin(p_l, p_u), std::fmax(p_l, p_u));
+    const double gam_val = R::qgamma(unif_rv, shape, scale, lower_tail, 0);
+
+    // guard against rounding error in the quantile function
+    return std::fmax(gam_l, std::fmin(gam_u, gam_val));
+}
+
+
+
+
+// the log of the probability that a `Gamma(shape, b_h)` random variable is in
+// `(gam_l, gam_u)`
+
+double GammaContAux::log_trunc_prob(double shape, double gam_l, double gam_u) const {
+
+    const double scale = 1.0 / m_hyp_b;
+    const int lower_tail = (R::pgamma(gam_l, shape, scale, 1, 0) < 0.5);
+
+    const double p_l = R::pgamma(gam_l, shape, scale, lower_tail, 0);
+    const double p_u = R::pgamma(gam_u, shape, scale, lower_tail, 0);
+
+    return log(std::fabs(p_u - p_l));
+}
+
+
+
+
+// calculates the log norming constant for a possibly truncated Gamma(a, b)
+// distribution (see `GammaContMH::log_dgamma_trunc_norm_const`)
+
+double GammaContAux::log_dgamma_trunc_norm_const() const {
+
+    const double F_upp = (m_bnd_u == R_PosInf) ?
+	1.0 :
+	R::pgamma(m_bnd_u, m_hyp_a, 1.0 / m_hyp_b, 1, 0);
+
+    const double F_low = (m_bnd_l == 0.0) ?
+	0.0 :
+	R::pgamma(m_bnd_l, m_hyp_a, 1.0 / m_hyp_b, 1, 0);
+
+    return (m_hyp_a * log(m_hyp_b)) - R::lgammafn_sign(m_hyp_a, NULL) - log(F_upp - F_low);
+}
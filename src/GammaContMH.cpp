@@ -1,10 +1,19 @@
+#include <cmath>
+#include <string>
+#include <vector>
 #include "Rcpp.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
+#include "DayChunks.h"
 #include "GammaGen.h"
 #include "global_vars.h"
 #include "ProposalFcns.h"
 #include "WGen.h"
 #include "XiGen.h"
+#include "XiMarg.h"
+#include "CycLik.h"
 #include "UProdBeta.h"
 
 
@@ -12,7 +21,19 @@
 
 GammaContMH::GammaContMH(const Rcpp::NumericMatrix& U,
 			 const Rcpp::NumericVector& gamma_specs) :
-    GammaGen(U, gamma_specs),
+    GammaContMH(U.begin(), U.nrow(), gamma_specs, NULL, NULL) {
+}
+
+
+
+
+GammaContMH::GammaContMH(const double* U,
+			 dsp_idx_t n_days,
+			 const Rcpp::NumericVector& gamma_specs,
+			 ULevels* levels,
+			 FwDays* fw,
+			 UCol::ParentCache* parent_cache) :
+    GammaGen(U, n_days, gamma_specs, levels, fw, parent_cache),
     m_log_norm_const(log_dgamma_trunc_norm_const()),
     m_log_p_over_1_minus_p(log(m_hyp_p / (1 - m_hyp_p))),
     m_log_1_minus_p_over_p(-m_log_p_over_1_minus_p),
@@ -21,6 +42,16 @@ GammaContMH::GammaContMH(const Rcpp::NumericMatrix& U,
     m_mh_log_1_minus_p(log(1 - m_mh_p)),
     m_mh_delta(gamma_specs["mh_delta"]),
     m_mh_accept_ctr(0),
+    m_mh_prop_ctr(0),
+    m_adapt(),
+    m_adapt_p((m_hyp_p > 0.0) && (m_mh_p > 0.0)),
+    m_n_try(get_n_try(gamma_specs)),
+    m_da_refresh((m_n_try > 1) ? 0 : get_da_refresh(gamma_specs)),
+    m_da_ctr(0),
+    m_da_w_sum(0.0),
+    m_da_exp_sum(0.0),
+    m_da_u_mean(0.0),
+    m_da_u_var(0.0),
     m_proposal_fcn(ProposalFcns::unif),
     m_log_proposal_den(ProposalFcns::log_den_unif) {
 }
@@ -31,23 +62,314 @@ GammaContMH::GammaContMH(const Rcpp::NumericMatrix& U,
 
 double GammaContMH::sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, const int* X) {
 
-    const double proposal_beta = sample_proposal_beta();
-    const double proposal_gam  = exp(proposal_beta);
+    double proposal_beta;
+    double log_r;
+    bool is_accept;
 
-    // calculate the log acceptance ratio
-    const double log_r = get_log_r(W, xi, ubeta, X, proposal_beta, proposal_gam);
+    // calculate the log acceptance ratio and accept proposal value `min(r,
+    // 1)-th` of the time, or perform the two stages of delayed acceptance, or
+    // select one of several proposals by multiple-try Metropolis
+    if (m_n_try > 1) {
+	is_accept = sample_accept_mtm(W, xi, ubeta, X, &proposal_beta, &log_r);
+    }
+    else {
+	proposal_beta = sample_proposal_beta();
+	const double proposal_gam = exp(proposal_beta);
+	if (m_da_refresh > 0) {
+	    is_accept = sample_accept_da(W, xi, ubeta, X, proposal_beta, proposal_gam, &log_r);
+	}
+	else {
+	    log_r = get_log_r(W, xi, ubeta, X, proposal_beta, proposal_gam);
+	    is_accept = (log_r >= 0) || (log(R::unif_rand()) < log_r);
+	}
+    }
 
-    // accept proposal value `min(r, 1)-th` of the time
-    if ((log_r >= 0) || (log(R::unif_rand()) < log_r)) {
+    if (is_accept) {
 
 	// update `U * beta` and `exp(U * beta)` based upon accepting the
-	// proposal value
-	ubeta.update(m_Uh, proposal_beta, m_beta_val);
+	// proposal value, where the values of `exp(U * beta)` under the proposal
+	// were saved by `get_w_log_lik` unless multiple-try Metropolis is in
+	// use.  For a cycle-level or subject-level column only the cycle or
+	// subject terms are updated, and the changes are applied to `ubeta` by
+	// `ULevels::compose`.  Similarly for a fertile window day effect, for
+	// which the changes are applied by `FwDays::apply`.
+	if (m_fw_pos >= 0) {
+	    m_fw->m_beta_new[m_fw_pos] = proposal_beta;
+	}
+	else if ((m_level == U_LEVEL_DAY) && (m_n_try > 1)) {
+	    ubeta.update(m_Uh, proposal_beta, m_beta_val);
+	}
+	else if (m_level == U_LEVEL_DAY) {
+	    ubeta.commit_prop(m_Uh, proposal_beta - m_beta_val);
+	}
+	else {
+	    double* level_vals = m_levels->vals(m_level);
+	    const int n_units = m_levels->n_units(m_level);
+	    const double beta_diff = proposal_beta - m_beta_val;
+	    for (int u = 0; u < n_units; ++u) {
+		level_vals[u] += m_Uh[u] * beta_diff;
+	    }
+	}
 
 	// update member variables to based upon accepting the proposal value
 	m_beta_val = proposal_beta;
+	m_gam_val = exp(proposal_beta);
+    }
+
+    // tune the proposal distribution during the burn-in phase, and otherwise
+    // track the acceptance rate
+    if (g_burn_status) {
+	adapt(log_r, proposal_beta);
+    }
+    else {
+	++m_mh_prop_ctr;
+	m_mh_accept_ctr += is_accept;
+    }
+
+    return m_gam_val;
+}
+
+
+
+
+// select one of `m_n_try` proposal values and decide whether to accept it by
+// multiple-try Metropolis.  With `T(x, y)` the density of the proposal
+// distribution (including the point mass at 0) and `pi` the full conditional
+// density of beta_h, the weight of moving to `y` from `x` is
+//
+//     w(y, x) = pi(y) * T(y, x).
+//
+// The proposals `y_1, ..., y_K` are sampled from `T(beta_h^(s), .)` and `y` is
+// selected with probability proportional to its weight.  Then the reference
+// values `x_1, ..., x_{K-1}` are sampled from `T(y, .)` and `x_K` is set to
+// `beta_h^(s)`, and `y` is accepted with probability
+//
+//     min{ 1, sum_j w(y_j, beta_h^(s)) / sum_j w(x_j, y) }.
+//
+// The likelihood ratios for the proposals are calculated in a single pass
+// over the days, and similarly for the reference values (see
+// `get_w_log_lik_multi`).  The weights are calculated relative to
+// `pi(beta_h^(s))`.
+
+bool GammaContMH::sample_accept_mtm(const WGen& W,
+				    const XiGen& xi,
+				    const UProdBeta& ubeta,
+				    const int* X,
+				    double* proposal_beta,
+				    double* log_r) {
+
+    double prop_vals[GAMMA_CONT_MH_MAX_N_TRY];
+    double prop_log_w[GAMMA_CONT_MH_MAX_N_TRY];
+    double ref_vals[GAMMA_CONT_MH_MAX_N_TRY];
+    double ref_log_w[GAMMA_CONT_MH_MAX_N_TRY];
+
+    // sample the proposals and calculate their log weights
+    for (int j = 0; j < m_n_try; ++j) {
+	prop_vals[j] = sample_proposal_beta();
+    }
+    get_w_log_lik_multi(W, xi, ubeta, X, prop_vals, m_n_try, prop_log_w);
+    double prop_max = R_NegInf;
+    for (int j = 0; j < m_n_try; ++j) {
+	prop_log_w[j] += (get_gam_log_lik(prop_vals[j], exp(prop_vals[j]))
+			  + log_trans_den(prop_vals[j], m_beta_val));
+	prop_max = std::fmax(prop_max, prop_log_w[j]);
+    }
+
+    // case: none of the proposals are able to move back to the current value
+    if (prop_max == R_NegInf) {
+	*proposal_beta = prop_vals[0];
+	*log_r = R_NegInf;
+	return false;
+    }
+
+    // select one of the proposals with probability proportional to its weight
+    double prop_sum = 0.0;
+    for (int j = 0; j < m_n_try; ++j) {
+	prop_sum += exp(prop_log_w[j] - prop_max);
+    }
+    double unif_rv = R::unif_rand() * prop_sum;
+    int sel = m_n_try - 1;
+    for (int j = 0; j < m_n_try - 1; ++j) {
+	unif_rv -= exp(prop_log_w[j] - prop_max);
+	if (unif_rv < 0.0) {
+	    sel = j;
+	    break;
+	}
+    }
+    const double sel_val = prop_vals[sel];
+
+    // sample the reference values and calculate their log weights.  The last
+    // reference value is the current value, for which the log likelihood ratio
+    // relative to the current value is 0.
+    for (int j = 0; j < m_n_try - 1; ++j) {
+	ref_vals[j] = (R::unif_rand() < m_mh_p) ?
+	    0.0 :
+	    m_proposal_fcn(sel_val, m_mh_delta);
+    }
+    get_w_log_lik_multi(W, xi, ubeta, X, ref_vals, m_n_try - 1, ref_log_w);
+    ref_vals[m_n_try - 1] = m_beta_val;
+    ref_log_w[m_n_try - 1] = 0.0;
+    double ref_max = R_NegInf;
+    for (int j = 0; j < m_n_try; ++j) {
+	ref_log_w[j] += (get_gam_log_lik(ref_vals[j], exp(ref_vals[j]))
+			 + log_trans_den(ref_vals[j], sel_val));
+	ref_max = std::fmax(ref_max, ref_log_w[j]);
+    }
+    double ref_sum = 0.0;
+    for (int j = 0; j < m_n_try; ++j) {
+	ref_sum += exp(ref_log_w[j] - ref_max);
+    }
+
+    *proposal_beta = sel_val;
+    *log_r = (prop_max + log(prop_sum)) - (ref_max + log(ref_sum));
+    return (*log_r >= 0) || (log(R::unif_rand()) < *log_r);
+}
+
+
+
+
+// calculate `log p(W | proposal_beta[j], xi) - log p(W | current_gam, xi)` for
+// each of the `n_prop` values in `proposal_beta`.  For a day-level column the
+// log-likelihood ratios are given by
+//
+//     w_sum * d_j - sum_ijk c_ijk * [exp(U_ijkh * d_j) - 1]
+//
+// where `w_sum` is the sum of `W * U_h`, `c_ijk` is `X_ijk * xi_i * exp(u_ijk^T
+// beta)`, and `d_j` is the difference between the j-th proposal and the
+// current value, so that all of them are calculated in a single pass over the
+// days.  The pass is split across threads when OpenMP is available, with each
+// thread accumulating its own sums over a fixed partition of the days.  The
+// sums are then added in the order of the threads, so that the results don't
+// depend on the scheduling of the threads and a run is reproducible for a
+// given seed and number of threads.
+
+void GammaContMH::get_w_log_lik_multi(const WGen& W,
+				      const XiGen& xi,
+				      const UProdBeta& ubeta,
+				      const int* X,
+				      const double* proposal_beta,
+				      int n_prop,
+				      double* w_log_lik) const {
+
+    if (m_fw_pos >= 0) {
+	for (int j = 0; j < n_prop; ++j) {
+	    w_log_lik[j] = get_w_log_lik_fw(proposal_beta[j]);
+	}
+	return;
+    }
+    else if (m_level != U_LEVEL_DAY) {
+	for (int j = 0; j < n_prop; ++j) {
+	    w_log_lik[j] = get_w_log_lik_level(xi, proposal_beta[j]);
+	}
+	return;
+    }
+
+    const int* w_vals                 = W.vals();
+    const int* w_days_idx             = W.days_idx();
+    const double* xi_vals             = xi.vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+
+    double beta_diffs[GAMMA_CONT_MH_MAX_N_TRY];
+    double exp_sums[GAMMA_CONT_MH_MAX_N_TRY];
+    for (int j = 0; j < n_prop; ++j) {
+	beta_diffs[j] = proposal_beta[j] - m_beta_val;
+	exp_sums[j] = 0.0;
+    }
+
+    // `W` is only nonzero for the days in a pregnancy cycle
+    double w_sum = 0.0;
+    for (dsp_idx_t t = 0; t < W.n_preg_days(); ++t) {
+	w_sum += w_vals[t] * m_Uh[ w_days_idx[t] ];
+    }
+
+    // the sums for the t-th thread are stored starting at `t *
+    // GAMMA_CONT_MH_MAX_N_TRY`
+#ifdef _OPENMP
+    const int n_threads = omp_get_max_threads();
+#else
+    const int n_threads = 1;
+#endif
+    std::vector<double> thread_sums((size_t) n_threads * GAMMA_CONT_MH_MAX_N_TRY, 0.0);
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_beg = g_day_chunks.day_beg(c);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(n_threads)
+#endif
+	{
+#ifdef _OPENMP
+	    double* curr_sums = thread_sums.data() + ((size_t) omp_get_thread_num() * GAMMA_CONT_MH_MAX_N_TRY);
+#else
+	    double* curr_sums = thread_sums.data();
+#endif
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+	    for (dsp_idx_t r = chunk_beg; r < chunk_end; ++r) {
+
+		const double u_hr = m_Uh[r];
+		if ((! u_hr) || (! X[r])) {
+		    continue;
+		}
+
+		const double c_val = X[r] * xi_vals[ d2s[r] ] * ubeta_exp_vals[r];
+		for (int j = 0; j < n_prop; ++j) {
+		    curr_sums[j] += c_val * expm1(u_hr * beta_diffs[j]);
+		}
+	    }
+	}
+    }
+
+    for (int t = 0; t < n_threads; ++t) {
+	const double* curr_sums = thread_sums.data() + ((size_t) t * GAMMA_CONT_MH_MAX_N_TRY);
+	for (int j = 0; j < n_prop; ++j) {
+	    exp_sums[j] += curr_sums[j];
+	}
+    }
+
+    for (int j = 0; j < n_prop; ++j) {
+	w_log_lik[j] = (w_sum * beta_diffs[j]) - exp_sums[j];
+    }
+}
+
+
+
+
+// sample a new value for gamma_h by a Metropolis-Hastings step on its full
+// conditional distribution with xi integrated out (see XiMarg.h), which is
+// only available for a day-level column other than a fertile window day
+// effect.  The proposal distribution and its adaptation are the same as for
+// `sample`.  As a side-effect, updates `ubeta` and the sums in `marg` to
+// reflect the newly sampled value of gamma_h.
+
+double GammaContMH::sample_marg(const WGen& W, XiMarg& marg, double phi_val, UProdBeta& ubeta, const int* X) {
+
+    const double proposal_beta = sample_proposal_beta();
+    const double proposal_gam = exp(proposal_beta);
+
+    const double log_r = (get_marg_log_lik(W, marg, phi_val, ubeta, X, proposal_beta)
+			  + get_gam_log_lik(proposal_beta, proposal_gam)
+			  + get_proposal_log_lik(proposal_beta));
+    const bool is_accept = (log_r >= 0) || (log(R::unif_rand()) < log_r);
+
+    if (is_accept) {
+	ubeta.commit_prop(m_Uh, proposal_beta - m_beta_val);
+	marg.commit();
+	m_beta_val = proposal_beta;
 	m_gam_val = proposal_gam;
-	++m_mh_accept_ctr;
+    }
+
+    if (g_burn_status) {
+	adapt(log_r, proposal_beta);
+    }
+    else {
+	++m_mh_prop_ctr;
+	m_mh_accept_ctr += is_accept;
     }
 
     return m_gam_val;
@@ -56,6 +378,455 @@ double GammaContMH::sample(const WGen& W, const XiGen& xi, UProdBeta& ubeta, con
 
 
 
+// calculate `log p(W | proposal_gam, phi) - log p(W | current_gam, phi)` with xi
+// integrated out, given by
+//
+//     w_sum * d - sum_i (phi + W_i) * log{ (phi + S_i + D_i) / (phi + S_i) }
+//
+// where `w_sum` is the sum of `W * U_h`, `d` is `beta_h* - beta_h^(s)`, and
+// `D_i` is the change in `S_i` under the proposal (see XiMarg.h).  The values of
+// `D_i` are accumulated in `marg` in a single sweep over the days, and as in
+// `get_w_log_lik` the values of `exp(U * beta)` under the proposal are written
+// to the scratch space in `ubeta`.
+
+double GammaContMH::get_marg_log_lik(const WGen& W,
+				     XiMarg& marg,
+				     double phi_val,
+				     UProdBeta& ubeta,
+				     const int* X,
+				     double proposal_beta) const {
+
+    const int* w_vals                 = W.vals();
+    const int* w_days_idx             = W.days_idx();
+    const dsp_store_t* ubeta_vals     = ubeta.vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    dsp_store_t* ubeta_exp_prop       = ubeta.exp_prop();
+    double* exp_diffs                 = marg.m_exp_diffs.data();
+
+    const double beta_diff = proposal_beta - m_beta_val;
+
+    // `W` is only nonzero for the days in a pregnancy cycle
+    double w_sum = 0.0;
+    for (dsp_idx_t t = 0; t < W.n_preg_days(); ++t) {
+	w_sum += w_vals[t] * m_Uh[ w_days_idx[t] ];
+    }
+
+    marg.reset_diffs();
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	m_Uh.for_each_nz(g_day_chunks.day_beg(c), chunk_end, [&](dsp_idx_t r, double u_hr) {
+		ubeta_exp_prop[r] = exp(ubeta_vals[r] + (u_hr * beta_diff));
+		if (X[r]) {
+		    exp_diffs[ d2s[r] ] += X[r] * (ubeta_exp_prop[r] - ubeta_exp_vals[r]);
+		}
+	    });
+    }
+
+    return (w_sum * beta_diff) + marg.log_lik_diff(phi_val);
+}
+
+
+
+
+// sample a new value for gamma_h by a Metropolis-Hastings step against the
+// likelihood of the pregnancy outcomes of the cycles with `W` integrated out
+// (see CycLik.h).  This is the analogue of `sample_marg` for the likelihood
+// engine, and as a side-effect updates `ubeta` and the sums in `lik` to reflect
+// the newly sampled value of gamma_h.  Any of the kinds of columns are
+// supported, i.e. day-level, cycle-level, and subject-level columns and the
+// fertile window day effects.
+
+double GammaContMH::sample_lik(CycLik& lik, const XiGen& xi, UProdBeta& ubeta, const int* X) {
+
+    const double proposal_beta = sample_proposal_beta();
+    const double proposal_gam = exp(proposal_beta);
+
+    const double log_r = (get_lik_log_lik(lik, xi, ubeta, X, proposal_beta)
+			  + get_gam_log_lik(proposal_beta, proposal_gam)
+			  + get_proposal_log_lik(proposal_beta));
+    const bool is_accept = (log_r >= 0) || (log(R::unif_rand()) < log_r);
+
+    if (is_accept) {
+	commit_lik(ubeta, proposal_beta);
+	lik.commit();
+	m_beta_val = proposal_beta;
+	m_gam_val = proposal_gam;
+    }
+
+    if (g_burn_status) {
+	adapt(log_r, proposal_beta);
+    }
+    else {
+	++m_mh_prop_ctr;
+	m_mh_accept_ctr += is_accept;
+    }
+
+    return m_gam_val;
+}
+
+
+
+
+// calculate the log-likelihood ratio of the proposal value of gamma_h for the
+// pregnancy outcomes of the cycles (see `CycLik::log_lik_diff`).  The changes in
+// `L_ij` and `A_i` are accumulated in `lik` in a single sweep over the days,
+// during which the pregnancy cycles are visited in the same order as the days,
+// and as in `get_w_log_lik` the values of `exp(U * beta)` under the proposal are
+// written to the scratch space in `ubeta`.  For a day-level column only the
+// days with a nonzero value of `U_h` are visited, while for the other kinds of
+// columns each of the days is visited and the value of `U_h` for the day is
+// obtained by `day_val`.
+
+double GammaContMH::get_lik_log_lik(CycLik& lik,
+				    const XiGen& xi,
+				    UProdBeta& ubeta,
+				    const int* X,
+				    double proposal_beta) const {
+
+    const PregCyc* preg_cyc           = lik.m_preg_cyc;
+    const int n_preg_cyc              = lik.m_n_preg_cyc;
+    const dsp_store_t* ubeta_vals     = ubeta.vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    dsp_store_t* ubeta_exp_prop       = ubeta.exp_prop();
+    double* cyc_diffs                 = lik.m_cyc_diffs.data();
+    double* subj_diffs                = lik.m_subj_diffs.data();
+
+    const double beta_diff = proposal_beta - m_beta_val;
+
+    // each call adds the change for day `r` to the sums for its pregnancy
+    // cycle or its subject, where `q` is the current pregnancy cycle
+    int q = 0;
+    auto add_day = [&](dsp_idx_t r, double u_hr) {
+
+	ubeta_exp_prop[r] = exp(ubeta_vals[r] + (u_hr * beta_diff));
+	if (! X[r]) {
+	    return;
+	}
+
+	while ((q < n_preg_cyc) && (r >= preg_cyc[q].beg_idx + preg_cyc[q].n_days)) {
+	    ++q;
+	}
+
+	const double exp_diff = X[r] * (ubeta_exp_prop[r] - ubeta_exp_vals[r]);
+	if ((q < n_preg_cyc) && (r >= preg_cyc[q].beg_idx)) {
+	    cyc_diffs[q] += exp_diff;
+	}
+	else {
+	    subj_diffs[ d2s[r] ] += exp_diff;
+	}
+    };
+
+    lik.reset_diffs();
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_beg = g_day_chunks.day_beg(c);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	if ((m_level == U_LEVEL_DAY) && (m_fw_pos < 0)) {
+	    m_Uh.for_each_nz(chunk_beg, chunk_end, add_day);
+	}
+	else {
+	    for (dsp_idx_t r = chunk_beg; r < chunk_end; ++r) {
+		const double u_hr = day_val(r);
+		if (u_hr != 0.0) {
+		    add_day(r, u_hr);
+		}
+	    }
+	}
+    }
+
+    return lik.log_lik_diff(xi.vals());
+}
+
+
+
+
+// update `U * beta` and `exp(U * beta)` upon accepting a proposal value of
+// beta_h for the likelihood engine, where the values of `exp(U * beta)` under
+// the proposal were saved by `get_lik_log_lik`.  For a cycle-level or
+// subject-level column or a fertile window day effect the changes are applied
+// directly to `ubeta` rather than through `ULevels::compose` or
+// `FwDays::apply`, which aren't used by the likelihood engine, and so the
+// cycle and subject terms in `ULevels` and the coefficients in `FwDays` aren't
+// kept up to date.  Thus the objects are only read by the likelihood engine,
+// and are able to be shared by the chains of a temperature ladder.
+
+void GammaContMH::commit_lik(UProdBeta& ubeta, double proposal_beta) {
+
+    const double beta_diff = proposal_beta - m_beta_val;
+
+    if ((m_level == U_LEVEL_DAY) && (m_fw_pos < 0)) {
+	ubeta.commit_prop(m_Uh, beta_diff);
+	return;
+    }
+
+    dsp_store_t* ubeta_vals     = ubeta.vals();
+    dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    const dsp_store_t* exp_prop = ubeta.exp_prop();
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+	    const double u_hr = day_val(r);
+	    if (u_hr != 0.0) {
+		ubeta_vals[r] += u_hr * beta_diff;
+		ubeta_exp_vals[r] = exp_prop[r];
+	    }
+	}
+    }
+}
+
+
+
+
+// the value of `U_h` for the `r`-th day.  For a cycle-level or subject-level
+// column this is the value for the cycle or subject of the day, and for a
+// fertile window day effect it is 1 for the days at the position of the effect
+// and 0 otherwise.
+
+inline double GammaContMH::day_val(dsp_idx_t r) const {
+
+    if (m_fw_pos >= 0) {
+	return (m_fw->m_pos[r] == m_fw_pos) ? 1.0 : 0.0;
+    }
+    else if (m_level == U_LEVEL_CYC) {
+	return m_Uh[ m_levels->m_d2c[r] ];
+    }
+    else if (m_level == U_LEVEL_SUBJ) {
+	return m_Uh[ d2s[r] ];
+    }
+
+    return m_Uh[r];
+}
+
+
+
+
+// the log density of the proposal distribution `T(from, to)`, which is the
+// point mass at 0 with probability `m_mh_p` and otherwise the continuous part
+// of the proposal distribution centered at `from`
+
+double GammaContMH::log_trans_den(double from, double to) const {
+
+    if (to == 0.0) {
+	return m_mh_log_p;
+    }
+
+    return (std::fabs(to - from) < m_mh_delta) ?
+	m_mh_log_1_minus_p + m_log_proposal_den(to, from, m_mh_delta) :
+	R_NegInf;
+}
+
+
+
+
+// decide whether to accept the proposal value by delayed acceptance.  In the
+// first stage the proposal is accepted with probability `min(1, r1)`, where
+// `r1` is the acceptance ratio with the likelihood replaced by a surrogate
+// (see `get_w_log_lik_surr`) that doesn't require a sweep over the days.  Only
+// if the proposal passes the first stage is the exact acceptance ratio `r`
+// calculated, and the proposal is then accepted with probability `min(1, r /
+// r1)`.  This satisfies detailed balance with respect to the exact target
+// distribution for any surrogate that doesn't depend on the current value of
+// beta_h, so that a poor surrogate only reduces the acceptance rate.  The sums
+// over all of the days used by the surrogate are calculated with the beta_h
+// term removed from `U * beta` (see `calc_surr_stats`), so that they may be
+// recalculated every `m_da_refresh` proposals throughout the sampler, including
+// after the burn-in phase, as the other terms of `U * beta` and `xi` change.
+// The sum of `W * U_h` only requires the days in the pregnancy cycles and is
+// calculated for each proposal.
+//
+// `log_r` is set to the log of the overall acceptance probability when the
+// second stage is reached, and otherwise to the log of the first stage ratio.
+
+bool GammaContMH::sample_accept_da(const WGen& W,
+				   const XiGen& xi,
+				   UProdBeta& ubeta,
+				   const int* X,
+				   double proposal_beta,
+				   double proposal_gam,
+				   double* log_r) {
+
+    if ((m_da_ctr % m_da_refresh) == 0) {
+	calc_surr_stats(xi, ubeta, X);
+    }
+    ++m_da_ctr;
+
+    const int* w_vals = W.vals();
+    const int* w_days_idx = W.days_idx();
+    m_da_w_sum = 0.0;
+    for (dsp_idx_t t = 0; t < W.n_preg_days(); ++t) {
+	m_da_w_sum += w_vals[t] * m_Uh[ w_days_idx[t] ];
+    }
+
+    // first stage
+    const double log_r1 = (get_w_log_lik_surr(proposal_beta)
+			   + get_gam_log_lik(proposal_beta, proposal_gam)
+			   + get_proposal_log_lik(proposal_beta));
+    *log_r = log_r1;
+    if ((log_r1 < 0) && (log(R::unif_rand()) >= log_r1)) {
+	return false;
+    }
+
+    // second stage
+    const double log_r2 = get_log_r(W, xi, ubeta, X, proposal_beta, proposal_gam) - log_r1;
+    *log_r = std::fmin(0.0, log_r1) + std::fmin(0.0, log_r2);
+    return (log_r2 >= 0) || (log(R::unif_rand()) < log_r2);
+}
+
+
+
+
+// calculate the sums over all of the days for the surrogate likelihood in a
+// single sweep over the days.  The weights are the values of `X * xi * exp(U *
+// beta)` with the beta_h term removed, i.e. evaluated at beta_h = 0, so that
+// the surrogate doesn't depend on the current value of beta_h.  See
+// `get_w_log_lik_surr`.
+
+void GammaContMH::calc_surr_stats(const XiGen& xi, const UProdBeta& ubeta, const int* X) {
+
+    const double* xi_vals             = xi.vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+
+    double exp_sum = 0.0;
+    double u_sum = 0.0;
+    double u_sq_sum = 0.0;
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	m_Uh.for_each_nz(g_day_chunks.day_beg(c), chunk_end, [&](dsp_idx_t r, double u_hr) {
+		if (X[r]) {
+		    const double exp_val = (X[r] * xi_vals[ d2s[r] ] * ubeta_exp_vals[r]
+					    * exp(-u_hr * m_beta_val));
+		    exp_sum += exp_val;
+		    u_sum += exp_val * u_hr;
+		    u_sq_sum += exp_val * u_hr * u_hr;
+		}
+	    });
+    }
+
+    m_da_exp_sum = exp_sum;
+    m_da_u_mean = (exp_sum > 0.0) ? (u_sum / exp_sum) : 0.0;
+    m_da_u_var = (exp_sum > 0.0) ?
+	std::fmax(0.0, (u_sq_sum / exp_sum) - (m_da_u_mean * m_da_u_mean)) :
+	0.0;
+}
+
+
+
+
+// the surrogate of `get_w_log_lik`.  With `c_ijk` the value of `X_ijk * xi_i *
+// exp(u_ijk^T beta - U_ijkh * beta_h)` when the surrogate was calculated, the
+// log-likelihood as a function of beta_h is, up to a constant,
+//
+//     sum W * U_h * beta_h - sum_ijk c_ijk * exp(U_ijkh * beta_h)
+//
+// The second sum is `exp_sum` times the moment generating function of `U_h`
+// under the weights `c_ijk`, which is approximated by `exp(u_mean * beta_h +
+// u_var * beta_h^2 / 2)`.  The approximation is exact for a 0/1 column, in
+// which case the surrogate only differs from the exact log-likelihood through
+// the changes in the other terms of `U * beta` and in `xi` since the sums were
+// calculated.
+
+double GammaContMH::get_w_log_lik_surr(double proposal_beta) const {
+
+    const double mgf_prop = exp((m_da_u_mean * proposal_beta)
+				+ (0.5 * m_da_u_var * proposal_beta * proposal_beta));
+    const double mgf_curr = exp((m_da_u_mean * m_beta_val)
+				+ (0.5 * m_da_u_var * m_beta_val * m_beta_val));
+
+    return (m_da_w_sum * (proposal_beta - m_beta_val)) - (m_da_exp_sum * (mgf_prop - mgf_curr));
+}
+
+
+
+
+// the number of proposals for each multiple-try Metropolis step, which is given
+// by `gamma_specs["n_try"]` or is 1 if there is no such entry
+
+int GammaContMH::get_n_try(const Rcpp::NumericVector& gamma_specs) {
+
+    const int n_try = gamma_specs.containsElementNamed("n_try") ?
+	(int) gamma_specs["n_try"] :
+	1;
+    if ((n_try < 1) || (n_try > GAMMA_CONT_MH_MAX_N_TRY)) {
+	Rcpp::stop("the number of multiple-try Metropolis proposals must be between 1 and "
+		   + std::to_string(GAMMA_CONT_MH_MAX_N_TRY));
+    }
+
+    return n_try;
+}
+
+
+
+
+// the number of proposals between recalculations of the surrogate for delayed
+// acceptance, which is given by `gamma_specs["da_refresh"]`.  Delayed
+// acceptance is only used for the day-level columns, since the likelihood for
+// the other columns is already calculated from sums.
+
+int GammaContMH::get_da_refresh(const Rcpp::NumericVector& gamma_specs) const {
+
+    if ((m_level != U_LEVEL_DAY) || (m_fw_pos >= 0) || (! gamma_specs.containsElementNamed("da_refresh"))) {
+	return 0;
+    }
+
+    const int da_refresh = gamma_specs["da_refresh"];
+    return (da_refresh > 0) ? da_refresh : 0;
+}
+
+
+
+
+// update the tuning parameters of the proposal distribution (see MhAdapt.h).
+// The step size `m_mh_delta` is only used by the continuous part of the
+// proposal distribution, so it is only updated after such a proposal.  The
+// probability `m_mh_p` of proposing `gamma_h = 1` tracks the proportion of the
+// scans for which `gamma_h` is 1, so that the point mass is proposed about as
+// often as the chain spends time there.
+
+void GammaContMH::adapt(double log_r, double proposal_beta) {
+
+    const double gain = m_adapt.next_gain();
+
+    if (proposal_beta != 0.0) {
+	m_mh_delta = MhAdapt::adapt_step(m_mh_delta, gain, log_r);
+    }
+
+    if (m_adapt_p) {
+	m_mh_p = MhAdapt::adapt_prob(m_mh_p, gain, (m_gam_val == 1.0) ? 1.0 : 0.0);
+	m_mh_log_p = log(m_mh_p);
+	m_mh_log_1_minus_p = log(1 - m_mh_p);
+    }
+}
+
+
+
+
+// the tuning parameters and the acceptance rate after the burn-in phase
+
+Rcpp::NumericVector GammaContMH::tuning() const {
+    return Rcpp::NumericVector::create(
+	Rcpp::Named("mh_delta")    = m_mh_delta,
+	Rcpp::Named("mh_p")        = m_mh_p,
+	Rcpp::Named("accept_rate") = (m_mh_prop_ctr > 0) ?
+	    ((double) m_mh_accept_ctr) / m_mh_prop_ctr :
+	    NA_REAL);
+}
+
+
+
+
 inline double GammaContMH::sample_proposal_beta() const {
 
     return (R::unif_rand() < m_mh_p) ?
@@ -78,12 +849,23 @@ inline double GammaContMH::sample_proposal_beta() const {
 
 inline double GammaContMH::get_log_r(const WGen& W,
 				     const XiGen& xi,
-				     const UProdBeta& ubeta,
+				     UProdBeta& ubeta,
 				     const int* X,
 				     double proposal_beta,
 				     double proposal_gam) {
 
-    return (get_w_log_lik(W, xi, ubeta, X, proposal_beta)
+    double w_log_lik;
+    if (m_fw_pos >= 0) {
+	w_log_lik = get_w_log_lik_fw(proposal_beta);
+    }
+    else if (m_level == U_LEVEL_DAY) {
+	w_log_lik = get_w_log_lik(W, xi, ubeta, X, proposal_beta);
+    }
+    else {
+	w_log_lik = get_w_log_lik_level(xi, proposal_beta);
+    }
+
+    return (w_log_lik
 	    + get_gam_log_lik(proposal_beta, proposal_gam)
 	    + get_proposal_log_lik(proposal_beta));
 }
@@ -91,71 +873,106 @@ inline double GammaContMH::get_log_r(const WGen& W,
 
 
 
-// calculate `p(W | proposal_gam, xi) / p(W | current_gam, xi)`
+// calculate `p(W | proposal_gam, xi) / p(W | current_gam, xi)`.
+//
+// As a side-effect, the values of `exp(U * beta)` under the proposal are
+// written to the scratch space in `ubeta` for the days with a nonzero value of
+// `U_h`, so that they are able to be reused by `UProdBeta::commit_prop` if the
+// proposal is accepted.
 
 double GammaContMH::get_w_log_lik(const WGen& W,
 				  const XiGen& xi,
-				  const UProdBeta& ubeta,
+				  UProdBeta& ubeta,
 				  const int* X,
 				  double proposal_beta) const {
 
-    const int* w_vals            = W.vals();
-    const int* w_days_idx        = W.days_idx();
-    const double* xi_vals        = xi.vals();
-    const double* ubeta_vals     = ubeta.vals();
-    const double* ubeta_exp_vals = ubeta.exp_vals();
+    const int* w_vals                 = W.vals();
+    const int* w_days_idx             = W.days_idx();
+    const double* xi_vals             = xi.vals();
+    const dsp_store_t* ubeta_vals     = ubeta.vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    dsp_store_t* ubeta_exp_prop       = ubeta.exp_prop();
 
     // the value of `beta_h* - beta_h^(s)`
     double beta_diff = proposal_beta - m_beta_val;
 
+    // calculate the sum over the days of
+    //
+    //           [xi_i * exp(u_{ijk}^T beta*)]^{w_{ijk}
+    //     log -----------------------------------------
+    //         [xi_i * exp(u_{ijk}^T beta^(s))]^{w_{ijk}
+    //
+    //         = w_{ijk} * u{ijkh} * (beta_h* - beta_h^(s))
+    //
+    // which are the first terms in `p(W | proposal) / p(W | current)`.  `W` is
+    // only nonzero for the days in a pregnancy cycle.
+    double w_sum = 0.0;
+    for (dsp_idx_t t = 0; t < W.n_preg_days(); ++t) {
+	w_sum += w_vals[t] * m_Uh[ w_days_idx[t] ];
+    }
+
     // tracks the running total of the log-likelihood
-    double sum_log_lik = 0;
+    double sum_log_lik = w_sum * beta_diff;
 
     // each iteration adds the i-th value of the loglikelihood to the running
-    // value of `sum_log_lik`
-    for (int i = 0; i < m_n_days; ++i) {
+    // value of `sum_log_lik`.  `exp(U * beta)` under the proposal only differs
+    // from the current value for the days with a nonzero value of `U_h`, so
+    // only these days are visited.  The days are processed a chunk at a time
+    // (see DayChunks.h).
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	m_Uh.for_each_nz(g_day_chunks.day_beg(c), chunk_end, [&](dsp_idx_t i, double u_hi) {
+
+		ubeta_exp_prop[i] = exp(ubeta_vals[i] + (u_hi * beta_diff));
+
+		// calculate `-X_ijk * xi_i * [exp(U * beta*) - exp(U * beta)]`,
+		// which is one of the terms in `p(W | proposal) / p(W |
+		// current)`.  If intercourse did not occur on this day then `W`
+		// is non-random and the term is 0.  `X_ijk` is larger than 1 for
+		// a day that represents several collapsed days.
+		if (X[i]) {
+		    sum_log_lik -= X[i] * xi_vals[ d2s[i] ] * (ubeta_exp_prop[i] - ubeta_exp_vals[i]);
+		}
+	    });
+    }
 
-	// if intercourse did not occur on this day then `W` is non-random and
-	// the log ratio is 0
-	if (! X[i]) {
-	    continue;
-	}
+    return sum_log_lik;
+}
 
-	double term1, term2;
-
-	// map the current day to the i-th subject to obtain `xi_i`
-	double xi_i = xi_vals[d2s[i]];
-
-	// calculate
-	//
-	//           [xi_i * exp(u_{ijk}^T beta*)]^{w_{ijk}
-	//     log -----------------------------------------
-	//         [xi_i * exp(u_{ijk}^T beta^(s))]^{w_{ijk}
-	//
-	//         = w_{ijk} * u{ijkh} * (beta_h* - beta_h^(s))
-	//
-	// which is one of the terms in `p(W | proposal) / p(W | current)`.
-	//
-	// IMPORTANT: note that `w_days_idx` has a sentinal value appended to
-	// the end of the data so that we need not worry about reading past the
-	// end of the array
-
-	if (*w_days_idx == i) {
-	    term1 = *w_vals * m_Uh[i] * beta_diff;
-	    ++w_vals;
-	    ++w_days_idx;
-	}
-	else {
-	    term1 = 0.0;
-	}
 
-	// calculate `-xi_i * [exp(U * beta*) - exp(U * beta)]`, which is one of
-	// the terms in `p(W | proposal) / p(W | current)`.
-	term2 = -xi_i * (exp(ubeta_vals[i] + (m_Uh[i] * beta_diff)) - ubeta_exp_vals[i]);
 
-	// add the portion of the log-likelihood from the current day to the
-	// running total
-	sum_log_lik += term1 + term2;
+
+// the analogue of `get_w_log_lik` for a cycle-level or subject-level column.
+// Since `u_ijkh` is constant over the days in a cycle or subject, the terms for
+// these days combine into
+//
+//     w_sum * u_h * (beta_h* - beta_h^(s))
+//         - [exp(u_h * (beta_h* - beta_h^(s))) - 1] * sum xi_i * exp(U * beta)
+//
+// where `w_sum` is the sum of `W` over the days and the second sum is over the
+// intercourse days (see `ULevels::unit_mean`).
+
+double GammaContMH::get_w_log_lik_level(const XiGen& xi, double proposal_beta) const {
+
+    const double* w_sums = m_levels->w_sums(m_level);
+    const int n_units = m_levels->n_units(m_level);
+    const double* xi_vals = xi.vals();
+
+    const double beta_diff = proposal_beta - m_beta_val;
+
+    double sum_log_lik = 0;
+    for (int u = 0; u < n_units; ++u) {
+
+	const double uh_diff = m_Uh[u] * beta_diff;
+	if (uh_diff == 0.0) {
+	    continue;
+	}
+
+	sum_log_lik += (w_sums[u] * uh_diff
+			- (exp(uh_diff) - 1) * m_levels->unit_mean(m_level, u, xi_vals));
     }
 
     return sum_log_lik;
@@ -164,6 +981,23 @@ double GammaContMH::get_w_log_lik(const WGen& W,
 
 
 
+// the analogue of `get_w_log_lik` for a fertile window day effect.  The terms
+// for the days at the column's position combine into
+//
+//     w_sum * (beta_h* - beta_h^(s))
+//         - [exp(beta_h*) - exp(beta_h^(s))] * sum xi_i * exp(U * beta - U_h * beta_h)
+//
+// where both sums are provided by `FwDays::calc_stats`.
+
+double GammaContMH::get_w_log_lik_fw(double proposal_beta) const {
+
+    return (m_fw->m_w_sums[m_fw_pos] * (proposal_beta - m_beta_val)
+	    - (exp(proposal_beta) - exp(m_beta_val)) * m_fw->m_exp_sums[m_fw_pos]);
+}
+
+
+
+
 // calculate  `p(gamma_h*) / p(gamma_h)` which is given by
 //
 //       /   1,                                            gamma_h* = 1,  gamma_h^(s) = 1
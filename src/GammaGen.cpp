@@ -1,10 +1,7 @@
+#include <string>
 #include "Rcpp.h"
 #include "GammaGen.h"
-
-#define GAMMA_GEN_TYPE_CATEG    0
-#define GAMMA_GEN_TYPE_CONT_MH  1
-// #define GAMMA_GEN_TYPE_CONT_ADAPT  2
-// #define GAMMA_GEN_TYPE_SMOOTH 3
+#include "global_vars.h"
 
 using Rcpp::NumericVector;
 using Rcpp::as;
@@ -14,6 +11,26 @@ using Rcpp::as;
 
 GammaGen::GammaGen(const Rcpp::NumericMatrix& U,
 		   const Rcpp::NumericVector& gamma_specs) :
+    GammaGen(U.begin(), U.nrow(), gamma_specs, NULL, NULL) {
+}
+
+
+
+
+// `U` points to the beginning of the design matrix, which is stored in
+// column-major order and has `n_days` rows.  If the column is a cycle-level or
+// subject-level column then `gamma_specs["level_h"]` is the index of the column
+// in the corresponding data in `levels`.  Similarly, if the column is one of
+// the fertile window day effects then `gamma_specs["fw_pos"]` is its position
+// in `fw`.  The parents of an interaction column are shared through
+// `parent_cache` (see `create_uh`).
+
+GammaGen::GammaGen(const double* U,
+		   dsp_idx_t n_days,
+		   const Rcpp::NumericVector& gamma_specs,
+		   ULevels* levels,
+		   FwDays* fw,
+		   UCol::ParentCache* parent_cache) :
     // initialization list
     m_beta_val(0),
     m_gam_val(1),
@@ -22,8 +39,27 @@ GammaGen::GammaGen(const Rcpp::NumericMatrix& U,
     m_hyp_p(gamma_specs["hyp_p"]),
     m_bnd_l(gamma_specs["bnd_l"]),
     m_bnd_u(gamma_specs["bnd_u"]),
-    m_Uh(U.begin() + ((int) gamma_specs["h"]) * U.nrow()),
-    m_n_days(U.nrow())  {
+    m_level(get_level(gamma_specs)),
+    m_levels(levels),
+    m_fw_pos(get_fw_pos(gamma_specs)),
+    m_fw(fw),
+    m_patterns(NULL),
+    m_pat_col(-1),
+    m_Uh(create_uh(U, n_days, gamma_specs, levels, fw, parent_cache)),
+    m_n_days(n_days)  {
+
+    if ((m_fw_pos >= 0) && ((fw == NULL) || (m_fw_pos >= fw->m_n_pos))) {
+	Rcpp::stop("fertile window day coefficient without fertile window data");
+    }
+}
+
+
+
+
+Rcpp::NumericVector GammaGen::tuning() const {
+    return Rcpp::NumericVector::create(Rcpp::Named("mh_delta")    = NA_REAL,
+				       Rcpp::Named("mh_p")        = NA_REAL,
+				       Rcpp::Named("accept_rate") = NA_REAL);
 }
 
 
@@ -31,6 +67,27 @@ GammaGen::GammaGen(const Rcpp::NumericMatrix& U,
 
 GammaGen** GammaGen::create_arr(const Rcpp::NumericMatrix& U,
 				const Rcpp::List& gamma_specs) {
+    return create_arr(U.begin(), U.nrow(), gamma_specs, NULL, NULL);
+}
+
+
+
+
+// the parents of the interaction columns are shared through `parent_cache`, or
+// if it is NULL then through a cache that is local to the call (see
+// `create_uh`)
+
+GammaGen** GammaGen::create_arr(const double* U,
+				dsp_idx_t n_days,
+				const Rcpp::List& gamma_specs,
+				ULevels* levels,
+				FwDays* fw,
+				UCol::ParentCache* parent_cache) {
+
+    UCol::ParentCache local_cache;
+    if (parent_cache == NULL) {
+	parent_cache = &local_cache;
+    }
 
     GammaGen** gamma = new GammaGen*[gamma_specs.size()];
 
@@ -43,14 +100,14 @@ GammaGen** GammaGen::create_arr(const Rcpp::NumericMatrix& U,
 	// `curr_gamma_specs`
 	switch((int) curr_gamma_specs["type"]) {
 	case GAMMA_GEN_TYPE_CATEG:
-	    gamma[t] = new GammaCateg(U, curr_gamma_specs);
+	    gamma[t] = new GammaCateg(U, n_days, curr_gamma_specs, levels, fw, parent_cache);
 	    break;
 	case GAMMA_GEN_TYPE_CONT_MH:
-	    gamma[t] = new GammaContMH(U, curr_gamma_specs);
+	    gamma[t] = new GammaContMH(U, n_days, curr_gamma_specs, levels, fw, parent_cache);
+	    break;
+	case GAMMA_GEN_TYPE_CONT_AUX:
+	    gamma[t] = new GammaContAux(U, n_days, curr_gamma_specs, levels, fw, parent_cache);
 	    break;
-	// case GAMMA_GEN_TYPE_CONT_ADAPT:
-	//     // ******************** TODO
-	//     break;
 	// case GAMMA_GEN_TYPE_SMOOTH:
 	//     // ******************** TODO
 	//     break;
@@ -59,3 +116,160 @@ GammaGen** GammaGen::create_arr(const Rcpp::NumericMatrix& U,
 
     return gamma;
 }
+
+
+
+
+// the data for U_h.  This is one of: the data for a cycle-level or
+// subject-level column in `levels`; an interaction column, for which
+// `gamma_specs["n_parents"]` is positive and the parents are as described for
+// `create_parent` (see UCol.h); a fertile window day effect, which isn't stored
+// in `U` and for which `gamma_specs["h"]` is -1 (see FwDays.h); or otherwise
+// the `h`-th column of `U`.  The columns of `U` are only the stored day-level
+// columns, so that `h` is not in general the index of the coefficient.  A
+// fertile window day effect has no data, since its samplers only use the sums
+// for its position.
+//
+// The parents of the interaction columns are recorded in `parent_cache` by the
+// index of the parent's coefficient, so that the list of the nonzero days of a
+// sparse parent is only calculated once and is then shared by each of the
+// interaction columns with that parent.  If `parent_cache` is NULL then the
+// parents aren't shared.
+
+UCol GammaGen::create_uh(const double* U,
+			 dsp_idx_t n_days,
+			 const Rcpp::NumericVector& gamma_specs,
+			 const ULevels* levels,
+			 const FwDays* fw,
+			 UCol::ParentCache* parent_cache) {
+
+    const int level = get_level(gamma_specs);
+    if (level != U_LEVEL_DAY) {
+	if (levels == NULL) {
+	    Rcpp::stop("cycle-level or subject-level coefficient without level data");
+	}
+	return UCol(levels->u_col(level, (int) gamma_specs["level_h"]));
+    }
+
+    const int n_parents = gamma_specs.containsElementNamed("n_parents") ?
+	(int) gamma_specs["n_parents"] :
+	0;
+    if (n_parents > U_COL_MAX_N_PARENTS) {
+	Rcpp::stop("too many parent columns for an interaction column");
+    }
+    else if (n_parents > 0) {
+	UCol::ParentCache local_cache;
+	if (parent_cache == NULL) {
+	    parent_cache = &local_cache;
+	}
+	UCol::Parent parents[U_COL_MAX_N_PARENTS];
+	for (int k = 0; k < n_parents; ++k) {
+	    const std::string parent_nm = "parent_" + std::to_string(k + 1);
+	    const int parent_j = gamma_specs[parent_nm];
+	    UCol::ParentCache::iterator it = parent_cache->find(parent_j);
+	    if (it == parent_cache->end()) {
+		UCol::Parent curr_parent = create_parent(U, n_days, gamma_specs, parent_nm, levels, fw);
+		it = parent_cache->insert(std::make_pair(parent_j, curr_parent)).first;
+	    }
+	    parents[k] = it->second;
+	}
+	return UCol(parents, n_parents);
+    }
+
+    const int h = gamma_specs["h"];
+    if (h < 0) {
+	if (get_fw_pos(gamma_specs) < 0) {
+	    Rcpp::stop("day-level coefficient without a column in the design matrix");
+	}
+	return UCol((const double*) NULL);
+    }
+
+    return UCol(U + h * n_days);
+}
+
+
+
+
+// the parent of an interaction column named by `parent_nm`, which is of the
+// form "parent_k".  `gamma_specs[parent_nm]` is the index of the parent's
+// coefficient, and the entries named by appending "_level", "_level_h",
+// "_fw_pos", and "_h" to `parent_nm` describe the parent's column in the same
+// way as the `level`, `level_h`, `fw_pos`, and `h` entries of the parent's own
+// specifications.  When these entries aren't present the parent is the
+// `gamma_specs[parent_nm]`-th column of `U`.
+//
+// A cycle-level or subject-level parent is evaluated from the data in `levels`
+// using the map from days to cycles in `levels` or the map from days to
+// subjects in `d2s`, and a fertile window parent is evaluated from the
+// positions in `fw`, so that neither is stored as a day-level column.
+
+UCol::Parent GammaGen::create_parent(const double* U,
+				     dsp_idx_t n_days,
+				     const Rcpp::NumericVector& gamma_specs,
+				     const std::string& parent_nm,
+				     const ULevels* levels,
+				     const FwDays* fw) {
+
+    const std::string level_nm = parent_nm + "_level";
+    const std::string fw_pos_nm = parent_nm + "_fw_pos";
+    const std::string h_nm = parent_nm + "_h";
+
+    const int level = gamma_specs.containsElementNamed(level_nm.c_str()) ?
+	(int) gamma_specs[level_nm] :
+	U_LEVEL_DAY;
+    const int fw_pos = gamma_specs.containsElementNamed(fw_pos_nm.c_str()) ?
+	(int) gamma_specs[fw_pos_nm] :
+	-1;
+
+    UCol::Parent parent;
+    if (level != U_LEVEL_DAY) {
+	if (levels == NULL) {
+	    Rcpp::stop("interaction column with a cycle-level or subject-level parent without level data");
+	}
+	parent.vals = levels->u_col(level, (int) gamma_specs[parent_nm + "_level_h"]);
+	parent.unit_idx = (level == U_LEVEL_CYC) ? levels->m_d2c : d2s;
+    }
+    else if (fw_pos >= 0) {
+	if ((fw == NULL) || (fw_pos >= fw->m_n_pos)) {
+	    Rcpp::stop("interaction column with a fertile window parent without fertile window data");
+	}
+	parent.fw_pos = fw->m_pos;
+	parent.fw_k = fw_pos;
+    }
+    else {
+	const int h = gamma_specs.containsElementNamed(h_nm.c_str()) ?
+	    (int) gamma_specs[h_nm] :
+	    (int) gamma_specs[parent_nm];
+	if (h < 0) {
+	    Rcpp::stop("interaction column with a parent without a column in the design matrix");
+	}
+	parent.vals = U + h * n_days;
+    }
+
+    parent.calc_nz_idx(n_days);
+    return parent;
+}
+
+
+
+
+// the level at which the column varies.  Specifications without a `level` entry
+// are for day-level columns.
+
+int GammaGen::get_level(const Rcpp::NumericVector& gamma_specs) {
+    return gamma_specs.containsElementNamed("level") ?
+	(int) gamma_specs["level"] :
+	U_LEVEL_DAY;
+}
+
+
+
+
+// the fertile window position of the column.  Specifications without an
+// `fw_pos` entry are for columns that are not fertile window day effects.
+
+int GammaGen::get_fw_pos(const Rcpp::NumericVector& gamma_specs) {
+    return gamma_specs.containsElementNamed("fw_pos") ?
+	(int) gamma_specs["fw_pos"] :
+	-1;
+}
@@ -1,11 +1,27 @@
 #ifndef DSP_BAYES_GAMMA_GEN_H_
 #define DSP_BAYES_GAMMA_GEN_H_
 
+#include <string>
 #include "Rcpp.h"
+#include "IdxType.h"
 #include "WGen.h"
 #include "XiGen.h"
+#include "XiMarg.h"
+#include "CycLik.h"
 #include "UProdBeta.h"
+#include "ULevels.h"
+#include "FwDays.h"
+#include "UCol.h"
+#include "UPatterns.h"
+#include "MhAdapt.h"
 
+#define GAMMA_GEN_TYPE_CATEG    0
+#define GAMMA_GEN_TYPE_CONT_MH  1
+#define GAMMA_GEN_TYPE_CONT_AUX 2
+
+// the largest number of proposals for a multiple-try Metropolis step
+#define GAMMA_CONT_MH_MAX_N_TRY 16
+// #define GAMMA_GEN_TYPE_SMOOTH 3
 
 
 
@@ -24,25 +40,86 @@ public:
     const double m_bnd_l;
     const double m_bnd_u;
 
-    // points to the beginning of the data for U_h
-    const double* m_Uh;
+    // the level at which U_h varies (see ULevels.h), and the cycle-level and
+    // subject-level data.  `m_levels` is NULL if all of the columns are
+    // day-level.
+    const int m_level;
+    ULevels* m_levels;
+
+    // the fertile window position of the column (see FwDays.h), or -1 if the
+    // column is not one of the fertile window day effects
+    const int m_fw_pos;
+    FwDays* m_fw;
+
+    // the covariate patterns of the day-level columns (see UPatterns.h) and
+    // the index of the column in the patterns, or NULL and -1 if the patterns
+    // aren't in use.  These are set by `CoefGen` after the object is created.
+    UPatterns* m_patterns;
+    int m_pat_col;
+
+    // the data for U_h.  For a cycle-level or subject-level column this is the
+    // data stored once per cycle or subject, and for an interaction column the
+    // values are evaluated from the parent columns (see UCol.h).
+    const UCol m_Uh;
 
     // number of observations in the data
-    const int m_n_days;
+    const dsp_idx_t m_n_days;
 
     GammaGen(const Rcpp::NumericMatrix& U, const Rcpp::NumericVector& coef_specs);
+    GammaGen(const double* U,
+	     dsp_idx_t n_days,
+	     const Rcpp::NumericVector& coef_specs,
+	     ULevels* levels,
+	     FwDays* fw,
+	     UCol::ParentCache* parent_cache = NULL);
     virtual ~GammaGen() {}
 
     // TODO: change this to XGen& X
     virtual double sample(const WGen& W, const XiGen& xi, UProdBeta& u_prod_beta, const int* X) = 0;
 
+    // the Metropolis-Hastings tuning parameters and acceptance rate, which are
+    // missing for the samplers that aren't Metropolis-Hastings steps
+    virtual Rcpp::NumericVector tuning() const;
+
+    // the expected value of gamma_h given the values of the other parameters
+    // at the last update, which is accumulated for the Rao-Blackwellized
+    // estimate of the posterior mean (see `CoefGen::rb_means`).  The samplers
+    // for which the conditional expectation isn't available in closed form
+    // use the sampled value.
+    virtual double cond_mean() const { return m_gam_val; }
+
+    void set_patterns(UPatterns* patterns, int pat_col) {
+	m_patterns = patterns;
+	m_pat_col = pat_col;
+    }
+
     static GammaGen** create_arr(const Rcpp::NumericMatrix& U, const Rcpp::List& gamma_specs);
+    static GammaGen** create_arr(const double* U,
+				 dsp_idx_t n_days,
+				 const Rcpp::List& gamma_specs,
+				 ULevels* levels,
+				 FwDays* fw,
+				 UCol::ParentCache* parent_cache = NULL);
+    static UCol create_uh(const double* U,
+			  dsp_idx_t n_days,
+			  const Rcpp::NumericVector& coef_specs,
+			  const ULevels* levels,
+			  const FwDays* fw,
+			  UCol::ParentCache* parent_cache);
+    static UCol::Parent create_parent(const double* U,
+				      dsp_idx_t n_days,
+				      const Rcpp::NumericVector& coef_specs,
+				      const std::string& parent_nm,
+				      const ULevels* levels,
+				      const FwDays* fw);
+    static int get_level(const Rcpp::NumericVector& coef_specs);
+    static int get_fw_pos(const Rcpp::NumericVector& coef_specs);
 };
 
 
 
 
-class GammaCateg : public GammaGen {
+class GammaCateg final : public GammaGen {
 
 public:
 
@@ -56,14 +133,30 @@ public:
     // `GammaCateg::calc_p_tilde`.
     const double m_log_d2_const_terms;
 
+    // the expected value of gamma_h given the values of the other parameters
+    // at the last update after the burn-in phase (see
+    // `GammaCateg::calc_cond_mean`)
+    double m_cond_mean;
+
 
     GammaCateg(const Rcpp::NumericMatrix& U, const Rcpp::NumericVector& gamma_specs);
+    GammaCateg(const double* U,
+	       dsp_idx_t n_days,
+	       const Rcpp::NumericVector& gamma_specs,
+	       ULevels* levels,
+	       FwDays* fw,
+	       UCol::ParentCache* parent_cache = NULL);
 
     double sample(const WGen& W, const XiGen& xi, UProdBeta& u_prod_beta, const int* X);
+    double sample_day(double a_tilde, const XiGen& xi, UProdBeta& u_prod_beta, const int* X);
     double calc_a_tilde(const WGen& W);
     double calc_b_tilde(UProdBeta& u_prod_beta, const XiGen& xi, const int* X);
+    double calc_a_tilde_level();
+    double calc_b_tilde_level(const XiGen& xi);
     double calc_p_tilde(double a_tilde, double b_tilde);
     double sample_gamma(double a_tilde, double b_tilde, double p_tilde);
+    double calc_cond_mean(double a_tilde, double b_tilde, double p_tilde);
+    double cond_mean() const { return m_cond_mean; }
     double log_dgamma_norm_const(double a, double b);
     double log_dgamma_trunc_const(double a, double b);
     double init_log_d2_const_terms();
@@ -73,20 +166,64 @@ public:
 
 
 
-/* class GammaContAux : public GammaGen { */
+// an exact Gibbs update of gamma_h for a continuous column using auxiliary
+// variables.
+//
+// The full conditional distribution of gamma_h is proportional to
+//
+//     p(gamma_h) * gamma_h^(sum_ijk W_ijk * U_ijkh) * prod_ijk exp(-c_ijk * gamma_h^U_ijkh)
+//
+// where `c_ijk` is `X_ijk * xi_i * exp(u_ijk^T beta - U_ijkh * beta_h)`, which is
+// only a gamma distribution when `U_h` is a 0/1 column.  For each day with a
+// nonzero value of `X_ijk * U_ijkh` we introduce an auxiliary variable with
+// a uniform distribution on `(0, exp(-c_ijk * gamma_h^U_ijkh))`.  Given the
+// auxiliary variables the factors of the product are replaced by the
+// constraints `c_ijk * gamma_h^U_ijkh < e_ijk`, which restrict `beta_h` to an
+// interval, so that gamma_h has a mixture of the point mass at 1 and a gamma
+// distribution truncated to the interval as its distribution.  Both the
+// auxiliary variables and gamma_h are sampled exactly, so that there are no
+// rejections, and the interval and the sum of `W * U_h` are calculated in one
+// sweep over the days.
+//
+// For a cycle-level or subject-level column the same holds with one auxiliary
+// variable per cycle or subject (see ULevels.h).  Fertile window day effects
+// are 0/1 columns, and should use `GammaCateg` instead.
+
+class GammaContAux final : public GammaGen {
 
-/* public: */
+public:
 
-/*     // // whether M == 1 (i.e no effect in the model) */
-/*     // bool M_is_one; */
+    // log of the norming constant of the possibly truncated gamma part of the
+    // prior (see `GammaContMH::log_dgamma_trunc_norm_const`)
+    const double m_log_norm_const;
 
+    // the interval for `beta_h` implied by the auxiliary variables, and the
+    // sum of `W * U_h`, which are calculated by `calc_stats`
+    double m_beta_l;
+    double m_beta_u;
+    double m_w_sum;
 
-/* }; */
+    GammaContAux(const Rcpp::NumericMatrix& U, const Rcpp::NumericVector& gamma_specs);
+    GammaContAux(const double* U,
+		 dsp_idx_t n_days,
+		 const Rcpp::NumericVector& gamma_specs,
+		 ULevels* levels,
+		 FwDays* fw,
+		 UCol::ParentCache* parent_cache = NULL);
 
+    double sample(const WGen& W, const XiGen& xi, UProdBeta& u_prod_beta, const int* X);
+    void calc_stats(const WGen& W, const XiGen& xi, const UProdBeta& ubeta, const int* X);
+    void calc_stats_level(const XiGen& xi);
+    void add_bnd(double c_val, double u_val);
+    double sample_gamma(double shape, double gam_l, double gam_u) const;
+    double log_trunc_prob(double shape, double gam_l, double gam_u) const;
+    double log_dgamma_trunc_norm_const() const;
+};
 
 
 
-class GammaContMH : public GammaGen {
+
+class GammaContMH final : public GammaGen {
 
 public:
 
@@ -114,11 +251,44 @@ public:
     //
     //   m_mh_accept_ctr: number of times the proposal value was accepted
     //
-    const double m_mh_p;
-    const double m_mh_log_p;
-    const double m_mh_log_1_minus_p;
-    const double m_mh_delta;
+    //   m_mh_prop_ctr: number of proposals
+    //
+    // The tuning parameters are adapted during the burn-in phase (see
+    // MhAdapt.h), and the counters only include the scans after the burn-in
+    // phase.
+    double m_mh_p;
+    double m_mh_log_p;
+    double m_mh_log_1_minus_p;
+    double m_mh_delta;
     int m_mh_accept_ctr;
+    int m_mh_prop_ctr;
+    MhAdapt m_adapt;
+    const bool m_adapt_p;
+
+    // the number of proposals for each multiple-try Metropolis step (see
+    // `GammaContMH::sample_accept_mtm`), or 1 for the usual Metropolis-Hastings
+    // step
+    const int m_n_try;
+
+    // delayed acceptance variables (see `GammaContMH::sample_accept_da`).
+    // Delayed acceptance isn't used together with multiple-try Metropolis.
+    //
+    //   m_da_refresh:  the number of proposals between recalculations of the
+    //     surrogate, or 0 if delayed acceptance isn't in use
+    //
+    //   m_da_ctr:  the number of proposals so far
+    //
+    //   m_da_w_sum:  the sum of `W * U_h` for the current proposal
+    //
+    //   m_da_exp_sum, m_da_u_mean, m_da_u_var:  the sum of `X * xi *
+    //     exp(U * beta - U_h * beta_h)` over the days with nonzero `U_h`, and
+    //     the mean and variance of `U_h` weighted by the terms of the sum
+    const int m_da_refresh;
+    int m_da_ctr;
+    double m_da_w_sum;
+    double m_da_exp_sum;
+    double m_da_u_mean;
+    double m_da_u_var;
 
     // the continuous part of the proposal distribution and the corresponding
     // density function
@@ -126,22 +296,72 @@ public:
     double (*m_log_proposal_den)(double val, double cond, double delta);
 
     GammaContMH(const Rcpp::NumericMatrix& U, const Rcpp::NumericVector& gamma_specs);
+    GammaContMH(const double* U,
+		dsp_idx_t n_days,
+		const Rcpp::NumericVector& gamma_specs,
+		ULevels* levels,
+		FwDays* fw,
+		UCol::ParentCache* parent_cache = NULL);
     double sample(const WGen& W, const XiGen& xi, UProdBeta& u_prod_beta, const int* X);
     double sample_proposal_beta() const;
     double get_log_r(const WGen& W,
 		     const XiGen& xi,
-		     const UProdBeta& ubeta,
+		     UProdBeta& ubeta,
 		     const int* X,
 		     double proposal_beta,
 		     double proposal_gam);
     double get_w_log_lik(const WGen& W,
 			 const XiGen& xi,
-			 const UProdBeta& ubeta,
+			 UProdBeta& ubeta,
 			 const int* X,
 			 double proposal_beta) const;
+    bool sample_accept_da(const WGen& W,
+			  const XiGen& xi,
+			  UProdBeta& ubeta,
+			  const int* X,
+			  double proposal_beta,
+			  double proposal_gam,
+			  double* log_r);
+    void calc_surr_stats(const XiGen& xi, const UProdBeta& ubeta, const int* X);
+    bool sample_accept_mtm(const WGen& W,
+			   const XiGen& xi,
+			   const UProdBeta& ubeta,
+			   const int* X,
+			   double* proposal_beta,
+			   double* log_r);
+    void get_w_log_lik_multi(const WGen& W,
+			     const XiGen& xi,
+			     const UProdBeta& ubeta,
+			     const int* X,
+			     const double* proposal_beta,
+			     int n_prop,
+			     double* w_log_lik) const;
+    double log_trans_den(double from, double to) const;
+    double sample_marg(const WGen& W, XiMarg& marg, double phi_val, UProdBeta& ubeta, const int* X);
+    double get_marg_log_lik(const WGen& W,
+			    XiMarg& marg,
+			    double phi_val,
+			    UProdBeta& ubeta,
+			    const int* X,
+			    double proposal_beta) const;
+    double sample_lik(CycLik& lik, const XiGen& xi, UProdBeta& ubeta, const int* X);
+    double get_lik_log_lik(CycLik& lik,
+			   const XiGen& xi,
+			   UProdBeta& ubeta,
+			   const int* X,
+			   double proposal_beta) const;
+    void commit_lik(UProdBeta& ubeta, double proposal_beta);
+    double day_val(dsp_idx_t r) const;
+    double get_w_log_lik_surr(double proposal_beta) const;
+    double get_w_log_lik_level(const XiGen& xi, double proposal_beta) const;
+    double get_w_log_lik_fw(double proposal_beta) const;
     double get_gam_log_lik(double proposal_beta, double proposal_gam) const;
     double get_proposal_log_lik(double proposal_beta) const;
     double log_dgamma_trunc_norm_const() const;
+    int get_da_refresh(const Rcpp::NumericVector& gamma_specs) const;
+    static int get_n_try(const Rcpp::NumericVector& gamma_specs);
+    void adapt(double log_r, double proposal_beta);
+    Rcpp::NumericVector tuning() const;
 };
 
 
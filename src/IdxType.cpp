@@ -0,0 +1,31 @@
+#include <limits>
+#include <string>
+#include "Rcpp.h"
+#include "IdxType.h"
+
+
+
+
+void check_idx_size(double n_elem, const char* what) {
+
+    const double idx_max = std::numeric_limits<dsp_idx_t>::max();
+    const double r_max = R_XLEN_T_MAX;
+
+    if ((n_elem > idx_max) || (n_elem > r_max)) {
+	Rcpp::stop(std::string("the number of elements in ") + what
+		   + " exceeds the largest supported size");
+    }
+}
+
+
+
+
+void check_int_size(double n_elem, const char* what) {
+
+    const double int_max = std::numeric_limits<int>::max();
+
+    if (n_elem > int_max) {
+	Rcpp::stop(std::string("the number of ") + what
+		   + " exceeds the largest supported size");
+    }
+}
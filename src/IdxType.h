@@ -0,0 +1,40 @@
+#ifndef DSP_BAYES_SRC_IDX_TYPE_H
+#define DSP_BAYES_SRC_IDX_TYPE_H
+
+#include <stdint.h>
+
+
+// the type used for indices into and sizes of the day-specific data, and for
+// offsets into the buffers used to record the samples.  Products such as
+// `n_days * n_gamma` and `n_subj * n_samp` can exceed the range of a 32-bit
+// `int` for large pooled analyses, so by default this is a 64-bit type.  The
+// 32-bit type can be selected by defining `DSP_BAYES_IDX_32` at compile-time
+// (e.g. through `PKG_CPPFLAGS` in Makevars), in which case the checks performed
+// by `check_idx_size` are made against the smaller range.
+//
+// Note that the index arrays provided by R (e.g. `d2s` and `w_to_days_idx`)
+// are R integer vectors and so their elements remain 32-bit `int`s.
+
+#ifdef DSP_BAYES_IDX_32
+typedef int32_t dsp_idx_t;
+#else
+typedef int64_t dsp_idx_t;
+#endif
+
+
+// throws an error if `n_elem` elements cannot be indexed using `dsp_idx_t`, or
+// if they can't be stored in an R vector.  `what` is used in the error message.
+// The calculations are done in double precision so that the product of sizes
+// can be checked before it has had a chance to overflow.
+
+void check_idx_size(double n_elem, const char* what);
+
+// throws an error if `n_elem` exceeds the range of an `int`, which is needed
+// for the quantities that are used as the values of the R integer index
+// vectors (e.g. the number of days, which are the values of `w_to_days_idx`)
+// or that are their lengths.  `what` is used in the error message.
+
+void check_int_size(double n_elem, const char* what);
+
+
+#endif
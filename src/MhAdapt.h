@@ -0,0 +1,68 @@
+#ifndef DSP_BAYES_SRC_MH_ADAPT_H
+#define DSP_BAYES_SRC_MH_ADAPT_H
+
+#include <cmath>
+
+// the target acceptance rate for a one-dimensional random walk proposal
+#define MH_ADAPT_TARGET 0.44
+
+// the target acceptance rate for a Metropolis-adjusted Langevin proposal
+#define MH_ADAPT_TARGET_MALA 0.574
+
+// the gain for the n-th update is `n^(-MH_ADAPT_DECAY)`.  Any value in (0.5, 1]
+// gives a Robbins-Monro sequence.
+#define MH_ADAPT_DECAY 0.6
+
+// bounds on the log of a step size and on a proposal probability, so that a
+// poorly-behaved burn-in can't leave a degenerate proposal
+#define MH_ADAPT_LOG_STEP_MIN -10.0
+#define MH_ADAPT_LOG_STEP_MAX 5.0
+#define MH_ADAPT_PROB_MIN 0.05
+#define MH_ADAPT_PROB_MAX 0.95
+
+
+// Robbins-Monro adaptation of the tuning parameters of a Metropolis-Hastings
+// step.  Each call to `next_gain` is made once per scan during the burn-in
+// phase, and the tuning parameters are then moved towards their targets with
+// the returned gain.  Since the gains decrease to 0 the tuning parameters
+// settle down, and they are frozen once the burn-in phase is over so that the
+// recorded samples are from a fixed Markov chain.
+//
+// A step size is adapted on the log scale towards a given acceptance rate,
+// using the acceptance probability `min(1, r)` of each proposal rather than
+// whether the proposal was accepted, which reduces the noise in the updates.
+
+class MhAdapt {
+
+public:
+
+    int m_n_iter;
+
+    MhAdapt() : m_n_iter(0) {}
+
+    double next_gain() {
+	++m_n_iter;
+	return std::pow((double) m_n_iter, -MH_ADAPT_DECAY);
+    }
+
+    static double accept_prob(double log_r) {
+	return (log_r >= 0.0) ? 1.0 : std::exp(log_r);
+    }
+
+    // the step size after a proposal with log acceptance ratio `log_r`
+    static double adapt_step(double step, double gain, double log_r, double target = MH_ADAPT_TARGET) {
+	double log_step = std::log(step) + gain * (accept_prob(log_r) - target);
+	log_step = std::fmax(MH_ADAPT_LOG_STEP_MIN, std::fmin(MH_ADAPT_LOG_STEP_MAX, log_step));
+	return std::exp(log_step);
+    }
+
+    // the probability after moving it towards `target_val`, where the average
+    // of `target_val` over the updates is the value to be tracked
+    static double adapt_prob(double prob, double gain, double target_val) {
+	prob += gain * (target_val - prob);
+	return std::fmax(MH_ADAPT_PROB_MIN, std::fmin(MH_ADAPT_PROB_MAX, prob));
+    }
+};
+
+
+#endif
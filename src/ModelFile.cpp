@@ -0,0 +1,351 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Rcpp.h"
+#include "ModelFile.h"
+
+#define MODEL_FILE_MAGIC  "DSPBAYES"
+#define MODEL_FILE_HEADER_SIZE  16
+
+
+
+
+// map the file at `path` into memory and check that the header and section
+// table are consistent with the size of the file
+
+ModelFile::ModelFile(const std::string& path) :
+    m_data(0),
+    m_size(0),
+    m_sections(0),
+    m_n_sections(0)
+{
+#ifdef _WIN32
+    Rcpp::stop("model files are not supported on Windows");
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+	Rcpp::stop("unable to open model file " + path);
+    }
+
+    struct stat file_stat;
+    if ((fstat(fd, &file_stat) != 0) || (file_stat.st_size < MODEL_FILE_HEADER_SIZE)) {
+	close(fd);
+	Rcpp::stop("invalid model file " + path);
+    }
+    m_size = file_stat.st_size;
+
+    // a private writable mapping so that the sampler can update the missing
+    // values in place without changing the file
+    void* addr = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+	Rcpp::stop("unable to map model file " + path);
+    }
+    m_data = static_cast<char*>(addr);
+
+    // check the header.  Note that a file written on a machine with a different
+    // byte order fails the version check.
+    int32_t version, n_sections;
+    std::memcpy(&version, m_data + 8, sizeof(int32_t));
+    std::memcpy(&n_sections, m_data + 12, sizeof(int32_t));
+
+    if (std::memcmp(m_data, MODEL_FILE_MAGIC, 8) != 0) {
+	munmap(m_data, m_size);
+	Rcpp::stop(path + " is not a dspBayes model file");
+    }
+    if (version != MODEL_FILE_VERSION) {
+	munmap(m_data, m_size);
+	Rcpp::stop(path + " has an unsupported model file version");
+    }
+    if ((n_sections < 0) ||
+	(MODEL_FILE_HEADER_SIZE + n_sections * sizeof(Section) > m_size)) {
+	munmap(m_data, m_size);
+	Rcpp::stop(path + " has a corrupt section table");
+    }
+
+    m_sections = reinterpret_cast<const Section*>(m_data + MODEL_FILE_HEADER_SIZE);
+    m_n_sections = n_sections;
+
+    // check that each section is well-formed and that its data lies within the
+    // file, after the section table and at an 8-byte aligned offset
+    const double data_beg = MODEL_FILE_HEADER_SIZE + m_n_sections * sizeof(Section);
+    for (int t = 0; t < m_n_sections; ++t) {
+
+	const Section& curr = m_sections[t];
+	if ((std::memchr(curr.name, '\0', sizeof(curr.name)) == 0) ||
+	    (std::memchr(curr.col_nm, '\0', sizeof(curr.col_nm)) == 0)) {
+	    munmap(m_data, m_size);
+	    Rcpp::stop(path + " has a corrupt section table");
+	}
+
+	const std::string name(curr.name);
+	if (! is_valid_section(curr, data_beg)) {
+	    munmap(m_data, m_size);
+	    Rcpp::stop(path + " has an invalid section " + name);
+	}
+
+	const double elem_size = (curr.type == MODEL_FILE_TYPE_DOUBLE) ? 8.0 :
+	    (curr.type == MODEL_FILE_TYPE_INT) ? 4.0 : 1.0;
+	if (curr.offset + curr.n_rows * curr.n_cols * elem_size > m_size) {
+	    munmap(m_data, m_size);
+	    Rcpp::stop(path + " has a truncated section " + name);
+	}
+    }
+#endif
+}
+
+
+
+
+// whether the type, dimensions, and offset of `section` are valid, where the
+// section data must begin no earlier than `data_beg`.  Note that the
+// comparisons are false for NaN values.
+
+bool ModelFile::is_valid_section(const Section& section, double data_beg) {
+
+    const bool is_valid_type = ((section.type == MODEL_FILE_TYPE_INT) ||
+				(section.type == MODEL_FILE_TYPE_DOUBLE) ||
+				(section.type == MODEL_FILE_TYPE_CHAR));
+    const bool is_valid_rows = ((section.n_rows >= 0.0) &&
+				(section.n_rows < R_PosInf) &&
+				(section.n_rows == std::floor(section.n_rows)));
+    const bool is_valid_offset = ((section.offset >= data_beg) &&
+				  (section.offset < R_PosInf) &&
+				  (std::fmod(section.offset, 8.0) == 0.0));
+
+    return is_valid_type && is_valid_rows && is_valid_offset && (section.n_cols >= 0);
+}
+
+
+
+
+ModelFile::~ModelFile() {
+#ifndef _WIN32
+    munmap(m_data, m_size);
+#endif
+}
+
+
+
+
+// returns either a pointer to the section with name `name` or 0 if there is no
+// such section
+
+const ModelFile::Section* ModelFile::find(const char* name) const {
+
+    for (int t = 0; t < m_n_sections; ++t) {
+	if (std::strncmp(m_sections[t].name, name, sizeof(m_sections[t].name)) == 0) {
+	    return m_sections + t;
+	}
+    }
+
+    return 0;
+}
+
+
+
+
+// returns a pointer to the section with name `name`, and throws an error if
+// there is no such section or if the section doesn't have type `type`
+
+const ModelFile::Section* ModelFile::get(const char* name, int type) const {
+
+    const Section* section = find(name);
+
+    if (section == 0) {
+	Rcpp::stop(std::string("model file is missing section ") + name);
+    }
+    if (section->type != type) {
+	Rcpp::stop(std::string("model file section ") + name + " has the wrong type");
+    }
+
+    return section;
+}
+
+
+
+
+dsp_idx_t ModelFile::n_rows(const char* name) const {
+
+    const Section* section = find(name);
+    if (section == 0) {
+	Rcpp::stop(std::string("model file is missing section ") + name);
+    }
+
+    return (dsp_idx_t) section->n_rows;
+}
+
+
+
+
+int ModelFile::n_cols(const char* name) const {
+
+    const Section* section = find(name);
+    if (section == 0) {
+	Rcpp::stop(std::string("model file is missing section ") + name);
+    }
+
+    return section->n_cols;
+}
+
+
+
+
+int* ModelFile::int_data(const char* name) const {
+    return reinterpret_cast<int*>(m_data + (size_t) get(name, MODEL_FILE_TYPE_INT)->offset);
+}
+
+
+
+
+double* ModelFile::dbl_data(const char* name) const {
+    return reinterpret_cast<double*>(m_data + (size_t) get(name, MODEL_FILE_TYPE_DOUBLE)->offset);
+}
+
+
+
+
+double ModelFile::dbl_scalar(const char* name) const {
+    return *dbl_data(name);
+}
+
+
+
+
+// copy an integer matrix section into an `Rcpp::IntegerMatrix` with column names
+// given by the section's column names.  This is intended for the block
+// descriptions, which are small compared to the day-specific data and which are
+// converted to arrays of structs by the sampler anyway.
+
+Rcpp::IntegerMatrix ModelFile::block_mat(const char* name) const {
+
+    const Section* section = get(name, MODEL_FILE_TYPE_INT);
+    const int n_rows = (int) section->n_rows;
+    const int n_cols = section->n_cols;
+    const int* vals = reinterpret_cast<const int*>(m_data + (size_t) section->offset);
+
+    Rcpp::IntegerMatrix out(n_rows, n_cols);
+    std::copy(vals, vals + n_rows * n_cols, out.begin());
+
+    // split the comma-separated column names
+    Rcpp::CharacterVector out_nm(n_cols);
+    std::string col_nm(section->col_nm, strnlen(section->col_nm, sizeof(section->col_nm)));
+    size_t beg = 0;
+    for (int j = 0; j < n_cols; ++j) {
+	size_t end = col_nm.find(',', beg);
+	out_nm[j] = col_nm.substr(beg, end - beg);
+	beg = end + 1;
+    }
+    Rcpp::colnames(out) = out_nm;
+
+    return out;
+}
+
+
+
+
+// similar to `block_mat`, but for a section with one row that is to be accessed
+// by name, such as the `var_info` information for a missing covariate
+
+Rcpp::IntegerVector ModelFile::named_int_vec(const char* name) const {
+
+    Rcpp::IntegerMatrix mat = block_mat(name);
+    Rcpp::IntegerVector out(mat.begin(), mat.end());
+    out.names() = Rcpp::colnames(mat);
+
+    return out;
+}
+
+
+
+
+// read a character section, which stores newline-separated strings
+
+Rcpp::CharacterVector ModelFile::char_vec(const char* name) const {
+
+    const Section* section = get(name, MODEL_FILE_TYPE_CHAR);
+    std::string vals(m_data + (size_t) section->offset, (size_t) section->n_rows);
+
+    std::vector<std::string> out;
+    size_t beg = 0;
+    while (beg <= vals.size() && !vals.empty()) {
+	size_t end = vals.find('\n', beg);
+	if (end == std::string::npos) {
+	    end = vals.size();
+	}
+	out.push_back(vals.substr(beg, end - beg));
+	beg = end + 1;
+    }
+
+    return Rcpp::wrap(out);
+}
+
+
+
+
+// inform the operating system that the file is going to be read sequentially,
+// so that it reads ahead aggressively and is able to drop pages soon after they
+// have been read
+
+void ModelFile::advise_sequential() const {
+#ifndef _WIN32
+    madvise(m_data, m_size, MADV_SEQUENTIAL);
+#endif
+}
+
+
+
+
+// map `n_bytes` of scratch memory that is backed by a file in `dir` rather than
+// by memory, so that the operating system is able to write the pages out to
+// the file when memory is scarce.  The file is removed immediately after it is
+// created, so that it is automatically cleaned up when the memory is unmapped
+// (or if the process terminates).
+
+void* ModelFile::map_scratch(const std::string& dir, size_t n_bytes) {
+
+#ifdef _WIN32
+    Rcpp::stop("file-backed scratch memory is not supported on Windows");
+    return 0;
+#else
+    std::string path_str = dir + "/dspBayes-scratch-XXXXXX";
+    std::vector<char> path(path_str.begin(), path_str.end());
+    path.push_back('\0');
+
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+	Rcpp::stop("unable to create a scratch file in " + dir);
+    }
+    unlink(&path[0]);
+
+    if (ftruncate(fd, n_bytes) != 0) {
+	close(fd);
+	Rcpp::stop("unable to allocate a scratch file in " + dir);
+    }
+
+    void* addr = mmap(0, n_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+	Rcpp::stop("unable to map a scratch file in " + dir);
+    }
+
+    return addr;
+#endif
+}
+
+
+
+
+void ModelFile::unmap_scratch(void* addr, size_t n_bytes) {
+#ifndef _WIN32
+    munmap(addr, n_bytes);
+#endif
+}
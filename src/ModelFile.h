@@ -0,0 +1,85 @@
+#ifndef DSP_BAYES_SRC_MODEL_FILE_H
+#define DSP_BAYES_SRC_MODEL_FILE_H
+
+#include <stdint.h>
+#include <string>
+#include "Rcpp.h"
+#include "IdxType.h"
+
+#define MODEL_FILE_VERSION       1
+#define MODEL_FILE_TYPE_INT      0
+#define MODEL_FILE_TYPE_DOUBLE   1
+#define MODEL_FILE_TYPE_CHAR     2
+
+
+// provides read access to a model file as written by the R function
+// `write_model_file`.  The file is mapped into memory rather than read, so that
+// the day-specific data (which is the bulk of the file) can be used in place by
+// the sampler without being copied.
+//
+// The mapping is private, so that the pages of the file are shared between
+// concurrent jobs reading the same file until a page is written to, at which
+// point that job obtains its own copy of the page.  This matters since the
+// sampler updates the missing values of `X` and `U` in place.
+//
+// The file layout is as follows, where the data for each section begins at an
+// 8-byte aligned offset.
+//
+//     header:     char magic[8]  (the string "DSPBAYES")
+//                 int32 version
+//                 int32 n_sections
+//
+//     sections:   n_sections copies of `ModelFile::Section`
+//
+//     data:       the data for each section, stored in column-major order
+
+class ModelFile {
+
+public:
+
+    // describes one array stored in the file.  The 64-bit quantities are
+    // stored as doubles because base R cannot write 64-bit integers.
+    struct Section {
+	char name[48];
+	char col_nm[128];  // comma-separated column names, or the empty string
+	int32_t type;
+	int32_t n_cols;
+	double n_rows;
+	double offset;
+    };
+
+    char* m_data;
+    size_t m_size;
+
+    const Section* m_sections;
+    int m_n_sections;
+
+    ModelFile(const std::string& path);
+    ~ModelFile();
+
+    const Section* find(const char* name) const;
+    bool has(const char* name) const { return find(name) != 0; }
+
+    dsp_idx_t n_rows(const char* name) const;
+    int n_cols(const char* name) const;
+    int* int_data(const char* name) const;
+    double* dbl_data(const char* name) const;
+    double dbl_scalar(const char* name) const;
+
+    Rcpp::IntegerMatrix block_mat(const char* name) const;
+    Rcpp::IntegerVector named_int_vec(const char* name) const;
+    Rcpp::CharacterVector char_vec(const char* name) const;
+
+    void advise_sequential() const;
+
+    static void* map_scratch(const std::string& dir, size_t n_bytes);
+    static void unmap_scratch(void* addr, size_t n_bytes);
+
+private:
+
+    const Section* get(const char* name, int type) const;
+    static bool is_valid_section(const Section& section, double data_beg);
+};
+
+
+#endif
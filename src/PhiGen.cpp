@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <cmath>
 #include "Rcpp.h"
 #include "PhiGen.h"
 #include "XiGen.h"
+#include "XiMarg.h"
 #include "ProposalFcns.h"
 
 using std::log;
@@ -15,10 +17,18 @@ PhiGen::PhiGen(Rcpp::NumericVector phi_specs, int n_samp, bool record_status) :
     m_hyp_c1(phi_specs["c1"]),
     m_hyp_c2(phi_specs["c2"]),
     m_delta(phi_specs["delta"]),
+    m_adapt(),
     m_vals_rcpp(Rcpp::NumericVector(Rcpp::no_init(record_status ? n_samp : 1))),
     m_vals(m_vals_rcpp.begin()),
     m_accept_ctr(0),
+    m_prop_ctr(0),
     m_record_status(record_status),
+    m_use_slice(phi_specs.containsElementNamed("slice") && ((int) phi_specs["slice"])),
+    m_use_asis(phi_specs.containsElementNamed("asis") && ((int) phi_specs["asis"])),
+    m_asis_delta(phi_specs["delta"]),
+    m_asis_adapt(),
+    m_asis_accept_ctr(0),
+    m_asis_prop_ctr(0),
     m_is_same_as_prev(false),
     m_log_norm_const(0) {
 
@@ -33,6 +43,17 @@ void PhiGen::sample(const XiGen& xi) {
 
     double proposal_val, new_val, log_r;
 
+    // case: sample phi by a slice sampler, which has no tuning parameters to
+    // adapt
+    if (m_use_slice) {
+	new_val = sample_slice(xi, NULL);
+	if (m_record_status && g_record_status) {
+	    ++m_vals;
+	}
+	*m_vals = new_val;
+	return;
+    }
+
     // sample the proposal value for Metropolis step
     proposal_val = ProposalFcns::abs_unif(*m_vals, m_delta);
 
@@ -44,6 +65,14 @@ void PhiGen::sample(const XiGen& xi) {
     // by keeping the current value
     new_val = update_phi(log_r, proposal_val);
 
+    // tune the proposal distribution during the burn-in phase (see MhAdapt.h)
+    if (g_burn_status) {
+	m_delta = MhAdapt::adapt_step(m_delta, m_adapt.next_gain(), log_r);
+    }
+    else {
+	++m_prop_ctr;
+    }
+
     // save the value of the new sample.  If we are recording samples then
     // increment `m_vals` so that we don't overwrite the previous sample.
     if (m_record_status && g_record_status) {
@@ -55,6 +84,197 @@ void PhiGen::sample(const XiGen& xi) {
 
 
 
+// sample phi from its full conditional distribution with xi integrated out (see
+// XiMarg.h) by a slice sampler.  Each evaluation of the log density requires a
+// sum over the subjects.
+
+void PhiGen::sample_marg(const XiGen& xi, const XiMarg& marg) {
+
+    const double new_val = sample_slice(xi, &marg);
+
+    if (m_record_status && g_record_status) {
+	++m_vals;
+    }
+    *m_vals = new_val;
+    m_is_same_as_prev = false;
+}
+
+
+
+
+// exchange the current value of phi with that of `other`, which is used to
+// swap the states of two chains of a temperature ladder (see TemperLadder.h)
+
+void PhiGen::swap_state(PhiGen& other) {
+    std::swap(*m_vals, *other.m_vals);
+    m_is_same_as_prev = false;
+    other.m_is_same_as_prev = false;
+}
+
+
+
+
+// an ancillarity-sufficiency interweaving step for phi (Yu and Meng, 2011),
+// which is performed after phi is sampled given xi.  In this centered
+// parameterization xi is a sufficient augmentation for phi, which mixes poorly
+// when the data for each subject is sparse or phi is large.  Instead in the
+// non-centered parameterization each `xi_i` is expressed as
+//
+//     xi_i = F^{-1}(v_i; phi)
+//
+// where `F(.; phi)` is the CDF of a `Gamma(phi, phi)` distribution, so that
+// the `v_i` are uniform random variables that don't depend on phi.  Phi is
+// then updated given `v` by a Metropolis-Hastings step, for which the log
+// posterior is, up to a constant,
+//
+//     sum_i { W_i * log(xi_i) - S_i * xi_i } + (c_1 - 1) * log(phi) - c_2 * phi
+//
+// where `W_i` and `S_i` are `sum_jk W_ijk` and `sum_jk X_ijk * exp(u_ijk^T
+// beta)` as calculated by `XiGen::sample`, and xi is transformed accordingly.
+// This requires that `U * beta` is unchanged since xi was sampled.  The cost of
+// the step is O(n_subj).
+//
+// The tail probabilities are stored on the log scale, and in the upper tail
+// for the values in the upper tail of the distribution, so that the
+// transformation doesn't lose precision for the extreme values of xi.
+
+void PhiGen::sample_asis(XiGen& xi) {
+
+    const int n_subj = xi.n_subj();
+    double* xi_vals = xi.m_vals;
+    const double* w_sums = xi.w_sums();
+    const double* exp_sums = xi.exp_sums();
+    const double curr_val = *m_vals;
+
+    if (m_asis_prop.size() != (size_t) n_subj) {
+	m_asis_log_p.resize(n_subj);
+	m_asis_lower.resize(n_subj);
+	m_asis_prop.resize(n_subj);
+    }
+
+    // calculate the ancillary variables and the log-likelihood for the
+    // current value
+    double curr_log_lik = 0.0;
+    for (int i = 0; i < n_subj; ++i) {
+	const double xi_val = xi_vals[i];
+	const double log_p_lower = R::pgamma(xi_val, curr_val, 1.0 / curr_val, 1, 1);
+	m_asis_lower[i] = (log_p_lower < -M_LN2);
+	m_asis_log_p[i] = m_asis_lower[i] ?
+	    log_p_lower :
+	    R::pgamma(xi_val, curr_val, 1.0 / curr_val, 0, 1);
+	curr_log_lik += (w_sums[i] ? (w_sums[i] * log(xi_val)) : 0.0) - (exp_sums[i] * xi_val);
+    }
+
+    // calculate the values of xi and the log-likelihood for the proposal value
+    const double proposal_val = ProposalFcns::abs_unif(curr_val, m_asis_delta);
+    double proposal_log_lik = 0.0;
+    for (int i = 0; i < n_subj; ++i) {
+	const double xi_val = R::qgamma(m_asis_log_p[i], proposal_val, 1.0 / proposal_val, m_asis_lower[i], 1);
+	m_asis_prop[i] = xi_val;
+	proposal_log_lik += (w_sums[i] ? (w_sums[i] * log(xi_val)) : 0.0) - (exp_sums[i] * xi_val);
+    }
+
+    const double log_r = ((proposal_log_lik - curr_log_lik)
+			  + calc_log_proportion_dgamma_phi(proposal_val));
+    const bool is_accept = (log_r >= 0) || (log(R::unif_rand()) < log_r);
+
+    // update phi in place, so that the recorded value is replaced, and
+    // transform xi
+    if (is_accept) {
+	*m_vals = proposal_val;
+	m_is_same_as_prev = false;
+	std::copy(m_asis_prop.begin(), m_asis_prop.end(), xi_vals);
+	xi.calc_sums();
+	xi.replace_recorded();
+    }
+
+    if (g_burn_status) {
+	m_asis_delta = MhAdapt::adapt_step(m_asis_delta, m_asis_adapt.next_gain(), log_r);
+    }
+    else {
+	++m_asis_prop_ctr;
+	m_asis_accept_ctr += is_accept;
+    }
+}
+
+
+
+
+// sample phi by a slice sampler with the stepping out and shrinkage procedures
+// (Neal, 2003).  The full conditional distribution of phi only depends on xi
+// through `sum_i log(xi_i) - xi_i`, which is accumulated by `XiGen::sample`, so
+// that each evaluation of the log density is O(1).  The log density is concave
+// when `c1 >= 1`, in which case the slice is an interval.  If `marg` is not
+// NULL then the target is instead the distribution with xi integrated out.
+
+double PhiGen::sample_slice(const XiGen& xi, const XiMarg* marg) const {
+
+    const double curr_val = *m_vals;
+
+    // the height of the slice
+    const double log_y = calc_log_post(curr_val, xi, marg) - R::exp_rand();
+
+    // randomly position an interval of width `m_delta` around the current
+    // value, and step it out until both ends are outside of the slice, with at
+    // most `PHI_GEN_SLICE_MAX_STEPS` steps in total
+    double lower = curr_val - (m_delta * R::unif_rand());
+    double upper = lower + m_delta;
+    int n_lower_steps = (int) (PHI_GEN_SLICE_MAX_STEPS * R::unif_rand());
+    int n_upper_steps = PHI_GEN_SLICE_MAX_STEPS - 1 - n_lower_steps;
+    while ((n_lower_steps > 0) && (lower > 0.0) && (calc_log_post(lower, xi, marg) > log_y)) {
+	lower -= m_delta;
+	--n_lower_steps;
+    }
+    while ((n_upper_steps > 0) && (calc_log_post(upper, xi, marg) > log_y)) {
+	upper += m_delta;
+	--n_upper_steps;
+    }
+    lower = std::fmax(0.0, lower);
+
+    // sample uniformly from the interval, shrinking the interval towards the
+    // current value after each value that is outside of the slice
+    while (true) {
+	const double proposal_val = R::runif(lower, upper);
+	if (calc_log_post(proposal_val, xi, marg) > log_y) {
+	    return proposal_val;
+	}
+	if (proposal_val < curr_val) {
+	    lower = proposal_val;
+	}
+	else {
+	    upper = proposal_val;
+	}
+    }
+}
+
+
+
+
+// the log of the full conditional density of phi up to a constant, given by
+//
+//     n * { phi * log(phi) - log(Gamma(phi)) } + phi * sum_i { log(xi_i) - xi_i }
+//         + (c_1 - 1) * log(phi) - c_2 * phi
+//
+// or if `marg` is not NULL, the same with the first two terms replaced by the
+// log-likelihood with xi integrated out (see `XiMarg::log_lik_phi`)
+
+double PhiGen::calc_log_post(double phi_val, const XiGen& xi, const XiMarg* marg) const {
+
+    if (phi_val <= 0.0) {
+	return R_NegInf;
+    }
+
+    const double log_lik = marg ?
+	marg->log_lik_phi(phi_val) :
+	((xi.n_subj() * log_dgamma_norm_const(phi_val))
+	 + (phi_val * (xi.sum_log_vals() - xi.sum_vals())));
+
+    return log_lik + ((m_hyp_c1 - 1) * log(phi_val)) - (m_hyp_c2 * phi_val);
+}
+
+
+
+
 // calculate `log(r)` where `r` is the ratio of the posterior likelihood of the
 // proposed value of phi divided by the posterior likelihood of the current
 // value of phi.  This value is given by:
@@ -84,16 +304,42 @@ double PhiGen::calc_log_r(const XiGen& xi, double proposal_val) {
 
 
 
+// the tuning parameter and the acceptance rate after the burn-in phase.  The
+// acceptance rate is missing for the slice sampler.  The same quantities for
+// the interweaving step are included when it's in use.
+
+Rcpp::NumericVector PhiGen::tuning() const {
+
+    Rcpp::NumericVector out = Rcpp::NumericVector::create(
+	Rcpp::Named("delta")       = m_delta,
+	Rcpp::Named("accept_rate") = (m_prop_ctr > 0) ?
+	    ((double) m_accept_ctr) / m_prop_ctr :
+	    NA_REAL);
+    if (m_use_asis) {
+	out.push_back(m_asis_delta, "asis_delta");
+	out.push_back((m_asis_prop_ctr > 0) ?
+		      ((double) m_asis_accept_ctr) / m_asis_prop_ctr :
+		      NA_REAL,
+		      "asis_accept_rate");
+    }
+
+    return out;
+}
+
+
+
+
 // randomly update the value of phi by either accepting the proposal value for
 // phi or by keeping the current value.  The proposal value is accepted with
 // probability min(1, r).
 
 double PhiGen::update_phi(double log_r, double proposal_val) {
 
-    // case: accept proposal value
+    // case: accept proposal value.  The acceptances are only counted after the
+    // burn-in phase.
     if (log(R::unif_rand()) < log_r) {
 	m_is_same_as_prev = false;
-	++m_accept_ctr;
+	m_accept_ctr += ! g_burn_status;
     }
     // case: reject proposal value
     else {
@@ -121,9 +367,8 @@ double PhiGen::update_phi(double log_r, double proposal_val) {
 
 double PhiGen::calc_log_proportion_dgamma_xi(const XiGen& xi, double proposal_val) {
 
-    double curr_xi, numer_log_norm_const, denom_log_norm_const, log_kernel_ratio;
+    double numer_log_norm_const, denom_log_norm_const, log_kernel_ratio;
 
-    const double* xi_vals = xi.vals();
     int n_subj = xi.n_subj();
 
     // calculate the log of the normalizing constant for the proposal value
@@ -139,15 +384,9 @@ double PhiGen::calc_log_proportion_dgamma_xi(const XiGen& xi, double proposal_va
 	m_log_norm_const = denom_log_norm_const;
     }
 
-    // each iteration adds the kernel log likelihood ratio of the current
-    // subject to `log_kernel_ratio`
-    log_kernel_ratio = 0;
-    for (int i = 0; i < n_subj; ++i) {
-	curr_xi = xi_vals[i];
-	log_kernel_ratio += log(curr_xi) - curr_xi;
-    }
-    // mutiply in the `phi^{*} - phi^(s)` term
-    log_kernel_ratio *= proposal_val - *m_vals;
+    // the kernel log likelihood ratio, where `sum_i { log(xi_i) - xi_i }` is
+    // accumulated by `XiGen::sample`
+    log_kernel_ratio = (xi.sum_log_vals() - xi.sum_vals()) * (proposal_val - *m_vals);
 
     return numer_log_norm_const - denom_log_norm_const + log_kernel_ratio;
 }
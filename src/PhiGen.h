@@ -1,10 +1,18 @@
 #ifndef DSP_BAYES_SRC_PHI_GEN_H
 #define DSP_BAYES_SRC_PHI_GEN_H
 
+#include <vector>
 #include "Rcpp.h"
+#include "MhAdapt.h"
 class XiGen;
+class XiMarg;
+
+// the largest number of steps in each direction when stepping out the interval
+// for the slice sampler
+#define PHI_GEN_SLICE_MAX_STEPS 50
 
 extern bool g_record_status;
+extern bool g_burn_status;
 
 
 class PhiGen {
@@ -12,21 +20,54 @@ class PhiGen {
 public:
 
     // gamma distribution hyperparameters c1 and c2 and tuning parameter for the
-    // proposal distribution delta
+    // proposal distribution delta.  `m_delta` is adapted during the burn-in
+    // phase (see MhAdapt.h).
     const double m_hyp_c1;
     const double m_hyp_c2;
-    const double m_delta;
+    double m_delta;
+    MhAdapt m_adapt;
 
     // current value of phi and storage for previous values
     Rcpp::NumericVector m_vals_rcpp;
     Rcpp::NumericVector::iterator m_vals;
 
-    // tracks the number of times that the proposal distribution was accepted
+    // tracks the number of times that the proposal distribution was accepted,
+    // and the number of proposals after the burn-in phase
     int m_accept_ctr;
+    int m_prop_ctr;
 
     // tracks whether we wish to save the samples of phi to return to the user
     const bool m_record_status;
 
+    // whether phi is sampled by a slice sampler rather than by a
+    // Metropolis-Hastings step (see `PhiGen::sample_slice`), in which case
+    // `m_delta` is the initial width of the interval
+    const bool m_use_slice;
+
+    // the ancillarity-sufficiency interweaving step (see
+    // `PhiGen::sample_asis`):
+    //
+    //   m_use_asis:  whether the step is performed after each update of phi
+    //
+    //   m_asis_delta:  the tuning parameter for the proposal distribution,
+    //     which is adapted during the burn-in phase
+    //
+    //   m_asis_accept_ctr, m_asis_prop_ctr:  the number of accepted proposals
+    //     and the number of proposals after the burn-in phase
+    //
+    //   m_asis_log_p, m_asis_lower:  the log of the gamma distribution tail
+    //     probability of each `xi_i`, and whether it's the lower tail
+    //
+    //   m_asis_prop:  the values of xi under the proposal value of phi
+    const bool m_use_asis;
+    double m_asis_delta;
+    MhAdapt m_asis_adapt;
+    int m_asis_accept_ctr;
+    int m_asis_prop_ctr;
+    std::vector<double> m_asis_log_p;
+    std::vector<char> m_asis_lower;
+    std::vector<double> m_asis_prop;
+
     // whether the proposal distribution was not accepted so that the value of
     // phi is unchanged from the last scan.  When this is the case then the
     // calculation for `m_log_norm_const` can be reused
@@ -40,8 +81,14 @@ public:
     PhiGen(Rcpp::NumericVector phi_hyper, int n_samp, bool record_status);
 
     void sample(const XiGen& xi);
+    void sample_marg(const XiGen& xi, const XiMarg& marg);
+    void sample_asis(XiGen& xi);
+    void swap_state(PhiGen& other);
+    double sample_slice(const XiGen& xi, const XiMarg* marg) const;
+    double calc_log_post(double phi_val, const XiGen& xi, const XiMarg* marg) const;
     double val() const { return *m_vals; }
     int n_accept() const { return m_accept_ctr; }
+    Rcpp::NumericVector tuning() const;
 
     double calc_log_r(const XiGen& xi, double proposal_val);
     double update_phi(double log_r, double proposal_val);
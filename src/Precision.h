@@ -0,0 +1,66 @@
+#ifndef DSP_BAYES_SRC_PRECISION_H
+#define DSP_BAYES_SRC_PRECISION_H
+
+#include "Rcpp.h"
+#include "IdxType.h"
+
+
+// the type used to store the day-specific `U * beta` and `exp(U * beta)`
+// values.  The sweeps over the days are limited by memory bandwidth rather than
+// by computation, so storing these values in single precision (by defining
+// `DSP_BAYES_FLOAT_STORAGE` at compile-time) approximately halves the cost of
+// the sweeps.  The reductions over the days (e.g. in `XiGen::sample`,
+// `GammaCateg::calc_b_tilde`, and `GammaContMH::get_w_log_lik`) are always
+// accumulated in double precision.
+
+#ifdef DSP_BAYES_FLOAT_STORAGE
+typedef float dsp_store_t;
+#else
+typedef double dsp_store_t;
+#endif
+
+
+
+
+// when `DSP_BAYES_FLOAT_DRAWS` is defined at compile-time, the recorded samples
+// for xi and the regression coefficients are stored as 32-bit floats rather
+// than as doubles, which halves the memory needed to store the samples.  The
+// samples are returned to R as a raw vector with the bytes of the floats, and
+// are decoded by the R function `decode_draws`.
+
+#ifdef DSP_BAYES_FLOAT_DRAWS
+
+class FloatDraws {
+
+public:
+
+    Rcpp::RawVector m_rcpp;
+    float* m_curr;
+
+    FloatDraws(dsp_idx_t n_draws) :
+	m_rcpp(Rcpp::RawVector((dsp_idx_t) (n_draws * sizeof(float)))),
+	m_curr(reinterpret_cast<float*>(m_rcpp.begin())) {
+    }
+
+    // copy the `n` values in `vals` to the next available storage
+    void record(const double* vals, int n) {
+	for (int i = 0; i < n; ++i) {
+	    m_curr[i] = (float) vals[i];
+	}
+	m_curr += n;
+    }
+
+    // replace the last `n` recorded values with the values in `vals`
+    void replace_last(const double* vals, int n) {
+	for (int i = 0; i < n; ++i) {
+	    m_curr[i - n] = (float) vals[i];
+	}
+    }
+
+    Rcpp::RawVector rcpp() const { return m_rcpp; }
+};
+
+#endif
+
+
+#endif
@@ -6,18 +6,22 @@
 using namespace Rcpp;
 
 // dsp_
-Rcpp::List dsp_(Rcpp::NumericMatrix u_rcpp, Rcpp::IntegerVector x_rcpp, Rcpp::List w_day_blocks, Rcpp::IntegerVector w_to_days_idx, Rcpp::IntegerVector w_cyc_to_subj_idx, Rcpp::List subj_day_blocks, Rcpp::IntegerVector day_to_subj_idx, Rcpp::List gamma_specs, Rcpp::NumericVector phi_specs, Rcpp::IntegerVector x_miss, Rcpp::IntegerVector sex_miss_to_w, Rcpp::NumericVector utau_rcpp, Rcpp::List tau_coefs, Rcpp::List u_miss_info, Rcpp::IntegerVector u_miss_type, Rcpp::IntegerVector u_preg_map, Rcpp::IntegerVector u_sex_map, int fw_len, int n_burn, int n_samp);
-RcppExport SEXP _dspBayes_dsp_(SEXP u_rcppSEXP, SEXP x_rcppSEXP, SEXP w_day_blocksSEXP, SEXP w_to_days_idxSEXP, SEXP w_cyc_to_subj_idxSEXP, SEXP subj_day_blocksSEXP, SEXP day_to_subj_idxSEXP, SEXP gamma_specsSEXP, SEXP phi_specsSEXP, SEXP x_missSEXP, SEXP sex_miss_to_wSEXP, SEXP utau_rcppSEXP, SEXP tau_coefsSEXP, SEXP u_miss_infoSEXP, SEXP u_miss_typeSEXP, SEXP u_preg_mapSEXP, SEXP u_sex_mapSEXP, SEXP fw_lenSEXP, SEXP n_burnSEXP, SEXP n_sampSEXP) {
+Rcpp::List dsp_(Rcpp::NumericMatrix u_rcpp, Rcpp::IntegerVector x_rcpp, SEXP w_day_blocks, Rcpp::IntegerVector w_to_days_idx, Rcpp::IntegerVector w_cyc_to_subj_idx, SEXP subj_day_blocks, Rcpp::IntegerVector day_to_subj_idx, Rcpp::IntegerVector day_to_cyc_idx, Rcpp::NumericMatrix u_cyc, Rcpp::NumericMatrix u_subj, Rcpp::IntegerVector fw_pos, Rcpp::List gamma_specs, Rcpp::NumericVector phi_specs, Rcpp::IntegerVector x_miss, Rcpp::IntegerVector sex_miss_to_w, Rcpp::NumericVector utau_rcpp, Rcpp::List tau_coefs, Rcpp::List u_miss_info, Rcpp::IntegerVector u_miss_type, Rcpp::IntegerVector u_preg_map, Rcpp::IntegerVector u_sex_map, int fw_len, int n_burn, int n_samp, int engine, Rcpp::NumericVector pt_specs, Rcpp::NumericVector vb_specs);
+RcppExport SEXP _dspBayes_dsp_(SEXP u_rcppSEXP, SEXP x_rcppSEXP, SEXP w_day_blocksSEXP, SEXP w_to_days_idxSEXP, SEXP w_cyc_to_subj_idxSEXP, SEXP subj_day_blocksSEXP, SEXP day_to_subj_idxSEXP, SEXP day_to_cyc_idxSEXP, SEXP u_cycSEXP, SEXP u_subjSEXP, SEXP fw_posSEXP, SEXP gamma_specsSEXP, SEXP phi_specsSEXP, SEXP x_missSEXP, SEXP sex_miss_to_wSEXP, SEXP utau_rcppSEXP, SEXP tau_coefsSEXP, SEXP u_miss_infoSEXP, SEXP u_miss_typeSEXP, SEXP u_preg_mapSEXP, SEXP u_sex_mapSEXP, SEXP fw_lenSEXP, SEXP n_burnSEXP, SEXP n_sampSEXP, SEXP engineSEXP, SEXP pt_specsSEXP, SEXP vb_specsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< Rcpp::NumericMatrix >::type u_rcpp(u_rcppSEXP);
     Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type x_rcpp(x_rcppSEXP);
-    Rcpp::traits::input_parameter< Rcpp::List >::type w_day_blocks(w_day_blocksSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type w_day_blocks(w_day_blocksSEXP);
     Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type w_to_days_idx(w_to_days_idxSEXP);
     Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type w_cyc_to_subj_idx(w_cyc_to_subj_idxSEXP);
-    Rcpp::traits::input_parameter< Rcpp::List >::type subj_day_blocks(subj_day_blocksSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type subj_day_blocks(subj_day_blocksSEXP);
     Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type day_to_subj_idx(day_to_subj_idxSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type day_to_cyc_idx(day_to_cyc_idxSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericMatrix >::type u_cyc(u_cycSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericMatrix >::type u_subj(u_subjSEXP);
+    Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type fw_pos(fw_posSEXP);
     Rcpp::traits::input_parameter< Rcpp::List >::type gamma_specs(gamma_specsSEXP);
     Rcpp::traits::input_parameter< Rcpp::NumericVector >::type phi_specs(phi_specsSEXP);
     Rcpp::traits::input_parameter< Rcpp::IntegerVector >::type x_miss(x_missSEXP);
@@ -31,7 +35,31 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type fw_len(fw_lenSEXP);
     Rcpp::traits::input_parameter< int >::type n_burn(n_burnSEXP);
     Rcpp::traits::input_parameter< int >::type n_samp(n_sampSEXP);
-    rcpp_result_gen = Rcpp::wrap(dsp_(u_rcpp, x_rcpp, w_day_blocks, w_to_days_idx, w_cyc_to_subj_idx, subj_day_blocks, day_to_subj_idx, gamma_specs, phi_specs, x_miss, sex_miss_to_w, utau_rcpp, tau_coefs, u_miss_info, u_miss_type, u_preg_map, u_sex_map, fw_len, n_burn, n_samp));
+    Rcpp::traits::input_parameter< int >::type engine(engineSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type pt_specs(pt_specsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type vb_specs(vb_specsSEXP);
+    rcpp_result_gen = Rcpp::wrap(dsp_(u_rcpp, x_rcpp, w_day_blocks, w_to_days_idx, w_cyc_to_subj_idx, subj_day_blocks, day_to_subj_idx, day_to_cyc_idx, u_cyc, u_subj, fw_pos, gamma_specs, phi_specs, x_miss, sex_miss_to_w, utau_rcpp, tau_coefs, u_miss_info, u_miss_type, u_preg_map, u_sex_map, fw_len, n_burn, n_samp, engine, pt_specs, vb_specs));
+    return rcpp_result_gen;
+END_RCPP
+}
+// dsp_from_file_
+Rcpp::List dsp_from_file_(std::string model_file, Rcpp::List gamma_specs, Rcpp::NumericVector phi_specs, int fw_len, int n_burn, int n_samp, int chunk_days, std::string scratch_dir, int engine, Rcpp::NumericVector pt_specs, Rcpp::NumericVector vb_specs);
+RcppExport SEXP _dspBayes_dsp_from_file_(SEXP model_fileSEXP, SEXP gamma_specsSEXP, SEXP phi_specsSEXP, SEXP fw_lenSEXP, SEXP n_burnSEXP, SEXP n_sampSEXP, SEXP chunk_daysSEXP, SEXP scratch_dirSEXP, SEXP engineSEXP, SEXP pt_specsSEXP, SEXP vb_specsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type model_file(model_fileSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type gamma_specs(gamma_specsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type phi_specs(phi_specsSEXP);
+    Rcpp::traits::input_parameter< int >::type fw_len(fw_lenSEXP);
+    Rcpp::traits::input_parameter< int >::type n_burn(n_burnSEXP);
+    Rcpp::traits::input_parameter< int >::type n_samp(n_sampSEXP);
+    Rcpp::traits::input_parameter< int >::type chunk_days(chunk_daysSEXP);
+    Rcpp::traits::input_parameter< std::string >::type scratch_dir(scratch_dirSEXP);
+    Rcpp::traits::input_parameter< int >::type engine(engineSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type pt_specs(pt_specsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type vb_specs(vb_specsSEXP);
+    rcpp_result_gen = Rcpp::wrap(dsp_from_file_(model_file, gamma_specs, phi_specs, fw_len, n_burn, n_samp, chunk_days, scratch_dir, engine, pt_specs, vb_specs));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -68,7 +96,8 @@ END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_dspBayes_dsp_", (DL_FUNC) &_dspBayes_dsp_, 20},
+    {"_dspBayes_dsp_", (DL_FUNC) &_dspBayes_dsp_, 27},
+    {"_dspBayes_dsp_from_file_", (DL_FUNC) &_dspBayes_dsp_from_file_, 11},
     {"_dspBayes_utest_cpp_", (DL_FUNC) &_dspBayes_utest_cpp_, 21},
     {NULL, NULL, 0}
 };
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Rcpp.h"
+#include "CoefGen.h"
+#include "CycLik.h"
+#include "DayBlock.h"
+#include "PhiGen.h"
+#include "TemperLadder.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+extern bool g_burn_status;
+
+
+
+
+// `pt_specs` provides the number of chains `n_temps`, the ratio `temp_ratio`
+// of the temperatures of adjacent chains, and the number of scans
+// `swap_every` between the proposed swaps.  The remaining arguments are the
+// sampler objects of the untempered chain, and the data that is needed to
+// construct the sampler objects of the other chains.  The cycle-level and
+// subject-level data and the fertile window day effects of the untempered
+// chain are shared by the other chains, since they are only read by the
+// likelihood engine (see `GammaContMH::commit_lik`).
+
+TemperLadder::TemperLadder(const Rcpp::NumericVector& pt_specs,
+			   const WGen& W,
+			   XiGen& xi,
+			   CoefGen& coefs,
+			   PhiGen& phi,
+			   UProdBeta& ubeta,
+			   const double* U,
+			   dsp_idx_t n_days,
+			   Rcpp::List& gamma_specs,
+			   const Rcpp::NumericVector& phi_specs,
+			   int n_samp) :
+    // initialization list
+    m_n_chains(pt_specs["n_temps"]),
+    m_swap_every(pt_specs["swap_every"]),
+    m_log_lik(m_n_chains, 0.0),
+    m_swap_accept_ctr(m_n_chains - 1, 0),
+    m_swap_prop_ctr(m_n_chains - 1, 0) {
+
+    const double temp_ratio = pt_specs["temp_ratio"];
+    if ((m_n_chains < 2) || (temp_ratio <= 1.0) || (m_swap_every < 1)) {
+	Rcpp::stop("invalid temperature ladder specifications");
+    }
+
+    Chain cold = { &xi, &coefs, &phi, &ubeta, new CycLik(W, xi, n_days) };
+    m_chains.push_back(cold);
+
+    for (int k = 1; k < m_n_chains; ++k) {
+
+	DayBlock* subj = new DayBlock[xi.m_n_subj];
+	std::copy(xi.m_subj, xi.m_subj + xi.m_n_subj, subj);
+
+	Chain hot;
+	hot.xi = new XiGen(subj, xi.m_n_subj, n_samp, false);
+	hot.coefs = new CoefGen(U, n_days, gamma_specs, n_samp, coefs.m_levels, coefs.m_fw, NULL, false);
+	hot.phi = new PhiGen(phi_specs, n_samp, false);
+	hot.ubeta = new UProdBeta(n_days);
+	hot.lik = new CycLik(W, *hot.xi, n_days);
+	hot.lik->m_inv_temp = pow(temp_ratio, -k);
+	m_chains.push_back(hot);
+    }
+}
+
+
+
+
+TemperLadder::~TemperLadder() {
+    delete m_chains[0].lik;
+    for (int k = 1; k < m_n_chains; ++k) {
+	delete m_chains[k].xi;
+	delete m_chains[k].coefs;
+	delete m_chains[k].phi;
+	delete m_chains[k].ubeta;
+	delete m_chains[k].lik;
+    }
+}
+
+
+
+
+// perform scan `s` of each of the chains, which is the same as the scan for the
+// likelihood engine without the ladder (see `sample_chain` in Dsp.cpp), and
+// then propose the swaps if it's time to do so
+
+void TemperLadder::sample(const int* X, int s) {
+
+    for (int k = 0; k < m_n_chains; ++k) {
+	Chain& curr = m_chains[k];
+	curr.coefs->sample_lik(*curr.lik, *curr.xi, *curr.ubeta, X);
+	curr.xi->sample_lik(*curr.lik, *curr.phi);
+	curr.phi->sample(*curr.xi);
+    }
+
+    if (((s + 1) % m_swap_every) == 0) {
+	sample_swaps();
+    }
+}
+
+
+
+
+// propose a swap of the states of each pair of adjacent chains in turn,
+// starting with the untempered chain.  The sums in each `CycLik` are for the
+// values of the coefficients after the last scan, so the log-likelihood for
+// each chain doesn't require a sweep over the days.
+
+void TemperLadder::sample_swaps() {
+
+    for (int k = 0; k < m_n_chains; ++k) {
+	m_log_lik[k] = m_chains[k].lik->log_lik(m_chains[k].xi->vals());
+    }
+
+    for (int k = 0; k < m_n_chains - 1; ++k) {
+
+	const double inv_temp_diff = m_chains[k].lik->m_inv_temp - m_chains[k + 1].lik->m_inv_temp;
+	const double log_r = inv_temp_diff * (m_log_lik[k + 1] - m_log_lik[k]);
+	const bool is_accept = (log_r >= 0) || (log(R::unif_rand()) < log_r);
+
+	if (is_accept) {
+	    swap_chains(k);
+	    std::swap(m_log_lik[k], m_log_lik[k + 1]);
+	}
+
+	if (! g_burn_status) {
+	    ++m_swap_prop_ctr[k];
+	    m_swap_accept_ctr[k] += is_accept;
+	}
+    }
+}
+
+
+
+
+// exchange the states of chains `k` and `k + 1`.  The temperatures, and the
+// tuning parameters of the Metropolis-Hastings steps which were adapted for the
+// temperatures, stay with the chains.
+
+void TemperLadder::swap_chains(int k) {
+
+    Chain& a = m_chains[k];
+    Chain& b = m_chains[k + 1];
+
+    a.xi->swap_state(*b.xi);
+    a.coefs->swap_state(*b.coefs);
+    a.phi->swap_state(*b.phi);
+    a.ubeta->swap_state(*b.ubeta);
+    std::swap(a.lik->m_cyc_sums, b.lik->m_cyc_sums);
+    std::swap(a.lik->m_subj_sums, b.lik->m_subj_sums);
+}
+
+
+
+
+// recalculate `exp(U * beta)` for the tempered chains to remove the
+// accumulated rounding error (the untempered chain is handled by the caller)
+
+void TemperLadder::update_exp() {
+    for (int k = 1; k < m_n_chains; ++k) {
+	m_chains[k].ubeta->update_exp();
+    }
+}
+
+
+
+
+// the acceptance rate after the burn-in phase of the swaps between each pair of
+// adjacent chains
+
+Rcpp::NumericVector TemperLadder::swap_rates() const {
+
+    Rcpp::NumericVector out(m_n_chains - 1);
+    for (int k = 0; k < m_n_chains - 1; ++k) {
+	out[k] = (m_swap_prop_ctr[k] > 0) ?
+	    ((double) m_swap_accept_ctr[k] / m_swap_prop_ctr[k]) :
+	    NA_REAL;
+    }
+
+    return out;
+}
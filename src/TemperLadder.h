@@ -0,0 +1,87 @@
+#ifndef DSP_BAYES_SRC_TEMPER_LADDER_H
+#define DSP_BAYES_SRC_TEMPER_LADDER_H
+
+#include <vector>
+#include "Rcpp.h"
+#include "CoefGen.h"
+#include "CycLik.h"
+#include "IdxType.h"
+#include "PhiGen.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+
+// a ladder of chains for parallel tempering (replica exchange).  Chain `k` of
+// the ladder targets the posterior distribution with the likelihood of the
+// pregnancy outcomes of the cycles raised to the power `1 / T_k` (see
+// CycLik.h), where `T_k = ratio^k`, so that the chains at the higher
+// temperatures move more freely between e.g. the point mass at 1 and the
+// continuous part of the prior for the coefficients.  Every `m_swap_every`
+// scans a swap of the states of each pair of adjacent chains is proposed, which
+// is accepted with probability
+//
+//     min{ 1, exp((1 / T_k - 1 / T_{k+1}) * (L_{k+1} - L_k)) }
+//
+// where `L_k` is the untempered log-likelihood for the state of chain `k`.
+//
+// Chain 0 is the untempered chain, which is the one whose samples are returned
+// to the user.  Its sampler objects are owned by the caller and are the same
+// objects as are used when the ladder isn't in use, while the objects of the
+// other chains are owned by the ladder and don't record their samples of the
+// coefficients, xi, or phi.  The chains are updated one after the other in the
+// same thread, since the random number generator and the global sampler state
+// are shared.
+//
+// Missing data isn't supported, since the imputed values would be shared by
+// the chains while each chain requires its own imputations given its own
+// tempered distribution.
+
+class TemperLadder {
+
+public:
+
+    // the sampler objects of each chain of the ladder
+    struct Chain {
+	XiGen* xi;
+	CoefGen* coefs;
+	PhiGen* phi;
+	UProdBeta* ubeta;
+	CycLik* lik;
+    };
+
+    std::vector<Chain> m_chains;
+    const int m_n_chains;
+    const int m_swap_every;
+
+    // the untempered log-likelihood for the state of each chain, which is
+    // calculated when the swaps are proposed
+    std::vector<double> m_log_lik;
+
+    // the number of accepted swaps and the number of proposed swaps after the
+    // burn-in phase for each pair of adjacent chains
+    std::vector<int> m_swap_accept_ctr;
+    std::vector<int> m_swap_prop_ctr;
+
+    TemperLadder(const Rcpp::NumericVector& pt_specs,
+		 const WGen& W,
+		 XiGen& xi,
+		 CoefGen& coefs,
+		 PhiGen& phi,
+		 UProdBeta& ubeta,
+		 const double* U,
+		 dsp_idx_t n_days,
+		 Rcpp::List& gamma_specs,
+		 const Rcpp::NumericVector& phi_specs,
+		 int n_samp);
+    ~TemperLadder();
+
+    void sample(const int* X, int s);
+    void sample_swaps();
+    void swap_chains(int k);
+    void update_exp();
+    Rcpp::NumericVector swap_rates() const;
+};
+
+
+#endif
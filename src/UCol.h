@@ -0,0 +1,234 @@
+#ifndef DSP_BAYES_SRC_U_COL_H
+#define DSP_BAYES_SRC_U_COL_H
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+#include "IdxType.h"
+
+// the largest number of parent columns of an interaction column
+#define U_COL_MAX_N_PARENTS 4
+
+// a parent column has a list of the days on which it is nonzero only if at most
+// 1 in `U_COL_SPARSE_RATIO` of the days are nonzero
+#define U_COL_SPARSE_RATIO 8
+
+
+// a column of the design matrix.  The column is either stored, or is an
+// interaction column that is not stored but rather is evaluated as needed as
+// the product of its parent columns.  This way an interaction column does not
+// require any storage beyond that of its parents.
+//
+// A parent is not itself required to be stored as a day-level column.  It may
+// also be a cycle-level or subject-level column, which is evaluated for a day
+// from the data for the day's cycle or subject (see ULevels.h), or a fertile
+// window day effect, which is evaluated from the day's position in the fertile
+// window (see FwDays.h).  The product stops at the first parent with a value of
+// 0, so that for the usual 0/1 parent columns the value is nonzero only for the
+// intersection of the days where each of the parents is nonzero.
+//
+// The sweeps over the days that only need the days with a nonzero value of
+// `U_h` instead use `for_each_nz`.  A sparse parent has a sorted list of the
+// days on which it is nonzero, and for an interaction column with at least one
+// sparse parent the sweep visits the intersection of the lists of its sparse
+// parents, so that the cost of a sweep is proportional to the number of nonzero
+// values of these parents rather than the number of days.  The lists are only
+// kept for the sparse parents since a list takes more space than the column
+// itself for a dense parent, and the list for a given parent is shared by each
+// of the interaction columns with that parent through a `ParentCache` (see
+// `GammaGen::create_uh`).  The lists are calculated when the column is
+// constructed, so the parent columns must not change afterwards (see
+// `get_u_interactions` in R/data_u_interactions.R).
+
+class UCol {
+
+public:
+
+    typedef std::vector<dsp_idx_t> IdxVec;
+
+    // a parent column of an interaction column.  The value for day `r` is
+    // `vals[r]` for a day-level column, `vals[ unit_idx[r] ]` for a cycle-level
+    // or subject-level column where `unit_idx` maps the days to the cycles or
+    // subjects, or for a fertile window day effect is 1 if `fw_pos[r]` is
+    // `fw_k` and 0 otherwise.  `nz_idx` is the list of the days on which the
+    // parent is nonzero, or NULL if the parent isn't sparse.
+    struct Parent {
+
+	const double* vals;
+	const int* unit_idx;
+	const signed char* fw_pos;
+	int fw_k;
+	std::shared_ptr<const IdxVec> nz_idx;
+
+	Parent() : vals(NULL), unit_idx(NULL), fw_pos(NULL), fw_k(-1) {}
+
+	double operator[](dsp_idx_t r) const {
+	    if (fw_pos != NULL) {
+		return (fw_pos[r] == fw_k) ? 1.0 : 0.0;
+	    }
+	    return (unit_idx != NULL) ? vals[ unit_idx[r] ] : vals[r];
+	}
+
+	void calc_nz_idx(dsp_idx_t n_days);
+    };
+
+    // the parents that have been created so far, indexed by the index of the
+    // parent's coefficient
+    typedef std::map<int, Parent> ParentCache;
+
+    // the stored column, or NULL for an interaction column
+    const double* m_col;
+
+    Parent m_parents[U_COL_MAX_N_PARENTS];
+    int m_n_parents;
+
+    // the indices in `m_parents` of the sparse parents
+    int m_sparse[U_COL_MAX_N_PARENTS];
+    int m_n_sparse;
+
+    UCol(const double* col) : m_col(col), m_n_parents(0), m_n_sparse(0) {}
+
+    UCol(const Parent* parents, int n_parents) :
+	m_col(NULL),
+	m_n_parents(n_parents),
+	m_n_sparse(0) {
+
+	for (int k = 0; k < n_parents; ++k) {
+	    m_parents[k] = parents[k];
+	    if (parents[k].nz_idx) {
+		m_sparse[m_n_sparse++] = k;
+	    }
+	}
+    }
+
+    double operator[](dsp_idx_t r) const {
+	if (is_stored()) {
+	    return m_col[r];
+	}
+	double val = m_parents[0][r];
+	for (int k = 1; (k < m_n_parents) && (val != 0.0); ++k) {
+	    val *= m_parents[k][r];
+	}
+	return val;
+    }
+
+    bool is_stored() const { return m_n_parents == 0; }
+
+    template <typename F> void for_each_nz(dsp_idx_t beg, dsp_idx_t end, F f) const;
+};
+
+
+
+
+// sets `nz_idx` to the list of the days on which the parent is nonzero if at
+// most 1 in `U_COL_SPARSE_RATIO` of the days are nonzero, and to NULL
+// otherwise.  The days are counted first so that no list is created for a
+// dense parent.
+
+inline void UCol::Parent::calc_nz_idx(dsp_idx_t n_days) {
+
+    dsp_idx_t n_nz = 0;
+    for (dsp_idx_t r = 0; r < n_days; ++r) {
+	if ((*this)[r] != 0.0) {
+	    ++n_nz;
+	}
+    }
+
+    if (n_nz * U_COL_SPARSE_RATIO > n_days) {
+	nz_idx.reset();
+	return;
+    }
+
+    IdxVec* curr_idx = new IdxVec;
+    curr_idx->reserve(n_nz);
+    for (dsp_idx_t r = 0; r < n_days; ++r) {
+	if ((*this)[r] != 0.0) {
+	    curr_idx->push_back(r);
+	}
+    }
+    nz_idx = std::shared_ptr<const IdxVec>(curr_idx);
+}
+
+
+
+
+// call `f(r, U_h[r])` for each day `r` in `[beg, end)` with a nonzero value of
+// `U_h`, in increasing order of `r`.  For an interaction column without any
+// sparse parents each of the days is evaluated.  Otherwise the intersection of
+// the sparse parents' lists is found by repeatedly advancing each list to the
+// largest of the current days of the lists, where each advance is a binary
+// search, so that long runs of days on which only some of the parents are
+// nonzero are skipped.  The dense parents are then evaluated for the days in
+// the intersection.
+
+template <typename F>
+inline void UCol::for_each_nz(dsp_idx_t beg, dsp_idx_t end, F f) const {
+
+    if (is_stored()) {
+	for (dsp_idx_t r = beg; r < end; ++r) {
+	    if (m_col[r] != 0.0) {
+		f(r, m_col[r]);
+	    }
+	}
+	return;
+    }
+    else if (m_n_sparse == 0) {
+	for (dsp_idx_t r = beg; r < end; ++r) {
+	    const double u_hr = (*this)[r];
+	    if (u_hr != 0.0) {
+		f(r, u_hr);
+	    }
+	}
+	return;
+    }
+
+    // the current position in each sparse parent's list and the end of the
+    // list
+    const dsp_idx_t* pos[U_COL_MAX_N_PARENTS];
+    const dsp_idx_t* last[U_COL_MAX_N_PARENTS];
+    for (int s = 0; s < m_n_sparse; ++s) {
+	const IdxVec& nz_idx = *m_parents[ m_sparse[s] ].nz_idx;
+	last[s] = nz_idx.data() + nz_idx.size();
+	pos[s] = std::lower_bound(nz_idx.data(), last[s], beg);
+    }
+
+    while (true) {
+
+	// the smallest day that could be in the intersection
+	dsp_idx_t cand = beg;
+	for (int s = 0; s < m_n_sparse; ++s) {
+	    if (pos[s] == last[s]) {
+		return;
+	    }
+	    cand = std::max(cand, *pos[s]);
+	}
+	if (cand >= end) {
+	    return;
+	}
+
+	// advance each list to `cand`.  If each of the lists is at `cand` then
+	// it's in the intersection, and otherwise a larger candidate is tried.
+	bool is_match = true;
+	for (int s = 0; s < m_n_sparse; ++s) {
+	    pos[s] = std::lower_bound(pos[s], last[s], cand);
+	    if (pos[s] == last[s]) {
+		return;
+	    }
+	    is_match = is_match && (*pos[s] == cand);
+	}
+
+	if (is_match) {
+	    const double u_hr = (*this)[cand];
+	    if (u_hr != 0.0) {
+		f(cand, u_hr);
+	    }
+	    for (int s = 0; s < m_n_sparse; ++s) {
+		++pos[s];
+	    }
+	}
+    }
+}
+
+
+#endif
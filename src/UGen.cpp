@@ -21,6 +21,25 @@ UGen::UGen(Rcpp::NumericMatrix& u_rcpp,
 	   Rcpp::IntegerVector& preg_map,
 	   Rcpp::IntegerVector& sex_map,
 	   bool record_status) :
+    UGen(u_rcpp.begin(),
+	 u_rcpp.nrow(),
+	 miss_info,
+	 miss_type,
+	 preg_map.begin(),
+	 sex_map.begin(),
+	 record_status) {
+}
+
+
+
+
+UGen::UGen(double* U,
+	   int n_days,
+	   Rcpp::List& miss_info,
+	   Rcpp::IntegerVector& miss_type,
+	   const int* preg_map,
+	   const int* sex_map,
+	   bool record_status) :
     m_vars(new UGenVar*[miss_info.size()]),
     m_n_vars(miss_info.size()),
     m_record_status(record_status)
@@ -35,9 +54,10 @@ UGen::UGen(Rcpp::NumericMatrix& u_rcpp,
 
 	    Rcpp::IntegerVector var_info         (as<Rcpp::IntegerVector>(curr_var["var_info"]));
 	    Rcpp::NumericVector log_u_prior_probs(as<Rcpp::NumericVector>(curr_var["log_u_prior_probs"]));
-	    Rcpp::List var_block_list            (as<Rcpp::List>(curr_var["var_block_list"]));
+	    SEXP var_block_list                  (curr_var["var_block_list"]);
 
-	    m_vars[i] = new UGenVarCateg(u_rcpp,
+	    m_vars[i] = new UGenVarCateg(U,
+					 n_days,
 					 var_info,
 					 log_u_prior_probs,
 					 var_block_list,
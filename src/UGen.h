@@ -29,6 +29,13 @@ public:
 	 Rcpp::IntegerVector& preg_map,
 	 Rcpp::IntegerVector& sex_map,
 	 bool record_status);
+    UGen(double* U,
+	 int n_days,
+	 Rcpp::List& miss_info,
+	 Rcpp::IntegerVector& miss_type,
+	 const int* preg_map,
+	 const int* sex_map,
+	 bool record_status);
     ~UGen();
 
     void sample(const WGen& W,
@@ -11,14 +11,15 @@ UGenVar::UGenVar() :
 }
 
 
-UGenVar::UGenVar(Rcpp::NumericMatrix& u_rcpp,
-		 Rcpp::IntegerVector& preg_map,
-		 Rcpp::IntegerVector& sex_map,
+UGenVar::UGenVar(double* U,
+		 dsp_idx_t n_days,
+		 const int* preg_map,
+		 const int* sex_map,
 		 int u_col,
 		 bool record_status):
-    m_u_var_col(u_rcpp.begin() + ((int) u_rcpp.nrow() * u_col)),
-    m_n_days(u_rcpp.nrow()),
-    m_w_idx(preg_map.begin()),
-    m_x_idx(sex_map.begin()),
+    m_u_var_col(U + (n_days * u_col)),
+    m_n_days(n_days),
+    m_w_idx(preg_map),
+    m_x_idx(sex_map),
     m_record_status(record_status) {
 }
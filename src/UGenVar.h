@@ -20,7 +20,7 @@ public:
     struct UMissBlock;
 
     double* const m_u_var_col;
-    const int m_n_days;
+    const dsp_idx_t m_n_days;
 
     const int* const m_w_idx;
     const int* const m_x_idx;
@@ -31,9 +31,10 @@ public:
     UGenVar();
     virtual ~UGenVar() {}
 
-    UGenVar(Rcpp::NumericMatrix& u_rcpp,
-	    Rcpp::IntegerVector& preg_map,
-	    Rcpp::IntegerVector& sex_map,
+    UGenVar(double* U,
+	    dsp_idx_t n_days,
+	    const int* preg_map,
+	    const int* sex_map,
 	    int u_col,
 	    bool record_status);
 
@@ -72,10 +73,18 @@ public:
     UGenVarCateg(Rcpp::NumericMatrix& u_rcpp,
 		 Rcpp::IntegerVector& var_info,
 		 Rcpp::NumericVector& log_u_prior_probs,
-		 Rcpp::List& var_block_list,
+		 SEXP var_block_list,
 		 Rcpp::IntegerVector& preg_map,
 		 Rcpp::IntegerVector& sex_map,
 		 bool record_status);
+    UGenVarCateg(double* U,
+		 dsp_idx_t n_days,
+		 Rcpp::IntegerVector& var_info,
+		 Rcpp::NumericVector& log_u_prior_probs,
+		 SEXP var_block_list,
+		 const int* preg_map,
+		 const int* sex_map,
+		 bool record_status);
     ~UGenVarCateg();
 
     void sample(const WGen& W,
@@ -105,6 +114,8 @@ public:
 
     void update_u(const UMissBlockCateg* const miss_block);
 
+    static int get_u_col_start(const Rcpp::IntegerVector& var_info);
+
     static void update_ubeta(UProdBeta& ubeta,
 			     const int u_categ,
 			     const double* alt_exp_ubeta_vals,
@@ -119,14 +130,17 @@ public:
 
 
 
+// the offsets into the day-specific data may be arbitrarily large, while the
+// number of days in a block is small
+
 struct UGenVar::UMissBlock {
 
-    int beg_day_idx;
+    dsp_idx_t beg_day_idx;
     int n_days;
 
-    int beg_w_idx;
+    dsp_idx_t beg_w_idx;
 
-    int beg_sex_idx;
+    dsp_idx_t beg_sex_idx;
     int n_sex_days;
 
     int subj_idx;
@@ -140,10 +154,10 @@ struct UGenVar::UMissBlock {
 	subj_idx(0) {
     }
 
-    UMissBlock(int beg_day_idx,
+    UMissBlock(dsp_idx_t beg_day_idx,
 	       int n_days,
-	       int beg_w_idx,
-	       int beg_sex_idx,
+	       dsp_idx_t beg_w_idx,
+	       dsp_idx_t beg_sex_idx,
 	       int n_sex_days,
 	       int u_col,
 	       int subj_idx) :
@@ -168,10 +182,10 @@ struct UGenVarCateg::UMissBlockCateg : public UGenVar::UMissBlock {
 	u_col(0) {
     }
 
-    UMissBlockCateg(int beg_day_idx,
+    UMissBlockCateg(dsp_idx_t beg_day_idx,
 		    int n_days,
-		    int beg_w_idx,
-		    int beg_sex_idx,
+		    dsp_idx_t beg_w_idx,
+		    dsp_idx_t beg_sex_idx,
 		    int n_sex_days,
 		    int u_col,
 		    int subj_idx) :
@@ -180,6 +194,7 @@ struct UGenVarCateg::UMissBlockCateg : public UGenVar::UMissBlock {
     }
 
     static UMissBlockCateg* list_to_arr(Rcpp::List& block_list);
+    static UMissBlockCateg* mat_to_arr(Rcpp::IntegerMatrix& block_mat);
 };
 
 
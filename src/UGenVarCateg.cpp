@@ -3,6 +3,7 @@
 #include "Rcpp.h"
 
 #include "CoefGen.h"
+#include "DayBlock.h"
 #include "UGenVar.h"
 #include "UProdBeta.h"
 #include "UProdTau.h"
@@ -18,11 +19,32 @@
 UGenVarCateg::UGenVarCateg(Rcpp::NumericMatrix& u_rcpp,
 			   Rcpp::IntegerVector& var_info,
 			   Rcpp::NumericVector& log_u_prior_probs,
-			   Rcpp::List& var_block_list,
+			   SEXP var_block_list,
 			   Rcpp::IntegerVector& preg_map,
 			   Rcpp::IntegerVector& sex_map,
 			   bool record_status) :
-    UGenVar(u_rcpp, preg_map, sex_map, var_info["col_start"], record_status),
+    UGenVarCateg(u_rcpp.begin(),
+		 u_rcpp.nrow(),
+		 var_info,
+		 log_u_prior_probs,
+		 var_block_list,
+		 preg_map.begin(),
+		 sex_map.begin(),
+		 record_status) {
+}
+
+
+
+
+UGenVarCateg::UGenVarCateg(double* U,
+			   dsp_idx_t n_days,
+			   Rcpp::IntegerVector& var_info,
+			   Rcpp::NumericVector& log_u_prior_probs,
+			   SEXP var_block_list,
+			   const int* preg_map,
+			   const int* sex_map,
+			   bool record_status) :
+    UGenVar(U, n_days, preg_map, sex_map, get_u_col_start(var_info), record_status),
     m_col_start(var_info["col_start"]),
     m_col_end(var_info["col_end"]),
     m_ref_col(var_info["ref_col"]),
@@ -30,10 +52,10 @@ UGenVarCateg::UGenVarCateg(Rcpp::NumericMatrix& u_rcpp,
     m_max_n_days_miss(var_info["max_n_days_miss"]),
     m_max_n_sex_days_miss(var_info["max_n_sex_days_miss"]),
     m_log_u_prior_probs(log_u_prior_probs.begin()),
-    m_miss_block(UMissBlockCateg::list_to_arr(var_block_list)),
-    m_end_block(m_miss_block + var_block_list.size())
+    m_miss_block(block_descr_to_arr<UMissBlockCateg>(var_block_list)),
+    m_end_block(m_miss_block + block_descr_size(var_block_list))
 {
-    m_vals_rcpp = Rcpp::NumericVector(record_status ? m_n_categs * var_block_list.size() : 0);
+    m_vals_rcpp = Rcpp::NumericVector(record_status ? (dsp_idx_t) m_n_categs * block_descr_size(var_block_list) : 0);
 }
 
 
@@ -56,10 +78,10 @@ UGenVarCateg::UMissBlockCateg* UGenVarCateg::UMissBlockCateg::list_to_arr(Rcpp::
     for (int t = 0; t < block_list.size(); ++t) {
 
     	Rcpp::IntegerVector block_list_t = Rcpp::as<Rcpp::IntegerVector>(block_list[t]);
-    	block_arr[t] = UMissBlockCateg(block_list_t["beg_day_idx"],
+    	block_arr[t] = UMissBlockCateg((int) block_list_t["beg_day_idx"],
 				       block_list_t["n_days"],
-				       block_list_t["beg_w_idx"],
-				       block_list_t["beg_sex_idx"],
+				       (int) block_list_t["beg_w_idx"],
+				       (int) block_list_t["beg_sex_idx"],
 				       block_list_t["n_sex_days"],
 				       block_list_t["u_col"],
 				       block_list_t["subj_idx"]);
@@ -71,6 +93,42 @@ UGenVarCateg::UMissBlockCateg* UGenVarCateg::UMissBlockCateg::list_to_arr(Rcpp::
 
 
 
+// similar to `UMissBlockCateg::list_to_arr`, but now the blocks are specified
+// by the rows of an integer matrix with columns having the same names as the
+// list elements
+
+UGenVarCateg::UMissBlockCateg* UGenVarCateg::UMissBlockCateg::mat_to_arr(Rcpp::IntegerMatrix& block_mat) {
+
+    const int n_blocks = block_mat.nrow();
+    UMissBlockCateg* block_arr = new UMissBlockCateg[n_blocks];
+    if (n_blocks == 0) {
+	return block_arr;
+    }
+
+    const int* beg_day_idx = block_mat_col(block_mat, "beg_day_idx");
+    const int* n_days      = block_mat_col(block_mat, "n_days");
+    const int* beg_w_idx   = block_mat_col(block_mat, "beg_w_idx");
+    const int* beg_sex_idx = block_mat_col(block_mat, "beg_sex_idx");
+    const int* n_sex_days  = block_mat_col(block_mat, "n_sex_days");
+    const int* u_col       = block_mat_col(block_mat, "u_col");
+    const int* subj_idx    = block_mat_col(block_mat, "subj_idx");
+
+    for (int t = 0; t < n_blocks; ++t) {
+	block_arr[t] = UMissBlockCateg(beg_day_idx[t],
+				       n_days[t],
+				       beg_w_idx[t],
+				       beg_sex_idx[t],
+				       n_sex_days[t],
+				       u_col[t],
+				       subj_idx[t]);
+    }
+
+    return block_arr;
+}
+
+
+
+
 
 //     // calc p(W | ubeta) perms
 
@@ -191,7 +249,7 @@ void UGenVarCateg::calc_log_condit_w(double* log_condit_w_probs,
     const int block_n_days = miss_block->n_days;
     const int block_u_col  = miss_block->u_col;
 
-    const double* block_exp_ubeta_vals = ubeta.exp_vals() + miss_block->beg_day_idx;
+    const dsp_store_t* block_exp_ubeta_vals = ubeta.exp_vals() + miss_block->beg_day_idx;
     const int* block_w_idx             = m_w_idx + miss_block->beg_w_idx;
     const int* block_x_vals            = X.vals() + miss_block->beg_day_idx;
 
@@ -279,9 +337,9 @@ void UGenVarCateg::calc_log_condit_x(double* log_condit_x_probs,
 				     const UProdTau& utau,
 				     const UMissBlockCateg* const miss_block) const {
 
-    const int block_beg_sex_idx = miss_block->beg_sex_idx;
-    const int block_n_sex_days  = miss_block->n_sex_days;
-    const int block_u_col       = miss_block->u_col;
+    const dsp_idx_t block_beg_sex_idx = miss_block->beg_sex_idx;
+    const int block_n_sex_days        = miss_block->n_sex_days;
+    const int block_u_col             = miss_block->u_col;
 
     const int* x_vals                = X.vals();
     const XGen::XMissDay* x_miss_day = X.miss_day();
@@ -317,7 +375,7 @@ void UGenVarCateg::calc_log_condit_x(double* log_condit_x_probs,
 	for (int r = 0; r < block_n_sex_days; ++r) {
 
 	    const int curr_x_day_idx = m_x_idx[block_beg_sex_idx + r];
-	    const int curr_day_idx   = x_miss_day[curr_x_day_idx].idx;
+	    const dsp_idx_t curr_day_idx = x_miss_day[curr_x_day_idx].idx;
 	    const int curr_sex_prev  = x_miss_day[curr_x_day_idx].prev;
 
 	    // a value of 0 or -2 corresponds to "no sex" and "inputed no sex"
@@ -397,11 +455,11 @@ void UGenVarCateg::update_ubeta(UProdBeta& ubeta,
 				const double* alt_exp_ubeta_vals,
 				const UMissBlockCateg* const miss_block) {
 
-    const int block_beg_day_idx = miss_block->beg_day_idx;
-    const int block_n_days      = miss_block->n_days;
+    const dsp_idx_t block_beg_day_idx = miss_block->beg_day_idx;
+    const int block_n_days            = miss_block->n_days;
 
-    double* block_ubeta_vals             = ubeta.vals() + block_beg_day_idx;
-    double* block_exp_ubeta_vals         = ubeta.exp_vals() + block_beg_day_idx;
+    dsp_store_t* block_ubeta_vals        = ubeta.vals() + block_beg_day_idx;
+    dsp_store_t* block_exp_ubeta_vals    = ubeta.exp_vals() + block_beg_day_idx;
     const double* updated_exp_ubeta_vals = alt_exp_ubeta_vals + (u_categ * block_n_days);
 
     for (int r = 0; r < block_n_days; ++r) {
@@ -421,8 +479,8 @@ void UGenVarCateg::update_utau(UProdTau& utau,
 			       const double* alt_utau_vals,
 			       const UMissBlockCateg* const miss_block) const {
 
-    const int block_beg_sex_idx = miss_block->beg_sex_idx;
-    const int block_n_sex_days  = miss_block->n_sex_days;
+    const dsp_idx_t block_beg_sex_idx = miss_block->beg_sex_idx;
+    const int block_n_sex_days        = miss_block->n_sex_days;
 
     const int* block_x_idx = m_x_idx + block_beg_sex_idx;
     double* utau_vals      = utau.vals();
@@ -456,8 +514,8 @@ void UGenVarCateg::update_u(const UMissBlockCateg* const miss_block) {
 
 	// update the observations in the `j`-th column that are affected by the
 	// current missing covariate
-	int block_end_idx = miss_block->beg_day_idx + miss_block->n_days;
-	for (int i = miss_block->beg_day_idx; i < block_end_idx; ++i) {
+	dsp_idx_t block_end_idx = miss_block->beg_day_idx + miss_block->n_days;
+	for (dsp_idx_t i = miss_block->beg_day_idx; i < block_end_idx; ++i) {
 	    curr_u_col[i] = col_val;
 	}
 
@@ -465,3 +523,18 @@ void UGenVarCateg::update_u(const UMissBlockCateg* const miss_block) {
 	curr_u_col += m_n_days;
     }
 }
+
+
+
+
+// the index in `U` of the first column for the variable.  Since only the
+// day-level columns are stored in `U`, this is given by
+// `var_info["u_col_start"]` and is in general different from the index of the
+// first coefficient `m_col_start`.  Missing variable information without a
+// `u_col_start` entry is for a `U` that stores every column.
+
+int UGenVarCateg::get_u_col_start(const Rcpp::IntegerVector& var_info) {
+    return var_info.containsElementNamed("u_col_start") ?
+	var_info["u_col_start"] :
+	var_info["col_start"];
+}
@@ -0,0 +1,208 @@
+#include <cmath>
+#include "DayChunks.h"
+#include "ULevels.h"
+#include "global_vars.h"
+
+
+ULevels::ULevels(const double* u_cyc,
+		 int n_cyc,
+		 const double* u_subj,
+		 int n_subj,
+		 const int* d2c,
+		 dsp_idx_t n_days) :
+    // initialization list
+    m_u_cyc(u_cyc),
+    m_u_subj(u_subj),
+    m_d2c(d2c),
+    m_c2s(new int[n_cyc]),
+    m_n_cyc(n_cyc),
+    m_n_subj(n_subj),
+    m_n_days(n_days),
+    m_cyc_vals(new double[n_cyc]),
+    m_cyc_vals_prev(new double[n_cyc]),
+    m_subj_vals(new double[n_subj]),
+    m_subj_vals_prev(new double[n_subj]),
+    m_cyc_ratios(new double[n_cyc]),
+    m_subj_ratios(new double[n_subj]),
+    m_cyc_exp_sums(new double[n_cyc]),
+    m_cyc_w_sums(new double[n_cyc]),
+    m_subj_exp_sums(new double[n_subj]),
+    m_subj_w_sums(new double[n_subj])
+{
+    // the terms start out at 0, in agreement with the initial values of `U *
+    // beta` in `UProdBeta`
+    for (int c = 0; c < m_n_cyc; ++c) {
+	m_cyc_vals[c] = 0.0;
+	m_cyc_vals_prev[c] = 0.0;
+    }
+    for (int i = 0; i < m_n_subj; ++i) {
+	m_subj_vals[i] = 0.0;
+	m_subj_vals_prev[i] = 0.0;
+    }
+
+    // the days in a cycle all belong to the same subject
+    for (dsp_idx_t r = 0; r < m_n_days; ++r) {
+	m_c2s[ m_d2c[r] ] = d2s[r];
+    }
+}
+
+
+
+
+ULevels::~ULevels() {
+    delete[] m_c2s;
+    delete[] m_cyc_vals;
+    delete[] m_cyc_vals_prev;
+    delete[] m_subj_vals;
+    delete[] m_subj_vals_prev;
+    delete[] m_cyc_ratios;
+    delete[] m_subj_ratios;
+    delete[] m_cyc_exp_sums;
+    delete[] m_cyc_w_sums;
+    delete[] m_subj_exp_sums;
+    delete[] m_subj_w_sums;
+}
+
+
+
+
+// calculate the cycle-specific sums of `exp(U * beta)` over the intercourse
+// days and of `W`, where the cycle and subject terms are removed from `U *
+// beta`.  Note that the values of `U * beta` in `ubeta` include the cycle and
+// subject terms as of the last call to `compose`, so that the terms are
+// calculated from `exp(U * beta)` by dividing by the exponentiated terms for the
+// cycle.
+
+void ULevels::calc_cyc_stats(const WGen& W, const UProdBeta& ubeta, const int* X) {
+
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+
+    // `m_cyc_ratios` temporarily holds the exponentiated terms to remove
+    for (int c = 0; c < m_n_cyc; ++c) {
+	m_cyc_exp_sums[c] = 0.0;
+	m_cyc_w_sums[c] = 0.0;
+	m_cyc_ratios[c] = exp(-(m_cyc_vals_prev[c] + m_subj_vals_prev[ m_c2s[c] ]));
+    }
+
+    // each iteration adds the contribution of day `r` to the sum for its cycle
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+	    if (X[r]) {
+		const int cyc = m_d2c[r];
+		m_cyc_exp_sums[cyc] += X[r] * ubeta_exp_vals[r] * m_cyc_ratios[cyc];
+	    }
+	}
+    }
+
+    // `W` is only nonzero for the days in a pregnancy cycle
+    const int* w_vals = W.vals();
+    const int* w_days_idx = W.days_idx();
+    for (dsp_idx_t r = 0; r < W.n_preg_days(); ++r) {
+	m_cyc_w_sums[ m_d2c[ w_days_idx[r] ] ] += w_vals[r];
+    }
+}
+
+
+
+
+// calculate the subject-specific sums of `exp(U * beta)` over the intercourse
+// days and of `W`, where the subject terms are removed from `U * beta`.  This
+// uses the current values of the cycle terms, so it must be called after the
+// cycle-level coefficients have been sampled in the current scan.
+
+void ULevels::calc_subj_stats() {
+
+    for (int i = 0; i < m_n_subj; ++i) {
+	m_subj_exp_sums[i] = 0.0;
+	m_subj_w_sums[i] = 0.0;
+    }
+
+    for (int c = 0; c < m_n_cyc; ++c) {
+	const int subj = m_c2s[c];
+	m_subj_exp_sums[subj] += exp(m_cyc_vals[c]) * m_cyc_exp_sums[c];
+	m_subj_w_sums[subj] += m_cyc_w_sums[c];
+    }
+}
+
+
+
+
+// apply the changes in the cycle and subject terms since the last call to the
+// values of `U * beta` and `exp(U * beta)` in `ubeta`.  `exp(U * beta)` is
+// updated by multiplying by the exponentiated differences, which are calculated
+// once per cycle and subject rather than once per day.
+
+void ULevels::compose(UProdBeta& ubeta) {
+
+    dsp_store_t* ubeta_vals = ubeta.vals();
+    dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+
+    for (int c = 0; c < m_n_cyc; ++c) {
+	m_cyc_vals_prev[c] = m_cyc_vals[c] - m_cyc_vals_prev[c];
+	m_cyc_ratios[c] = exp(m_cyc_vals_prev[c]);
+    }
+    for (int i = 0; i < m_n_subj; ++i) {
+	m_subj_vals_prev[i] = m_subj_vals[i] - m_subj_vals_prev[i];
+	m_subj_ratios[i] = exp(m_subj_vals_prev[i]);
+    }
+
+    // the `prev` arrays temporarily hold the differences
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+	    const int cyc = m_d2c[r];
+	    const int subj = d2s[r];
+	    ubeta_vals[r] += m_cyc_vals_prev[cyc] + m_subj_vals_prev[subj];
+	    ubeta_exp_vals[r] *= m_cyc_ratios[cyc] * m_subj_ratios[subj];
+	}
+    }
+
+    for (int c = 0; c < m_n_cyc; ++c) {
+	m_cyc_vals_prev[c] = m_cyc_vals[c];
+    }
+    for (int i = 0; i < m_n_subj; ++i) {
+	m_subj_vals_prev[i] = m_subj_vals[i];
+    }
+}
+
+
+
+
+// points to the beginning of the data for the `h`-th column of the cycle-level
+// or subject-level columns
+
+const double* ULevels::u_col(int level, int h) const {
+    return (level == U_LEVEL_CYC) ?
+	m_u_cyc + ((dsp_idx_t) h) * m_n_cyc :
+	m_u_subj + ((dsp_idx_t) h) * m_n_subj;
+}
+
+
+
+
+const double* ULevels::w_sums(int level) const {
+    return (level == U_LEVEL_CYC) ? m_cyc_w_sums : m_subj_w_sums;
+}
+
+
+
+
+// the sum over the intercourse days in the `u`-th cycle or subject of `xi_i *
+// exp(U * beta)`, using the current values of the cycle and subject terms
+
+double ULevels::unit_mean(int level, int u, const double* xi_vals) const {
+
+    if (level == U_LEVEL_CYC) {
+	const int subj = m_c2s[u];
+	return xi_vals[subj] * exp(m_cyc_vals[u] + m_subj_vals[subj]) * m_cyc_exp_sums[u];
+    }
+
+    return xi_vals[u] * exp(m_subj_vals[u]) * m_subj_exp_sums[u];
+}
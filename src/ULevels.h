@@ -0,0 +1,91 @@
+#ifndef DSP_BAYES_SRC_U_LEVELS_H
+#define DSP_BAYES_SRC_U_LEVELS_H
+
+#include "IdxType.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+
+// the level at which a column of the design matrix varies
+#define U_LEVEL_DAY   0
+#define U_LEVEL_CYC   1
+#define U_LEVEL_SUBJ  2
+
+
+// the subject-level and cycle-level columns of the design matrix.
+//
+// Baseline covariates (e.g. age) and cycle-level covariates are constant over
+// the days in a subject or cycle, respectively, so that they are stored once
+// per subject or cycle rather than replicated for every day.  For such a column
+// `U_h` the sufficient statistics needed to sample `gamma_h` only depend on the
+// day-specific data through sums over the days in each subject or cycle, so
+// that the samplers for these columns loop over the subjects or cycles rather
+// than over the days.  The sums are calculated once per scan by
+// `calc_cyc_stats` and `calc_subj_stats`.
+//
+// The day-specific values of `U * beta` in `UProdBeta` are the sum of a day
+// term, a cycle term, and a subject term.  The cycle and subject terms are
+// tracked separately in `m_cyc_vals` and `m_subj_vals` while the cycle-level
+// and subject-level coefficients are sampled, and the changes are then applied
+// to `UProdBeta` in a single sweep over the days by `compose`.  Thus a scan
+// requires two sweeps over the days for all of the cycle-level and
+// subject-level coefficients combined, rather than one sweep per coefficient.
+
+class ULevels {
+
+public:
+
+    // the cycle-level and subject-level columns stored in column-major order,
+    // with one row per cycle and subject, respectively
+    const double* m_u_cyc;
+    const double* m_u_subj;
+
+    // maps each day to the index of its cycle, and each cycle to the index of
+    // its subject
+    const int* m_d2c;
+    int* m_c2s;
+
+    const int m_n_cyc;
+    const int m_n_subj;
+    const dsp_idx_t m_n_days;
+
+    // the cycle and subject terms of `U * beta`, and the values of these terms
+    // when `UProdBeta` was last composed
+    double* m_cyc_vals;
+    double* m_cyc_vals_prev;
+    double* m_subj_vals;
+    double* m_subj_vals_prev;
+
+    // scratch space for the exponentiated cycle and subject terms used by
+    // `calc_cyc_stats` and `compose`
+    double* m_cyc_ratios;
+    double* m_subj_ratios;
+
+    // for each cycle, the sum over the intercourse days of `exp(U * beta)`
+    // excluding the cycle and subject terms, and the sum of `W`.  Similarly for
+    // each subject, except that the cycle terms are included.
+    double* m_cyc_exp_sums;
+    double* m_cyc_w_sums;
+    double* m_subj_exp_sums;
+    double* m_subj_w_sums;
+
+    ULevels(const double* u_cyc,
+	    int n_cyc,
+	    const double* u_subj,
+	    int n_subj,
+	    const int* d2c,
+	    dsp_idx_t n_days);
+    ~ULevels();
+
+    void calc_cyc_stats(const WGen& W, const UProdBeta& ubeta, const int* X);
+    void calc_subj_stats();
+    void compose(UProdBeta& ubeta);
+
+    const double* u_col(int level, int h) const;
+    int n_units(int level) const { return (level == U_LEVEL_CYC) ? m_n_cyc : m_n_subj; }
+    double* vals(int level) { return (level == U_LEVEL_CYC) ? m_cyc_vals : m_subj_vals; }
+    const double* w_sums(int level) const;
+    double unit_mean(int level, int u, const double* xi_vals) const;
+};
+
+
+#endif
@@ -0,0 +1,228 @@
+#include <cmath>
+#include <map>
+#include <vector>
+#include "DayChunks.h"
+#include "UPatterns.h"
+#include "global_vars.h"
+
+
+// `cols` are the day-level columns, where the k-th column corresponds to the
+// `k` argument of `update`, `exp_sum`, and `w_sum`.  Each pattern is identified
+// by the indices of the columns in `cols` that have a value of 1.
+
+UPatterns::UPatterns(const std::vector<UCol>& cols, dsp_idx_t n_days) :
+    // initialization list
+    m_day_pat(new int[n_days]),
+    m_n_days(n_days),
+    m_n_pat(0),
+    m_col_pats(cols.size())
+{
+    std::map< std::vector<int>, int > pat_map;
+    std::vector<int> curr_pat;
+
+    for (dsp_idx_t r = 0; r < m_n_days; ++r) {
+
+	curr_pat.clear();
+	for (size_t k = 0; k < cols.size(); ++k) {
+	    if (cols[k][r]) {
+		curr_pat.push_back(k);
+	    }
+	}
+
+	// case: a new pattern, so add it to the patterns for each of its
+	// columns
+	std::map< std::vector<int>, int >::iterator it = pat_map.find(curr_pat);
+	if (it == pat_map.end()) {
+	    it = pat_map.insert(std::make_pair(curr_pat, m_n_pat)).first;
+	    for (size_t t = 0; t < curr_pat.size(); ++t) {
+		m_col_pats[ curr_pat[t] ].push_back(m_n_pat);
+	    }
+	    ++m_n_pat;
+	}
+
+	m_day_pat[r] = it->second;
+    }
+
+    // the coefficients start out at 0, in agreement with the initial values of
+    // `U * beta` in `UProdBeta`
+    m_beta_vals.assign(m_n_pat, 0.0);
+    m_beta_prev.assign(m_n_pat, 0.0);
+    m_gam_vals.assign(m_n_pat, 1.0);
+    m_gam_prev.assign(m_n_pat, 1.0);
+    m_exp_sums.assign(m_n_pat, 0.0);
+    m_w_sums.assign(m_n_pat, 0.0);
+}
+
+
+
+
+UPatterns::~UPatterns() {
+    delete[] m_day_pat;
+}
+
+
+
+
+// whether each of the columns only has values of 0 or 1, which is required for
+// the day-level terms of `U * beta` to only depend on the patterns
+
+bool UPatterns::is_binary(const std::vector<UCol>& cols, dsp_idx_t n_days) {
+
+    for (size_t k = 0; k < cols.size(); ++k) {
+	for (dsp_idx_t r = 0; r < n_days; ++r) {
+	    const double val = cols[k][r];
+	    if ((val != 0.0) && (val != 1.0)) {
+		return false;
+	    }
+	}
+    }
+
+    return true;
+}
+
+
+
+
+// calculate `e_p` and the sum of `W` for each pattern.  Note that `U * beta` in
+// `ubeta` includes the day-level terms as of the last call to `apply`, so that
+// the terms are calculated from `exp(U * beta)` by dividing by the products for
+// the patterns.
+
+void UPatterns::calc_stats(const WGen& W, const XiGen& xi, const UProdBeta& ubeta, const int* X) {
+
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    const double* xi_vals = xi.vals();
+
+    // recalculate the products from the sums so that the rounding error from
+    // the multiplicative updates doesn't accumulate across scans
+    for (int p = 0; p < m_n_pat; ++p) {
+	m_gam_vals[p] = exp(m_beta_vals[p]);
+	m_gam_prev[p] = m_gam_vals[p];
+	m_exp_sums[p] = 0.0;
+	m_w_sums[p] = 0.0;
+    }
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+	    if (X[r]) {
+		m_exp_sums[ m_day_pat[r] ] += X[r] * xi_vals[ d2s[r] ] * ubeta_exp_vals[r];
+	    }
+	}
+    }
+
+    for (int p = 0; p < m_n_pat; ++p) {
+	m_exp_sums[p] /= m_gam_vals[p];
+    }
+
+    // `W` is only nonzero for the days in a pregnancy cycle
+    const int* w_vals = W.vals();
+    const int* w_days_idx = W.days_idx();
+    for (dsp_idx_t t = 0; t < W.n_preg_days(); ++t) {
+	m_w_sums[ m_day_pat[ w_days_idx[t] ] ] += w_vals[t];
+    }
+}
+
+
+
+
+// the sum over the days with `U_ijkh` equal to 1 of `X_ijk * xi_i * exp(u_ijk^T
+// beta)`, where `h` is the `k`-th column
+
+double UPatterns::exp_sum(int k) const {
+
+    const std::vector<int>& pats = m_col_pats[k];
+    double sum_val = 0.0;
+    for (size_t t = 0; t < pats.size(); ++t) {
+	sum_val += m_exp_sums[ pats[t] ] * m_gam_vals[ pats[t] ];
+    }
+
+    return sum_val;
+}
+
+
+
+
+// the sum over the days with `U_ijkh` equal to 1 of `W_ijk`, where `h` is the
+// `k`-th column
+
+double UPatterns::w_sum(int k) const {
+
+    const std::vector<int>& pats = m_col_pats[k];
+    double sum_val = 0.0;
+    for (size_t t = 0; t < pats.size(); ++t) {
+	sum_val += m_w_sums[ pats[t] ];
+    }
+
+    return sum_val;
+}
+
+
+
+
+// update the terms for the patterns that include the `k`-th column after a
+// change of `beta_diff` in its coefficient, where `gam_ratio` is
+// `exp(beta_diff)`
+
+void UPatterns::update(int k, double beta_diff, double gam_ratio) {
+
+    const std::vector<int>& pats = m_col_pats[k];
+    for (size_t t = 0; t < pats.size(); ++t) {
+	m_beta_vals[ pats[t] ] += beta_diff;
+	m_gam_vals[ pats[t] ] *= gam_ratio;
+    }
+}
+
+
+
+
+// apply the changes in the day-level terms since the last call to the values of
+// `U * beta` and `exp(U * beta)` in `ubeta`
+
+void UPatterns::apply(UProdBeta& ubeta) {
+
+    dsp_store_t* ubeta_vals = ubeta.vals();
+    dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+
+    // `m_beta_prev` and `m_gam_prev` temporarily hold the changes
+    for (int p = 0; p < m_n_pat; ++p) {
+	m_beta_prev[p] = m_beta_vals[p] - m_beta_prev[p];
+	m_gam_prev[p] = m_gam_vals[p] / m_gam_prev[p];
+    }
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t r = g_day_chunks.day_beg(c); r < chunk_end; ++r) {
+	    const int pat = m_day_pat[r];
+	    if (m_beta_prev[pat] != 0.0) {
+		ubeta_vals[r] += m_beta_prev[pat];
+		ubeta_exp_vals[r] *= m_gam_prev[pat];
+	    }
+	}
+    }
+
+    for (int p = 0; p < m_n_pat; ++p) {
+	m_beta_prev[p] = m_beta_vals[p];
+	m_gam_prev[p] = m_gam_vals[p];
+    }
+}
+
+
+
+
+// treat the changes in the day-level terms since the last call to `apply` as
+// already having been applied to `U * beta`, for when the changes were made to
+// `ubeta` directly (see `VarBayes::update_gamma`)
+
+void UPatterns::mark_applied() {
+    for (int p = 0; p < m_n_pat; ++p) {
+	m_beta_prev[p] = m_beta_vals[p];
+	m_gam_prev[p] = m_gam_vals[p];
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef DSP_BAYES_SRC_U_PATTERNS_H
+#define DSP_BAYES_SRC_U_PATTERNS_H
+
+#include <vector>
+#include "IdxType.h"
+#include "UCol.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+
+// the covariate patterns of the day-level categorical columns of the design
+// matrix.
+//
+// When each of the day-level columns is a 0/1 column with a categorical
+// coefficient, the day-level terms of `U * beta` only depend on the day
+// through the set of the columns that have a value of 1 for the day, which we
+// refer to as the pattern of the day.  The sums needed to sample `gamma_h`
+// then decompose as
+//
+//     sum_{ijk: U_ijkh == 1} X_ijk * xi_i * exp(u_ijk^T beta)
+//         = sum_{p: h in p} e_p * prod_{l in p} gamma_l,
+//
+// where `e_p` is the sum of `X_ijk * xi_i * exp(u_ijk^T beta)` over the days
+// with pattern `p`, with the day-level terms removed.  `e_p` doesn't depend on
+// the day-level coefficients, so that it is calculated once per scan by
+// `calc_stats`, and similarly for the sum of `W` for each pattern.  After that,
+// sampling `gamma_h` and updating the products for the patterns that include
+// `h` only requires a loop over those patterns, so that the cost of sampling
+// the day-level coefficients doesn't depend on the number of days.  The
+// changes are applied to `U * beta` in a single sweep by `apply`.
+
+class UPatterns {
+
+public:
+
+    // the index of the pattern of each day
+    int* m_day_pat;
+
+    const dsp_idx_t m_n_days;
+    int m_n_pat;
+
+    // for each column, the indices of the patterns that include the column
+    std::vector< std::vector<int> > m_col_pats;
+
+    // for each pattern, the sum of the day-level coefficients for the columns
+    // in the pattern and the product of the corresponding `gamma_l`, and the
+    // values of these when `U * beta` was last updated by `apply`
+    std::vector<double> m_beta_vals;
+    std::vector<double> m_beta_prev;
+    std::vector<double> m_gam_vals;
+    std::vector<double> m_gam_prev;
+
+    // for each pattern, the sums `e_p` and the sum of `W` over the days with
+    // the pattern
+    std::vector<double> m_exp_sums;
+    std::vector<double> m_w_sums;
+
+    UPatterns(const std::vector<UCol>& cols, dsp_idx_t n_days);
+    ~UPatterns();
+
+    void calc_stats(const WGen& W, const XiGen& xi, const UProdBeta& ubeta, const int* X);
+    void update(int k, double beta_diff, double gam_ratio);
+    void apply(UProdBeta& ubeta);
+    void mark_applied();
+
+    double exp_sum(int k) const;
+    double w_sum(int k) const;
+
+    static bool is_binary(const std::vector<UCol>& cols, dsp_idx_t n_days);
+};
+
+
+#endif
@@ -1,16 +1,43 @@
+#include <algorithm>
 #include <cmath>
+#include <string>
+#include "DayChunks.h"
+#include "ModelFile.h"
 #include "UProdBeta.h"
 
 
-UProdBeta::UProdBeta(int n_days) :
+UProdBeta::UProdBeta(dsp_idx_t n_days) :
     // initialization list
-    m_vals(new double[n_days]),
-    m_exp_vals(new double[n_days]),
-    m_n_days(n_days)
+    m_vals(new dsp_store_t[n_days]),
+    m_exp_vals(new dsp_store_t[n_days]),
+    m_n_days(n_days),
+    m_exp_prop(new dsp_store_t[n_days]),
+    m_is_mapped(false)
 {
     // initialize `U * beta` values to 0 (i.e. `beta` values are all 0,
     // corresponding to no effect in the model)
-    for (int i = 0; i < m_n_days; ++i) {
+    for (dsp_idx_t i = 0; i < m_n_days; ++i) {
+	m_vals[i] = 0.0;
+	m_exp_vals[i] = 1.0;
+    }
+}
+
+
+
+
+// constructor for data that is too large to fit in memory.  The storage for
+// `U * beta` and `exp(U * beta)` is backed by an anonymous scratch file in
+// `scratch_dir` so that the operating system is able to write the pages out to
+// disk as needed, rather than having to keep them all in memory.
+
+UProdBeta::UProdBeta(dsp_idx_t n_days, const std::string& scratch_dir) :
+    m_vals(static_cast<dsp_store_t*>(ModelFile::map_scratch(scratch_dir, 3 * n_days * sizeof(dsp_store_t)))),
+    m_exp_vals(m_vals + n_days),
+    m_n_days(n_days),
+    m_exp_prop(m_vals + 2 * n_days),
+    m_is_mapped(true)
+{
+    for (dsp_idx_t i = 0; i < m_n_days; ++i) {
 	m_vals[i] = 0.0;
 	m_exp_vals[i] = 1.0;
     }
@@ -20,8 +47,14 @@ UProdBeta::UProdBeta(int n_days) :
 
 
 UProdBeta::~UProdBeta() {
-    delete[] m_vals;
-    delete[] m_exp_vals;
+    if (m_is_mapped) {
+	ModelFile::unmap_scratch(m_vals, 3 * m_n_days * sizeof(dsp_store_t));
+    }
+    else {
+	delete[] m_vals;
+	delete[] m_exp_vals;
+	delete[] m_exp_prop;
+    }
 }
 
 
@@ -30,18 +63,44 @@ UProdBeta::~UProdBeta() {
 // change the values of the data pointed to by `ubeta_no_h` so that each element
 // has the value of the corresponding element of `U_h * beta_h* added to it
 
-void UProdBeta::add_uh_prod_beta_h(const double* U_h, double beta_h) {
+void UProdBeta::add_uh_prod_beta_h(const UCol& U_h, double beta_h) {
 
     // each iteration updates the ijk-th element of `U * beta - U_h * beta_h` to
     // instead have the values given by `ubeta`.
-    for (int r = 0; r < m_n_days; ++r) {
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
 
 	// case: U_{ijkh} has a value of 1, so update the ijk-th element of
 	// `U*beta - U_h*beta_h` to have the value of the ijk-th element of
 	// `ubeta`.  If U_{ijkh} has a value of 0 then no update is needed.
-	if (U_h[r]) {
-	    m_vals[r] += beta_h;
-	}
+	U_h.for_each_nz(g_day_chunks.day_beg(c), chunk_end, [&](dsp_idx_t r, double) {
+		m_vals[r] += beta_h;
+	    });
+    }
+}
+
+
+
+
+// the analogue of `add_uh_prod_beta_h` that also keeps `exp(U * beta)` up to
+// date, where `gam_h` is `exp(beta_h)`.  Since adding `beta_h` to `U * beta`
+// multiplies `exp(U * beta)` by `gam_h`, this doesn't require any calls to
+// `exp`.  The products accumulate rounding error, which is removed by
+// periodically calling `update_exp` (see `sample_chain` in Dsp.cpp).
+
+void UProdBeta::add_uh_prod_beta_h(const UCol& U_h, double beta_h, double gam_h) {
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	U_h.for_each_nz(g_day_chunks.day_beg(c), chunk_end, [&](dsp_idx_t r, double) {
+		m_vals[r] += beta_h;
+		m_exp_vals[r] *= gam_h;
+	    });
     }
 }
 
@@ -49,14 +108,43 @@ void UProdBeta::add_uh_prod_beta_h(const double* U_h, double beta_h) {
 
 
 // update `U * beta` and `exp(U * beta)` based upon an updated value of
-// `beta_h`
-void UProdBeta::update(const double* U_h, double beta_h_new, double beta_h_curr) {
+// `beta_h`.  The values only change for the days with a nonzero value of `U_h`.
+void UProdBeta::update(const UCol& U_h, double beta_h_new, double beta_h_curr) {
 
     const double beta_h_diff = beta_h_new - beta_h_curr;
 
-    for (int i = 0; i < m_n_days; i++) {
-	m_vals[i] += U_h[i] * beta_h_diff;
-	m_exp_vals[i] = exp(m_vals[i]);
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	U_h.for_each_nz(g_day_chunks.day_beg(c), chunk_end, [&](dsp_idx_t i, double u_hi) {
+		m_vals[i] += u_hi * beta_h_diff;
+		m_exp_vals[i] = exp(m_vals[i]);
+	    });
+    }
+}
+
+
+
+
+// update `U * beta` and `exp(U * beta)` upon accepting a proposal value of
+// `beta_h`, where `beta_h_diff` is the change in `beta_h`.  The values of
+// `exp(U * beta)` under the proposal are expected to have been written to
+// `m_exp_prop` for each of the days with a nonzero value of `U_h` when the
+// proposal was evaluated, so that they are copied rather than recalculated.
+
+void UProdBeta::commit_prop(const UCol& U_h, double beta_h_diff) {
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	U_h.for_each_nz(g_day_chunks.day_beg(c), chunk_end, [&](dsp_idx_t r, double u_hr) {
+		m_vals[r] += u_hr * beta_h_diff;
+		m_exp_vals[r] = m_exp_prop[r];
+	    });
     }
 }
 
@@ -65,7 +153,25 @@ void UProdBeta::update(const double* U_h, double beta_h_new, double beta_h_curr)
 
 // update `exp(U * beta)` based upon updated `U * beta`
 void UProdBeta::update_exp() {
-    for (int i = 0; i < m_n_days; i++) {
-	m_exp_vals[i] = std::exp(m_vals[i]);
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const dsp_idx_t chunk_end = g_day_chunks.day_end(c, m_n_days);
+
+	for (dsp_idx_t i = g_day_chunks.day_beg(c); i < chunk_end; i++) {
+	    m_exp_vals[i] = std::exp(m_vals[i]);
+	}
     }
 }
+
+
+
+
+// exchange the values of `U * beta` and `exp(U * beta)` with those of `other`,
+// which is used to swap the states of two chains of a temperature ladder (see
+// TemperLadder.h)
+
+void UProdBeta::swap_state(UProdBeta& other) {
+    std::swap_ranges(m_vals, m_vals + m_n_days, other.m_vals);
+    std::swap_ranges(m_exp_vals, m_exp_vals + m_n_days, other.m_exp_vals);
+}
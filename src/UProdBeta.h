@@ -1,27 +1,47 @@
 #ifndef DSP_BAYES_SRC_U_PROD_BETA_H
 #define DSP_BAYES_SRC_U_PROD_BETA_H
 
+#include <string>
+#include "IdxType.h"
+#include "Precision.h"
+#include "UCol.h"
+
 
 class UProdBeta {
 
 public:
 
-    double* m_vals;
-    double* m_exp_vals;
-    const int m_n_days;
+    // the storage type is given by the precision policy (see Precision.h)
+    dsp_store_t* m_vals;
+    dsp_store_t* m_exp_vals;
+    const dsp_idx_t m_n_days;
+
+    // scratch space for the values of `exp(U * beta)` under a proposal value
+    // of one of the coefficients, which are written by the proposal evaluation
+    // and copied to `m_exp_vals` by `commit_prop` if the proposal is accepted
+    dsp_store_t* m_exp_prop;
 
-    UProdBeta(int n_days);
+    // whether `m_vals` and `m_exp_vals` are backed by a scratch file rather
+    // than allocated on the heap
+    const bool m_is_mapped;
+
+    UProdBeta(dsp_idx_t n_days);
+    UProdBeta(dsp_idx_t n_days, const std::string& scratch_dir);
     ~UProdBeta();
 
-    void add_uh_prod_beta_h(const double* U_h, double beta_h);
-    void update(const double* U_h, double beta_h_new, double beta_h_curr);  // TODO: write utest
+    void add_uh_prod_beta_h(const UCol& U_h, double beta_h);
+    void add_uh_prod_beta_h(const UCol& U_h, double beta_h, double gam_h);
+    void update(const UCol& U_h, double beta_h_new, double beta_h_curr);  // TODO: write utest
     void update_exp();
-
-    double* vals() { return m_vals; }
-    const double* vals() const { return m_vals; }
-    double* exp_vals() { return m_exp_vals; }
-    const double* exp_vals() const {return m_exp_vals; }
-    int n_days() { return m_n_days; }
+    void commit_prop(const UCol& U_h, double beta_h_diff);
+    void swap_state(UProdBeta& other);
+
+    dsp_store_t* vals() { return m_vals; }
+    const dsp_store_t* vals() const { return m_vals; }
+    dsp_store_t* exp_vals() { return m_exp_vals; }
+    const dsp_store_t* exp_vals() const {return m_exp_vals; }
+    dsp_store_t* exp_prop() { return m_exp_prop; }
+    dsp_idx_t n_days() { return m_n_days; }
 };
 
 
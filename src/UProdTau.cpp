@@ -5,8 +5,18 @@ using Rcpp::as;
 
 
 UProdTau::UProdTau(Rcpp::NumericVector& utau, Rcpp::List& tau_coefs) :
-    m_vals_rcpp(utau),
-    m_vals(m_vals_rcpp.begin()),
+    m_vals(utau.begin()),
+    m_n_days(utau.size()),
     m_coefs_rcpp(as<Rcpp::NumericVector>(tau_coefs["u_coefs"])),
     m_coefs(m_coefs_rcpp.begin()) {
 }
+
+
+
+
+UProdTau::UProdTau(double* utau, dsp_idx_t n_days, const double* coefs) :
+    m_vals(utau),
+    m_n_days(n_days),
+    m_coefs_rcpp(),
+    m_coefs(coefs) {
+}
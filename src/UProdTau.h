@@ -2,24 +2,28 @@
 #define DSP_BAYES_SRC_U_PROD_TAU_H
 
 #include "Rcpp.h"
+#include "IdxType.h"
 
 
 class UProdTau {
 
 public:
 
-    Rcpp::NumericVector& m_vals_rcpp;
-    Rcpp::NumericVector::iterator m_vals;
+    double* m_vals;
+    const dsp_idx_t m_n_days;
 
-    const Rcpp::NumericVector& m_coefs_rcpp;
-    const Rcpp::NumericVector::const_iterator m_coefs;
+    // owns the coefficients when they are provided by R, so that they remain
+    // valid if `tau_coefs["u_coefs"]` had to be coerced to a numeric vector
+    const Rcpp::NumericVector m_coefs_rcpp;
+    const double* m_coefs;
 
     UProdTau(Rcpp::NumericVector& utau, Rcpp::List& tau_coefs);
+    UProdTau(double* utau, dsp_idx_t n_days, const double* coefs);
 
     double* vals() { return m_vals; }
     const double* vals() const { return m_vals; }
     const double* coefs() const { return m_coefs; }
-    int n_days() const { return m_vals_rcpp.size(); }
+    dsp_idx_t n_days() const { return m_n_days; }
 
 };
 
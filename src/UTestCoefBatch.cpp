@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <vector>
+#include "Rcpp.h"
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "CoefBatch.h"
+#include "UTestGammaContMH.h"
+#include "GammaGen.h"
+#include "UTestCoefBatch.h"
+#include "WGen.h"
+
+#define EPSILON 0.000000000001
+
+
+
+
+// the data has two stored 0/1 columns and an interaction column that is the
+// product of the two, each of which has a categorical coefficient.  The
+// pregnancy days are days 2 - 4 and days 7 - 8, as for the
+// `GammaContMHTest::FromScratchDays` data.
+
+CoefBatchTest::CoefBatchTest() :
+    U(Rcpp::NumericMatrix(9, 2))
+{
+    const double u_vals[18] = { 1.0, 0.0, 1.0, 0.0, 1.0, 1.0, 0.0, 1.0, 0.0,
+				0.0, 1.0, 1.0, 1.0, 0.0, 1.0, 1.0, 0.0, 1.0 };
+    std::copy(u_vals, u_vals + 18, U.begin());
+
+    const double hyp_a_vals[3] = { 1.0, 1.5, 2.0 };
+    gamma_specs = Rcpp::List(3);
+    for (int j = 0; j < 3; ++j) {
+	Rcpp::NumericVector curr_specs = Rcpp::NumericVector::create(Rcpp::_["type"]  = 0.0,
+								     Rcpp::_["h"]     = (j < 2) ? j : -1.0,
+								     Rcpp::_["hyp_a"] = hyp_a_vals[j],
+								     Rcpp::_["hyp_b"] = 1.0,
+								     Rcpp::_["hyp_p"] = 0.5,
+								     Rcpp::_["bnd_l"] = 0.0,
+								     Rcpp::_["bnd_u"] = R_PosInf);
+	if (j == 2) {
+	    curr_specs.push_back(2.0, "n_parents");
+	    curr_specs.push_back(0.0, "parent_1");
+	    curr_specs.push_back(1.0, "parent_2");
+	}
+	gamma_specs[j] = curr_specs;
+    }
+}
+
+
+
+
+void CoefBatchTest::setUp() {
+
+    W = GammaContMHTest::FromScratchDays::new_w();
+    const int w_vals[5] = { 1, 2, 0, 3, 1 };
+    std::copy(w_vals, w_vals + 5, W->m_vals);
+
+    gamma = GammaGen::create_arr(U.begin(), 9, gamma_specs, NULL, NULL);
+    batch = new CoefBatch(gamma, gamma_specs, std::vector<int>{ 0, 1, 2 }, true);
+}
+
+
+
+
+void CoefBatchTest::tearDown() {
+    delete batch;
+    for (int j = 0; j < 3; ++j) {
+	delete gamma[j];
+    }
+    delete[] gamma;
+    delete W;
+}
+
+
+
+
+void CoefBatchTest::test_constructor() {
+    CPPUNIT_ASSERT(batch->m_fuse_a_tilde);
+    CPPUNIT_ASSERT_EQUAL(3, (int) batch->m_categ.size());
+    CPPUNIT_ASSERT_EQUAL(0, (int) batch->m_cont_mh.size());
+    CPPUNIT_ASSERT_EQUAL(0, (int) batch->m_cont_aux.size());
+    CPPUNIT_ASSERT(! batch->m_categ[2]->m_Uh.is_stored());
+}
+
+
+
+
+// the values of `a_tilde` calculated in a single pass are those calculated for
+// each coefficient by `GammaCateg::calc_a_tilde`.  The interaction column is
+// only nonzero on day 2 of the pregnancy days.
+
+void CoefBatchTest::test_calc_a_tilde() {
+
+    // exercise SUT
+    batch->calc_a_tilde(*W);
+
+    // verify outcome
+    const double target_a_tilde[3] = { 1.0 + 1 + 3, 1.5 + 1 + 2 + 1, 2.0 + 1 };
+    for (int k = 0; k < 3; ++k) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(batch->m_categ[k]->calc_a_tilde(*W), batch->m_a_tilde[k], EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(target_a_tilde[k], batch->m_a_tilde[k], EPSILON);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef DSP_BAYES_UTEST_COEF_BATCH_H
+#define DSP_BAYES_UTEST_COEF_BATCH_H
+
+
+#include "cppunit/extensions/HelperMacros.h"
+#include "Rcpp.h"
+
+#include "CoefBatch.h"
+#include "GammaGen.h"
+#include "WGen.h"
+
+
+
+
+class CoefBatchTest : public CppUnit::TestFixture {
+
+public:
+
+    // constructor
+    CoefBatchTest();
+
+    // setUp, tearDown
+    void setUp();
+    void tearDown();
+
+    // test methods
+    void test_constructor();
+    void test_calc_a_tilde();
+
+    CPPUNIT_TEST_SUITE(CoefBatchTest);
+    CPPUNIT_TEST(test_constructor);
+    CPPUNIT_TEST(test_calc_a_tilde);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    Rcpp::NumericMatrix U;
+    Rcpp::List gamma_specs;
+    GammaGen** gamma;
+    CoefBatch* batch;
+    WGen* W;
+};
+
+
+#endif
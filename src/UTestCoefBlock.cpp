@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Rcpp.h"
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "CoefBlock.h"
+#include "GammaGen.h"
+#include "UTestCoefBlock.h"
+
+#define EPSILON 0.000000000001
+
+// the step size and tolerance for the central difference approximations of the
+// derivatives of the log posterior
+#define DIFF_STEP 0.00001
+#define DIFF_TOL  0.000001
+
+// the current values of the coefficients
+#define BETA_CURR_0  0.5
+#define BETA_CURR_1 -0.3
+
+extern int* d2s;
+
+
+
+
+// the data for the days is that of the `GammaContMHTest` fixture, with a
+// second column and with several of the days not having intercourse
+
+CoefBlockTest::CoefBlockTest() :
+    U(Rcpp::NumericMatrix(9, 2)),
+    X(GammaContMHTest::FromScratchDays::x_vals),
+    w_day_vals(GammaContMHTest::FromScratchDays::w_day_vals)
+{
+    const double u_vals_1[9] = { 0.0, 1.0, 1.0, 0.0, 0.5, 1.0, 0.0, 2.0, 1.0 };
+    std::copy(GammaContMHTest::FromScratchDays::u_vals,
+	      GammaContMHTest::FromScratchDays::u_vals + 9,
+	      U.begin());
+    std::copy(u_vals_1, u_vals_1 + 9, U.begin() + 9);
+}
+
+
+
+
+void CoefBlockTest::setUp() {
+
+    Rcpp::NumericVector specs_0 = Rcpp::NumericVector::create(Rcpp::_["h"]        = 0.0,
+							      Rcpp::_["hyp_a"]    = 1.2,
+							      Rcpp::_["hyp_b"]    = 0.9,
+							      Rcpp::_["hyp_p"]    = 0.5,
+							      Rcpp::_["bnd_l"]    = 0.0,
+							      Rcpp::_["bnd_u"]    = R_PosInf,
+							      Rcpp::_["mh_p"]     = 0.1,
+							      Rcpp::_["mh_delta"] = 0.2);
+    Rcpp::NumericVector specs_1 = Rcpp::clone(specs_0);
+    specs_1["h"] = 1.0;
+    specs_1["hyp_a"] = 2.0;
+    specs_1["hyp_b"] = 1.5;
+
+    gamma[0] = new GammaContMH(U, specs_0);
+    gamma[1] = new GammaContMH(U, specs_1);
+    gamma[0]->m_beta_val = BETA_CURR_0;
+    gamma[0]->m_gam_val = exp(BETA_CURR_0);
+    gamma[1]->m_beta_val = BETA_CURR_1;
+    gamma[1]->m_gam_val = exp(BETA_CURR_1);
+
+    std::vector<int> idx;
+    idx.push_back(0);
+    idx.push_back(1);
+    block = new CoefBlock(gamma, idx, 9);
+
+    w_obj     = new GammaContMHTest::FromScratchW();
+    xi_obj    = new GammaContMHTest::FromScratchXi();
+    ubeta_obj = new GammaContMHTest::FromScratchUbeta();
+    days_obj  = new GammaContMHTest::FromScratchDays();
+}
+
+
+
+
+void CoefBlockTest::tearDown() {
+    delete block;
+    delete gamma[0];
+    delete gamma[1];
+    delete w_obj;
+    delete xi_obj;
+    delete ubeta_obj;
+    delete days_obj;
+}
+
+
+
+
+// the gradient at the current values is the derivative of the log posterior
+
+void CoefBlockTest::test_calc_grad_curr() {
+
+    // fixture setup
+    activate(*block);
+
+    // exercise SUT
+    block->calc_grad_curr(w_obj->W(), xi_obj->xi(), ubeta_obj->ubeta(), X);
+
+    // verify outcome
+    const double diff_0 = ((log_post(BETA_CURR_0 + DIFF_STEP, BETA_CURR_1)
+			    - log_post(BETA_CURR_0 - DIFF_STEP, BETA_CURR_1))
+			   / (2.0 * DIFF_STEP));
+    const double diff_1 = ((log_post(BETA_CURR_0, BETA_CURR_1 + DIFF_STEP)
+			    - log_post(BETA_CURR_0, BETA_CURR_1 - DIFF_STEP))
+			   / (2.0 * DIFF_STEP));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(diff_0, block->m_grad_curr[0], DIFF_TOL);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(diff_1, block->m_grad_curr[1], DIFF_TOL);
+}
+
+
+
+
+// the gradient at the proposal values is the derivative of the log posterior
+
+void CoefBlockTest::test_calc_prop_grad() {
+
+    // fixture setup
+    activate(*block);
+    set_prop(*block, 0.8, -0.6);
+
+    // exercise SUT
+    block->calc_prop(w_obj->W(), xi_obj->xi(), ubeta_obj->ubeta(), X);
+
+    // verify outcome
+    const double diff_0 = ((log_post(0.8 + DIFF_STEP, -0.6) - log_post(0.8 - DIFF_STEP, -0.6))
+			   / (2.0 * DIFF_STEP));
+    const double diff_1 = ((log_post(0.8, -0.6 + DIFF_STEP) - log_post(0.8, -0.6 - DIFF_STEP))
+			   / (2.0 * DIFF_STEP));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(diff_0, block->m_grad_prop[0], DIFF_TOL);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(diff_1, block->m_grad_prop[1], DIFF_TOL);
+}
+
+
+
+
+// the return value is the log-likelihood ratio of the proposal values
+
+void CoefBlockTest::test_calc_prop_log_lik() {
+
+    // fixture setup
+    activate(*block);
+    set_prop(*block, 0.8, -0.6);
+
+    // exercise SUT
+    double out = block->calc_prop(w_obj->W(), xi_obj->xi(), ubeta_obj->ubeta(), X);
+
+    // verify outcome
+    const double target = log_lik(0.8, -0.6) - log_lik(BETA_CURR_0, BETA_CURR_1);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target, out, EPSILON);
+}
+
+
+
+
+// after committing the proposal `U * beta` has the values for the proposal
+
+void CoefBlockTest::test_commit() {
+
+    // fixture setup
+    activate(*block);
+    set_prop(*block, 0.8, -0.6);
+    UProdBeta& ubeta = ubeta_obj->ubeta();
+    std::vector<double> target(9);
+    for (int r = 0; r < 9; ++r) {
+	target[r] = ubeta.m_vals[r] + (U(r, 0) * (0.8 - BETA_CURR_0)) + (U(r, 1) * (-0.6 - BETA_CURR_1));
+    }
+
+    // exercise SUT
+    block->calc_prop(w_obj->W(), xi_obj->xi(), ubeta, X);
+    block->commit(ubeta);
+
+    // verify outcome
+    for (int r = 0; r < 9; ++r) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(target[r],      ubeta.m_vals[r],     EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(target[r]), ubeta.m_exp_vals[r], EPSILON);
+    }
+}
+
+
+
+
+// utility functions -----------------------------------------------------------
+
+// mark each of the coefficients as updated in the current scan, as is done by
+// `CoefBlock::sample`
+
+void CoefBlockTest::activate(CoefBlock& block) {
+
+    block.m_active.clear();
+    block.m_active.push_back(0);
+    block.m_active.push_back(1);
+
+    block.m_beta_curr.assign(2, 0.0);
+    block.m_beta_prop.assign(2, 0.0);
+    block.m_beta_diff.assign(2, 0.0);
+    block.m_grad_curr.assign(2, 0.0);
+    block.m_grad_prop.assign(2, 0.0);
+    block.m_u_row.assign(2, 0.0);
+}
+
+
+
+
+void CoefBlockTest::set_prop(CoefBlock& block, double beta_0, double beta_1) {
+
+    block.m_beta_curr[0] = BETA_CURR_0;
+    block.m_beta_curr[1] = BETA_CURR_1;
+    block.m_beta_prop[0] = beta_0;
+    block.m_beta_prop[1] = beta_1;
+    block.m_beta_diff[0] = beta_0 - BETA_CURR_0;
+    block.m_beta_diff[1] = beta_1 - BETA_CURR_1;
+}
+
+
+
+
+// the W-augmented log-likelihood, up to a constant, calculated by a brute-force
+// sum over the days.  The fixture's values of `U * beta` correspond to the
+// current values of the coefficients.
+
+double CoefBlockTest::log_lik(double beta_0, double beta_1) {
+
+    const double* xi_vals = xi_obj->xi().vals();
+    const UProdBeta& ubeta = ubeta_obj->ubeta();
+
+    double sum_val = 0.0;
+    for (int r = 0; r < 9; ++r) {
+	if (! X[r]) {
+	    continue;
+	}
+	const double ubeta_val = (ubeta.m_vals[r]
+				  + (U(r, 0) * (beta_0 - BETA_CURR_0))
+				  + (U(r, 1) * (beta_1 - BETA_CURR_1)));
+	sum_val += ((w_day_vals[r] * ubeta_val)
+		    - (X[r] * xi_vals[ d2s[r] ] * exp(ubeta_val)));
+    }
+
+    return sum_val;
+}
+
+
+
+
+// the log posterior, up to a constant, for the coefficients in the continuous
+// part of their prior
+
+double CoefBlockTest::log_post(double beta_0, double beta_1) {
+
+    const double beta[2] = { beta_0, beta_1 };
+
+    double sum_val = log_lik(beta_0, beta_1);
+    for (int k = 0; k < 2; ++k) {
+	sum_val += (gamma[k]->m_hyp_a - 1) * beta[k] - gamma[k]->m_hyp_b * exp(beta[k]);
+    }
+
+    return sum_val;
+}
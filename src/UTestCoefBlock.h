@@ -0,0 +1,59 @@
+#ifndef DSP_BAYES_UTEST_COEF_BLOCK_H
+#define DSP_BAYES_UTEST_COEF_BLOCK_H
+
+
+#include "cppunit/extensions/HelperMacros.h"
+#include "Rcpp.h"
+
+#include "CoefBlock.h"
+#include "GammaGen.h"
+#include "UTestGammaContMH.h"
+
+
+
+
+class CoefBlockTest : public CppUnit::TestFixture {
+
+public:
+
+    // constructor
+    CoefBlockTest();
+
+    // setUp, tearDown
+    void setUp();
+    void tearDown();
+
+    // test methods
+    void test_calc_grad_curr();
+    void test_calc_prop_grad();
+    void test_calc_prop_log_lik();
+    void test_commit();
+
+    // utility functions
+    void activate(CoefBlock& block);
+    void set_prop(CoefBlock& block, double beta_0, double beta_1);
+    double log_lik(double beta_0, double beta_1);
+    double log_post(double beta_0, double beta_1);
+
+    CPPUNIT_TEST_SUITE(CoefBlockTest);
+    CPPUNIT_TEST(test_calc_grad_curr);
+    CPPUNIT_TEST(test_calc_prop_grad);
+    CPPUNIT_TEST(test_calc_prop_log_lik);
+    CPPUNIT_TEST(test_commit);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    Rcpp::NumericMatrix U;
+    GammaGen* gamma[2];
+    CoefBlock* block;
+    GammaContMHTest::FromScratchDays* days_obj;
+    GammaContMHTest::FromScratchW* w_obj;
+    GammaContMHTest::FromScratchXi* xi_obj;
+    GammaContMHTest::FromScratchUbeta* ubeta_obj;
+    const int* X;
+    const int* w_day_vals;
+};
+
+
+#endif
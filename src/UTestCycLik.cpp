@@ -0,0 +1,545 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Rcpp.h"
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "CycLik.h"
+#include "FwDays.h"
+#include "GammaGen.h"
+#include "ULevels.h"
+#include "UTestCycLik.h"
+#include "WGen.h"
+
+#define EPSILON 0.000000000001
+
+// the current value of the coefficient, the proposal value, and the value of
+// phi
+#define BETA_CURR  0.5
+#define BETA_PROP  0.8
+#define PHI_VAL    1.4
+
+// the number of draws of xi, and the tolerance for the sample mean
+#define N_DRAWS   20000
+#define MEAN_TOL  0.03
+
+// the upper limit and the number of intervals used to integrate the full
+// conditional distribution of xi
+#define XI_MAX     40.0
+#define N_XI_INTS  40000
+
+extern int* d2s;
+
+
+
+
+// the data for the days is that of the `GammaContMHTest` fixture, with several
+// of the days not having intercourse.  Each of the subjects has one pregnancy
+// cycle, which are days 2 - 4 for the first subject and days 7 - 8 for the
+// second subject.  The values of `U * beta` in the fixture are taken to include
+// the term for the current value of the coefficient being tested.
+//
+// The days are also given a cycle-level column, a subject-level column, and a
+// fertile window day effect, for which the values of `U_h` for each day are
+// recorded in `u_cyc_day_vals`, `u_subj_day_vals`, and `u_fw_day_vals`.
+
+CycLikTest::CycLikTest() :
+    U(Rcpp::NumericMatrix(9, 1)),
+    X(GammaContMHTest::FromScratchDays::x_vals),
+    ubeta_init(GammaContMHTest::FromScratchDays::ubeta_vals),
+    u_day_vals(GammaContMHTest::FromScratchDays::u_vals)
+{
+    std::copy(u_day_vals, u_day_vals + 9, U.begin());
+
+    // there are four cycles, the second and fourth of which are the pregnancy
+    // cycles
+    const int d2c_vals[9] = { 0, 0, 1, 1, 1, 2, 2, 3, 3 };
+    const double u_cyc_vals[4] = { 0.5, 1.0, 0.0, 2.0 };
+    const double u_subj_vals[2] = { 0.7, -0.2 };
+    const double u_cyc_day[9] = { 0.5, 0.5, 1.0, 1.0, 1.0, 0.0, 0.0, 2.0, 2.0 };
+    const double u_subj_day[9] = { 0.7, 0.7, 0.7, 0.7, 0.7, -0.2, -0.2, -0.2, -0.2 };
+    std::copy(d2c_vals, d2c_vals + 9, d2c);
+    std::copy(u_cyc_vals, u_cyc_vals + 4, u_cyc);
+    std::copy(u_subj_vals, u_subj_vals + 2, u_subj);
+    std::copy(u_cyc_day, u_cyc_day + 9, u_cyc_day_vals);
+    std::copy(u_subj_day, u_subj_day + 9, u_subj_day_vals);
+
+    // the fertile window day effect is for the days at position 0
+    const int fw_pos_vals[9] = { -1, -1, 0, 1, 0, -1, -1, 0, 1 };
+    const double u_fw_day[9] = { 0.0, 0.0, 1.0, 0.0, 1.0, 0.0, 0.0, 1.0, 0.0 };
+    std::copy(fw_pos_vals, fw_pos_vals + 9, fw_pos);
+    std::copy(u_fw_day, u_fw_day + 9, u_fw_day_vals);
+}
+
+
+
+
+void CycLikTest::setUp() {
+
+    // `ULevels` maps the cycles to subjects using `d2s`
+    days_obj  = new GammaContMHTest::FromScratchDays();
+    W         = GammaContMHTest::FromScratchDays::new_w();
+    xi_obj    = new GammaContMHTest::FromScratchXi();
+    ubeta_obj = new GammaContMHTest::FromScratchUbeta();
+    levels    = new ULevels(u_cyc, 4, u_subj, 2, d2c, 9);
+    fw        = new FwDays(fw_pos, 9);
+    lik       = new CycLik(*W, xi_obj->xi(), 9);
+}
+
+
+
+
+void CycLikTest::tearDown() {
+    delete lik;
+    delete W;
+    delete xi_obj;
+    delete ubeta_obj;
+    delete levels;
+    delete fw;
+    delete days_obj;
+}
+
+
+
+
+// the statistics are `L_ij` for each pregnancy cycle and `A_i` for each subject
+
+void CycLikTest::test_calc_stats() {
+
+    // exercise SUT
+    lik->calc_stats(ubeta_obj->ubeta(), X);
+
+    // verify outcome
+    double cyc_sums[2], subj_sums[2];
+    calc_sums(u_day_vals, BETA_CURR, cyc_sums, subj_sums);
+    for (int i = 0; i < 2; ++i) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(cyc_sums[i],  lik->m_cyc_sums[i],  EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(subj_sums[i], lik->m_subj_sums[i], EPSILON);
+    }
+    CPPUNIT_ASSERT_EQUAL(0, lik->m_subj_cyc[0]);
+    CPPUNIT_ASSERT_EQUAL(1, lik->m_subj_cyc[1]);
+    CPPUNIT_ASSERT_EQUAL(2, lik->m_subj_cyc[2]);
+}
+
+
+
+
+// the log-likelihood isn't tempered
+
+void CycLikTest::test_log_lik() {
+
+    // fixture setup
+    lik->calc_stats(ubeta_obj->ubeta(), X);
+    lik->m_inv_temp = 0.5;
+
+    // exercise SUT
+    double out = lik->log_lik(xi_obj->xi().vals());
+
+    // verify outcome
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(log_lik(u_day_vals, BETA_CURR), out, EPSILON);
+}
+
+
+
+
+// the return value of `GammaContMH::get_lik_log_lik` is the log-likelihood ratio
+// of the proposal value for each kind of column
+
+void CycLikTest::test_log_lik_diff() {
+    GammaContMH* gamma = gen_gamma(U_LEVEL_DAY, -1);
+    check_log_lik_diff(*gamma, u_day_vals);
+    delete gamma;
+}
+
+
+void CycLikTest::test_log_lik_diff_cyc() {
+    GammaContMH* gamma = gen_gamma(U_LEVEL_CYC, -1);
+    check_log_lik_diff(*gamma, u_cyc_day_vals);
+    delete gamma;
+}
+
+
+void CycLikTest::test_log_lik_diff_subj() {
+    GammaContMH* gamma = gen_gamma(U_LEVEL_SUBJ, -1);
+    check_log_lik_diff(*gamma, u_subj_day_vals);
+    delete gamma;
+}
+
+
+void CycLikTest::test_log_lik_diff_fw() {
+    GammaContMH* gamma = gen_gamma(U_LEVEL_DAY, 0);
+    check_log_lik_diff(*gamma, u_fw_day_vals);
+    delete gamma;
+}
+
+
+
+
+// the log-likelihood ratio is multiplied by the inverse temperature
+
+void CycLikTest::test_log_lik_diff_tempered() {
+
+    // fixture setup
+    GammaContMH* gamma = gen_gamma(U_LEVEL_DAY, -1);
+    lik->calc_stats(ubeta_obj->ubeta(), X);
+    lik->m_inv_temp = 0.5;
+
+    // exercise SUT
+    double out = gamma->get_lik_log_lik(*lik, xi_obj->xi(), ubeta_obj->ubeta(), X, BETA_PROP);
+
+    // verify outcome
+    const double target = log_lik(u_day_vals, BETA_PROP) - log_lik(u_day_vals, BETA_CURR);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5 * target, out, EPSILON);
+
+    delete gamma;
+}
+
+
+
+
+// after committing the proposal the statistics and `U * beta` are those for the
+// proposal value.  For a cycle-level column the changes are applied directly to
+// `U * beta`.
+
+void CycLikTest::test_commit() {
+    GammaContMH* gamma = gen_gamma(U_LEVEL_DAY, -1);
+    check_commit(*gamma, u_day_vals);
+    delete gamma;
+}
+
+
+void CycLikTest::test_commit_cyc() {
+    GammaContMH* gamma = gen_gamma(U_LEVEL_CYC, -1);
+    check_commit(*gamma, u_cyc_day_vals);
+    delete gamma;
+}
+
+
+
+
+// the sample mean of the draws of xi is close to the mean of its full
+// conditional distribution, which is found by numerical integration
+
+void CycLikTest::test_sample_xi() {
+
+    // fixture setup
+    lik->calc_stats(ubeta_obj->ubeta(), X);
+
+    // exercise SUT
+    set_seed(19);
+    double out = run_xi_chain(0, PHI_VAL, N_DRAWS);
+
+    // verify outcome
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(calc_xi_mean(0, PHI_VAL), out, MEAN_TOL);
+}
+
+
+void CycLikTest::test_sample_xi_tempered() {
+
+    // fixture setup
+    lik->calc_stats(ubeta_obj->ubeta(), X);
+    lik->m_inv_temp = 0.5;
+
+    // exercise SUT
+    set_seed(20);
+    double out = run_xi_chain(0, PHI_VAL, N_DRAWS);
+
+    // verify outcome
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(calc_xi_mean(0, PHI_VAL), out, MEAN_TOL);
+}
+
+
+
+
+// an interaction column of the cycle-level column and the fertile window day
+// effect, and one of the subject-level column and the day-level column, where
+// none of the parents are stored as day-level columns other than the day-level
+// column
+
+void CycLikTest::test_create_uh_parents() {
+
+    // fixture setup
+    Rcpp::NumericVector cyc_fw_specs = Rcpp::NumericVector::create(Rcpp::_["h"]                = -1.0,
+								   Rcpp::_["n_parents"]        = 2.0,
+								   Rcpp::_["parent_1"]         = 1.0,
+								   Rcpp::_["parent_1_level"]   = U_LEVEL_CYC,
+								   Rcpp::_["parent_1_level_h"] = 0.0,
+								   Rcpp::_["parent_2"]         = 2.0,
+								   Rcpp::_["parent_2_fw_pos"]  = 0.0);
+    Rcpp::NumericVector subj_day_specs = Rcpp::NumericVector::create(Rcpp::_["h"]                = -1.0,
+								     Rcpp::_["n_parents"]        = 2.0,
+								     Rcpp::_["parent_1"]         = 3.0,
+								     Rcpp::_["parent_1_level"]   = U_LEVEL_SUBJ,
+								     Rcpp::_["parent_1_level_h"] = 0.0,
+								     Rcpp::_["parent_2"]         = 0.0,
+								     Rcpp::_["parent_2_h"]       = 0.0);
+    double cyc_fw_target[9], subj_day_target[9];
+    for (int r = 0; r < 9; ++r) {
+	cyc_fw_target[r] = u_cyc_day_vals[r] * u_fw_day_vals[r];
+	subj_day_target[r] = u_subj_day_vals[r] * u_day_vals[r];
+    }
+
+    // exercise SUT
+    UCol cyc_fw_uh = GammaGen::create_uh(U.begin(), 9, cyc_fw_specs, levels, fw, NULL);
+    UCol subj_day_uh = GammaGen::create_uh(U.begin(), 9, subj_day_specs, levels, fw, NULL);
+
+    // verify outcome
+    CPPUNIT_ASSERT(! cyc_fw_uh.is_stored());
+    CPPUNIT_ASSERT(! subj_day_uh.is_stored());
+    check_uh(cyc_fw_uh, cyc_fw_target);
+    check_uh(subj_day_uh, subj_day_target);
+}
+
+
+
+
+// two interaction columns with the same day-level parent, which is nonzero on
+// only one of the days and so has a list of its nonzero days.  The other
+// parents are dense.
+
+void CycLikTest::test_create_uh_shared_parent() {
+
+    // fixture setup
+    const double u_vals[18] = { 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0,
+				1.0, 1.0, 0.0, 1.0, 2.0, 1.0, 1.0, 0.0, 1.0 };
+    Rcpp::NumericVector day_specs = Rcpp::NumericVector::create(Rcpp::_["h"]          = -1.0,
+								Rcpp::_["n_parents"]  = 2.0,
+								Rcpp::_["parent_1"]   = 0.0,
+								Rcpp::_["parent_1_h"] = 0.0,
+								Rcpp::_["parent_2"]   = 1.0,
+								Rcpp::_["parent_2_h"] = 1.0);
+    Rcpp::NumericVector fw_specs = Rcpp::NumericVector::create(Rcpp::_["h"]               = -1.0,
+							       Rcpp::_["n_parents"]       = 2.0,
+							       Rcpp::_["parent_1"]        = 0.0,
+							       Rcpp::_["parent_1_h"]      = 0.0,
+							       Rcpp::_["parent_2"]        = 2.0,
+							       Rcpp::_["parent_2_fw_pos"] = 0.0);
+    const double day_target[9] = { 0.0, 0.0, 0.0, 0.0, 2.0, 0.0, 0.0, 0.0, 0.0 };
+    const double fw_target[9] = { 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0 };
+    UCol::ParentCache parent_cache;
+
+    // exercise SUT
+    UCol day_uh = GammaGen::create_uh(u_vals, 9, day_specs, levels, fw, &parent_cache);
+    UCol fw_uh = GammaGen::create_uh(u_vals, 9, fw_specs, levels, fw, &parent_cache);
+
+    // verify outcome
+    CPPUNIT_ASSERT_EQUAL(3, (int) parent_cache.size());
+    CPPUNIT_ASSERT_EQUAL(1, day_uh.m_n_sparse);
+    CPPUNIT_ASSERT_EQUAL(1, fw_uh.m_n_sparse);
+    CPPUNIT_ASSERT(day_uh.m_parents[0].nz_idx);
+    CPPUNIT_ASSERT(day_uh.m_parents[0].nz_idx == fw_uh.m_parents[0].nz_idx);
+    CPPUNIT_ASSERT(! day_uh.m_parents[1].nz_idx);
+    CPPUNIT_ASSERT(! fw_uh.m_parents[1].nz_idx);
+    check_uh(day_uh, day_target);
+    check_uh(fw_uh, fw_target);
+}
+
+
+
+
+// utility functions -----------------------------------------------------------
+
+// construct the coefficient for the column of the given level, or for the
+// fertile window day effect at position `fw_pos` when `fw_pos` is nonnegative.
+// The current value of the coefficient is `BETA_CURR`.
+
+GammaContMH* CycLikTest::gen_gamma(int level, int fw_pos) {
+
+    const bool is_day_col = (level == U_LEVEL_DAY) && (fw_pos < 0);
+    Rcpp::NumericVector gamma_specs = Rcpp::NumericVector::create(Rcpp::_["h"]        = is_day_col ? 0.0 : -1.0,
+								  Rcpp::_["hyp_a"]    = 1.2,
+								  Rcpp::_["hyp_b"]    = 0.9,
+								  Rcpp::_["hyp_p"]    = 0.5,
+								  Rcpp::_["bnd_l"]    = 0.0,
+								  Rcpp::_["bnd_u"]    = R_PosInf,
+								  Rcpp::_["mh_p"]     = 0.1,
+								  Rcpp::_["mh_delta"] = 0.2,
+								  Rcpp::_["level"]    = level,
+								  Rcpp::_["level_h"]  = 0,
+								  Rcpp::_["fw_pos"]   = fw_pos);
+
+    GammaContMH* gamma = new GammaContMH(U.begin(), 9, gamma_specs, levels, fw);
+    gamma->m_beta_val = BETA_CURR;
+    gamma->m_gam_val = exp(BETA_CURR);
+
+    return gamma;
+}
+
+
+
+
+// calculate `L_ij` for each pregnancy cycle and `A_i` for each subject by brute
+// force, where `u_vals` are the values of `U_h` for each day and `beta` is the
+// value of the coefficient
+
+void CycLikTest::calc_sums(const double* u_vals, double beta, double* cyc_sums, double* subj_sums) {
+
+    for (int i = 0; i < 2; ++i) {
+	cyc_sums[i] = 0.0;
+	subj_sums[i] = 0.0;
+    }
+    for (int r = 0; r < 9; ++r) {
+	const double curr_val = X[r] * exp(ubeta_init[r] + (u_vals[r] * (beta - BETA_CURR)));
+	if ((2 <= r) && (r <= 4)) {
+	    cyc_sums[0] += curr_val;
+	}
+	else if ((7 <= r) && (r <= 8)) {
+	    cyc_sums[1] += curr_val;
+	}
+	else {
+	    subj_sums[ d2s[r] ] += curr_val;
+	}
+    }
+}
+
+
+
+
+// the log-likelihood of the pregnancy outcomes with `W` integrated out, up to a
+// constant, where `beta` is the value of the coefficient (see CycLik.h)
+
+double CycLikTest::log_lik(const double* u_vals, double beta) {
+
+    double cyc_sums[2], subj_sums[2];
+    calc_sums(u_vals, beta, cyc_sums, subj_sums);
+
+    const double* xi_vals = xi_obj->xi().vals();
+    double sum_val = 0.0;
+    for (int i = 0; i < 2; ++i) {
+	sum_val += log(1.0 - exp(-xi_vals[i] * cyc_sums[i])) - (xi_vals[i] * subj_sums[i]);
+    }
+
+    return sum_val;
+}
+
+
+
+
+void CycLikTest::check_log_lik_diff(GammaContMH& gamma, const double* u_vals) {
+
+    // fixture setup
+    lik->calc_stats(ubeta_obj->ubeta(), X);
+
+    // exercise SUT
+    double out = gamma.get_lik_log_lik(*lik, xi_obj->xi(), ubeta_obj->ubeta(), X, BETA_PROP);
+
+    // verify outcome
+    const double target = log_lik(u_vals, BETA_PROP) - log_lik(u_vals, BETA_CURR);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target, out, EPSILON);
+}
+
+
+
+
+void CycLikTest::check_commit(GammaContMH& gamma, const double* u_vals) {
+
+    // fixture setup
+    UProdBeta& ubeta = ubeta_obj->ubeta();
+    lik->calc_stats(ubeta, X);
+
+    // exercise SUT
+    gamma.get_lik_log_lik(*lik, xi_obj->xi(), ubeta, X, -0.4);
+    gamma.commit_lik(ubeta, -0.4);
+    lik->commit();
+
+    // verify outcome
+    double cyc_sums[2], subj_sums[2];
+    calc_sums(u_vals, -0.4, cyc_sums, subj_sums);
+    for (int i = 0; i < 2; ++i) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(cyc_sums[i],  lik->m_cyc_sums[i],  EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(subj_sums[i], lik->m_subj_sums[i], EPSILON);
+    }
+    for (int r = 0; r < 9; ++r) {
+	const double target = ubeta_init[r] + (u_vals[r] * (-0.4 - BETA_CURR));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(target,      ubeta.vals()[r],     EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(target), ubeta.exp_vals()[r], EPSILON);
+    }
+}
+
+
+
+
+// the mean of the full conditional distribution of `xi_i` with density
+// proportional to
+//
+//     xi^(phi - 1) * exp(-phi * xi) * { exp(-xi * A_i) * prod_j (1 - exp(-xi * L_ij)) }^t
+//
+// where `t` is the inverse temperature, calculated by the trapezoid rule
+
+double CycLikTest::calc_xi_mean(int i, double phi_val) {
+
+    double cyc_sums[2], subj_sums[2];
+    calc_sums(u_day_vals, BETA_CURR, cyc_sums, subj_sums);
+    const double inv_temp = lik->m_inv_temp;
+
+    const double width = XI_MAX / N_XI_INTS;
+    double sum_dens = 0.0, sum_xi_dens = 0.0;
+    for (int k = 1; k <= N_XI_INTS; ++k) {
+	const double xi_val = k * width;
+	const double log_dens = (((phi_val - 1.0) * log(xi_val)) - (phi_val * xi_val)
+				 + (inv_temp * (log(1.0 - exp(-xi_val * cyc_sums[i]))
+						- (xi_val * subj_sums[i]))));
+	const double wt = (k == N_XI_INTS) ? 0.5 : 1.0;
+	sum_dens += wt * exp(log_dens);
+	sum_xi_dens += wt * xi_val * exp(log_dens);
+    }
+
+    return sum_xi_dens / sum_dens;
+}
+
+
+
+
+// the sample mean of `n_draws` draws of `xi_i` by `CycLik::sample_xi`
+
+double CycLikTest::run_xi_chain(int i, double phi_val, int n_draws) {
+
+    double xi_val = 1.0;
+    double sum_xi = 0.0;
+    for (int s = 0; s < n_draws; ++s) {
+	xi_val = lik->sample_xi(i, xi_val, phi_val);
+	sum_xi += xi_val;
+    }
+
+    return sum_xi / n_draws;
+}
+
+
+
+
+void CycLikTest::set_seed(int seed_val) {
+
+    // register seed function
+    Rcpp::Environment base("package:base");
+    Rcpp::Function set_seed = base["set.seed"];
+
+    // set R's internal seed
+    set_seed(seed_val);
+}
+
+
+
+
+// checks that the values of `uh` are those in `target`, and that `for_each_nz`
+// visits exactly the days with a nonzero value of `target`
+
+void CycLikTest::check_uh(const UCol& uh, const double* target) {
+
+    for (int r = 0; r < 9; ++r) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(target[r], uh[r], EPSILON);
+    }
+
+    std::vector<dsp_idx_t> visited;
+    uh.for_each_nz(0, 9, [&](dsp_idx_t r, double u_hr) {
+	    CPPUNIT_ASSERT_DOUBLES_EQUAL(target[r], u_hr, EPSILON);
+	    visited.push_back(r);
+	});
+
+    std::vector<dsp_idx_t> nz_days;
+    for (int r = 0; r < 9; ++r) {
+	if (target[r] != 0.0) {
+	    nz_days.push_back(r);
+	}
+    }
+    CPPUNIT_ASSERT(visited == nz_days);
+}
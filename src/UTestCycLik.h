@@ -0,0 +1,94 @@
+#ifndef DSP_BAYES_UTEST_CYC_LIK_H
+#define DSP_BAYES_UTEST_CYC_LIK_H
+
+
+#include "cppunit/extensions/HelperMacros.h"
+#include "Rcpp.h"
+
+#include "CycLik.h"
+#include "FwDays.h"
+#include "GammaGen.h"
+#include "ULevels.h"
+#include "UTestGammaContMH.h"
+#include "WGen.h"
+
+
+
+
+class CycLikTest : public CppUnit::TestFixture {
+
+public:
+
+    // constructor
+    CycLikTest();
+
+    // setUp, tearDown
+    void setUp();
+    void tearDown();
+
+    // test methods
+    void test_calc_stats();
+    void test_log_lik();
+    void test_log_lik_diff();
+    void test_log_lik_diff_tempered();
+    void test_log_lik_diff_cyc();
+    void test_log_lik_diff_subj();
+    void test_log_lik_diff_fw();
+    void test_commit();
+    void test_commit_cyc();
+    void test_sample_xi();
+    void test_sample_xi_tempered();
+    void test_create_uh_parents();
+    void test_create_uh_shared_parent();
+
+    // utility functions
+    GammaContMH* gen_gamma(int level, int fw_pos);
+    void calc_sums(const double* u_vals, double beta, double* cyc_sums, double* subj_sums);
+    double log_lik(const double* u_vals, double beta);
+    void check_log_lik_diff(GammaContMH& gamma, const double* u_vals);
+    void check_commit(GammaContMH& gamma, const double* u_vals);
+    double calc_xi_mean(int i, double phi_val);
+    double run_xi_chain(int i, double phi_val, int n_draws);
+    void set_seed(int seed_val);
+    void check_uh(const UCol& uh, const double* target);
+
+    CPPUNIT_TEST_SUITE(CycLikTest);
+    CPPUNIT_TEST(test_calc_stats);
+    CPPUNIT_TEST(test_log_lik);
+    CPPUNIT_TEST(test_log_lik_diff);
+    CPPUNIT_TEST(test_log_lik_diff_tempered);
+    CPPUNIT_TEST(test_log_lik_diff_cyc);
+    CPPUNIT_TEST(test_log_lik_diff_subj);
+    CPPUNIT_TEST(test_log_lik_diff_fw);
+    CPPUNIT_TEST(test_commit);
+    CPPUNIT_TEST(test_commit_cyc);
+    CPPUNIT_TEST(test_sample_xi);
+    CPPUNIT_TEST(test_sample_xi_tempered);
+    CPPUNIT_TEST(test_create_uh_parents);
+    CPPUNIT_TEST(test_create_uh_shared_parent);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    Rcpp::NumericMatrix U;
+    CycLik* lik;
+    WGen* W;
+    ULevels* levels;
+    FwDays* fw;
+    GammaContMHTest::FromScratchDays* days_obj;
+    GammaContMHTest::FromScratchXi* xi_obj;
+    GammaContMHTest::FromScratchUbeta* ubeta_obj;
+    const int* X;
+    const double* ubeta_init;
+    const double* u_day_vals;
+    double u_cyc[4];
+    double u_subj[2];
+    int d2c[9];
+    int fw_pos[9];
+    double u_cyc_day_vals[9];
+    double u_subj_day_vals[9];
+    double u_fw_day_vals[9];
+};
+
+
+#endif
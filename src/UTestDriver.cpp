@@ -6,14 +6,23 @@
 #include "XiGen.h"
 
 #include "cppunit/ui/text/TestRunner.h"
+#include "UTestCoefBatch.h"
+#include "UTestCoefBlock.h"
+#include "UTestCycLik.h"
 #include "UTestFactory.h"
 #include "UTestGammaCateg.h"
+#include "UTestGammaContAux.h"
 #include "UTestGammaContMH.h"
+#include "UTestMhAdapt.h"
 #include "UTestPhiGen.h"
+#include "UTestTemperLadder.h"
 #include "UTestUGenVarCateg.h"
+#include "UTestUPatterns.h"
+#include "UTestVarBayes.h"
 #include "UTestWGen.h"
 #include "UTestXGen.h"
 #include "UTestXiGen.h"
+#include "UTestXiMarg.h"
 
 extern int* d2s;
 
@@ -83,13 +92,22 @@ int utest_cpp_(Rcpp::NumericMatrix u_rcpp,
     d2s = day_to_subj_idx.begin();
 
     CppUnit::TextUi::TestRunner runner;
+    runner.addTest(CoefBatchTest::suite());
+    runner.addTest(CoefBlockTest::suite());
+    runner.addTest(CycLikTest::suite());
     runner.addTest(GammaCategTest::suite());
+    runner.addTest(GammaContAuxTest::suite());
     runner.addTest(GammaContMHTest::suite());
+    runner.addTest(MhAdaptTest::suite());
     runner.addTest(PhiGenTest::suite());
+    runner.addTest(TemperLadderTest::suite());
     if (u_miss_info.size() > 0) { runner.addTest(UGenVarCategTest::suite()); }
+    runner.addTest(UPatternsTest::suite());
+    runner.addTest(VarBayesTest::suite());
     runner.addTest(WGenTest::suite());
     if (x_miss_cyc.size() > 0) { runner.addTest(XGenTest::suite()); }
     runner.addTest(XiGenTest::suite());
+    runner.addTest(XiMargTest::suite());
 
     // run() returns true if successful, false otherwise
     return runner.run() ? 0 : 1;
@@ -90,6 +90,7 @@ UTestFactory::UTestFactory(Rcpp::NumericMatrix u_rcpp,
 XiGen* UTestFactory::xi() {
     XiGen* xi = new XiGen(subj_day_blocks, n_samp, true);
     std::copy(input_xi.begin(), input_xi.end(), xi->m_vals);
+    xi->calc_sums();
     return xi;
 }
 
@@ -97,6 +98,7 @@ XiGen* UTestFactory::xi() {
 XiGen* UTestFactory::xi_no_rec() {
     XiGen* xi_no_rec = new XiGen(subj_day_blocks, n_samp, false);
     std::copy(input_xi.begin(), input_xi.end(), xi_no_rec->m_vals);
+    xi_no_rec->calc_sums();
     return xi_no_rec;
 }
 
@@ -186,7 +188,7 @@ UGenVarCateg* UTestFactory::u_categ(Rcpp::NumericMatrix* u_rcpp_copy) {
 
     Rcpp::IntegerVector var_info         ( as<Rcpp::IntegerVector>(curr_var["var_info"])      );
     Rcpp::NumericVector log_u_prior_probs( as<Rcpp::NumericVector>(curr_var["log_u_prior_probs"]) );
-    Rcpp::List var_block_list            ( as<Rcpp::List>(curr_var["var_block_list"])         );
+    SEXP var_block_list                  ( curr_var["var_block_list"]                         );
 
     return new UGenVarCateg(*u_rcpp_copy, var_info, log_u_prior_probs, var_block_list, u_preg_map, u_sex_map, true);
 }
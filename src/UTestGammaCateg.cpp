@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 #include "Rcpp.h"
 #include "WGen.h"
 #include "XiGen.h"
@@ -6,7 +7,13 @@
 #include "UTestFactory.h"
 #include "UTestGammaCateg.h"
 
+// the number of intervals used to integrate the truncated gamma distribution,
+// and the relative tolerance for the conditional expectation
+#define N_GAM_INTS     100000
+#define COND_MEAN_TOL  0.000001
+
 extern UTestFactory g_ut_factory;
+extern bool g_burn_status;
 
 using Rcpp::NumericVector;
 using Rcpp::as;
@@ -282,3 +289,86 @@ void GammaCategTest::test_sample() {
     delete ubeta_one_inf;
     delete ubeta_zero_half;
 }
+
+
+
+
+// the conditional expectation used for the Rao-Blackwellized estimates is the
+// mean of the mixture of the point mass at 1 and the truncated gamma
+// distribution
+
+void GammaCategTest::test_calc_cond_mean() {
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(calc_mixture_mean(*gamma_all, p_tilde_all),
+				 gamma_all->calc_cond_mean(a_tilde, b_tilde, p_tilde_all),
+				 COND_MEAN_TOL * calc_mixture_mean(*gamma_all, p_tilde_all));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(calc_mixture_mean(*gamma_zero_one, p_tilde_zero_one),
+				 gamma_zero_one->calc_cond_mean(a_tilde, b_tilde, p_tilde_zero_one),
+				 COND_MEAN_TOL * calc_mixture_mean(*gamma_zero_one, p_tilde_zero_one));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(calc_mixture_mean(*gamma_one_inf, p_tilde_one_inf),
+				 gamma_one_inf->calc_cond_mean(a_tilde, b_tilde, p_tilde_one_inf),
+				 COND_MEAN_TOL * calc_mixture_mean(*gamma_one_inf, p_tilde_one_inf));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(calc_mixture_mean(*gamma_zero_half, p_tilde_zero_half),
+				 gamma_zero_half->calc_cond_mean(a_tilde, b_tilde, p_tilde_zero_half),
+				 COND_MEAN_TOL * calc_mixture_mean(*gamma_zero_half, p_tilde_zero_half));
+}
+
+
+
+
+// the conditional expectation is only updated by `sample_gamma` after the
+// burn-in phase
+
+void GammaCategTest::test_cond_mean_burn() {
+
+    // fixture setup
+    const bool old_burn_status = g_burn_status;
+    const double init_cond_mean = gamma_zero_one->m_cond_mean;
+
+    // exercise SUT and verify outcome
+    g_burn_status = true;
+    gamma_zero_one->sample_gamma(a_tilde, b_tilde, p_tilde_zero_one);
+    CPPUNIT_ASSERT_EQUAL(init_cond_mean, gamma_zero_one->m_cond_mean);
+    CPPUNIT_ASSERT_EQUAL(init_cond_mean, gamma_zero_one->cond_mean());
+
+    g_burn_status = false;
+    gamma_zero_one->sample_gamma(a_tilde, b_tilde, p_tilde_zero_one);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(gamma_zero_one->calc_cond_mean(a_tilde, b_tilde, p_tilde_zero_one),
+				 gamma_zero_one->cond_mean(),
+				 epsilon);
+
+    g_burn_status = old_burn_status;
+}
+
+
+
+
+// utility functions -----------------------------------------------------------
+
+// the mean of the mixture of the point mass at 1 with probability `p_tilde` and
+// the `Gamma(a_tilde, b_tilde)` distribution truncated to `(l, u)`, the bounds
+// of `gamma`.  The mean of the truncated distribution is calculated as
+//
+//     l + int_l^u { 1 - F_trunc(x) } dx
+//
+// where `F_trunc` is its CDF, and the integral is calculated numerically by the
+// midpoint rule.  The integrand is bounded even when `a_tilde < 1`.  An
+// infinite upper bound is replaced by a point far enough into the tail that the
+// remaining mass is negligible.
+
+double GammaCategTest::calc_mixture_mean(const GammaCateg& gamma, double p_tilde) {
+
+    const double scale = 1.0 / b_tilde;
+    const double lower = gamma.m_bnd_l;
+    const double upper = std::fmin(gamma.m_bnd_u, lower + R::qgamma(1e-15, a_tilde, scale, 0, 0));
+    const double F_lower = R::pgamma(lower, a_tilde, scale, 1, 0);
+    const double F_upper = R::pgamma(upper, a_tilde, scale, 1, 0);
+    const double width = (upper - lower) / N_GAM_INTS;
+
+    double sum_surv = 0.0;
+    for (int k = 0; k < N_GAM_INTS; ++k) {
+	const double x = lower + ((k + 0.5) * width);
+	sum_surv += (F_upper - R::pgamma(x, a_tilde, scale, 1, 0)) / (F_upper - F_lower);
+    }
+
+    return p_tilde + ((1 - p_tilde) * (lower + (sum_surv * width)));
+}
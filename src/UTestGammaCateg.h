@@ -23,12 +23,18 @@ public:
     void test_calculations();
     void test_sample_gamma();
     void test_sample();
+    void test_calc_cond_mean();
+    void test_cond_mean_burn();
+
+    double calc_mixture_mean(const GammaCateg& gamma, double p_tilde);
 
     CPPUNIT_TEST_SUITE(GammaCategTest);
     CPPUNIT_TEST(test_constructor);
     CPPUNIT_TEST(test_calculations);
     CPPUNIT_TEST(test_sample_gamma);
     CPPUNIT_TEST(test_sample);
+    CPPUNIT_TEST(test_calc_cond_mean);
+    CPPUNIT_TEST(test_cond_mean_burn);
     CPPUNIT_TEST_SUITE_END();
 
 
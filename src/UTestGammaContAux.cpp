@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <cmath>
+#include "Rcpp.h"
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "GammaGen.h"
+#include "UTestGammaContAux.h"
+
+#define EPSILON 0.000000000001
+
+// the hyperparameters of the prior
+#define HYP_A 1.2
+#define HYP_B 0.9
+#define HYP_P 0.5
+
+// the number of draws for the tests of the distribution of the samples, and
+// the tolerance for the comparisons with the target distribution
+#define N_DRAWS    50000
+#define PROB_TOL   0.03
+#define MEAN_TOL   0.05
+
+extern int* d2s;
+
+// a 0/1 column, and a continuous column with the values used by the
+// `GammaContMHTest` fixture
+static const double u_binary[9] = { 1.0, 0.0, 1.0, 1.0, 1.0, 0.0, 1.0, 1.0, 1.0 };
+static const double* const u_cont = GammaContMHTest::FromScratchDays::u_vals;
+
+
+
+
+// the data for the days is that of the `GammaContMHTest` fixture, where the
+// values of `U * beta` are those for a current value of 0 for `beta_h`
+
+GammaContAuxTest::GammaContAuxTest() :
+    U(Rcpp::NumericMatrix(9, 1)),
+    w_day_vals(GammaContMHTest::FromScratchDays::w_day_vals),
+    ubeta_init(GammaContMHTest::FromScratchDays::ubeta_vals)
+{
+    std::fill(X, X + 9, 1);
+}
+
+
+
+
+void GammaContAuxTest::setUp() {
+    days_obj  = new GammaContMHTest::FromScratchDays();
+    w_obj     = new GammaContMHTest::FromScratchW();
+    xi_obj    = new GammaContMHTest::FromScratchXi();
+    ubeta_obj = new GammaContMHTest::FromScratchUbeta();
+}
+
+
+
+
+void GammaContAuxTest::tearDown() {
+    delete w_obj;
+    delete xi_obj;
+    delete ubeta_obj;
+    delete days_obj;
+}
+
+
+
+
+void GammaContAuxTest::test_log_trunc_prob() {
+
+    // fixture setup
+    GammaContAux gamma = gen_gamma(u_binary);
+
+    // exercise SUT.  The second interval is in the upper tail.
+    double out_mid  = gamma.log_trunc_prob(2.5, 0.5, 2.0);
+    double out_tail = gamma.log_trunc_prob(2.5, 20.0, R_PosInf);
+
+    // verify outcome
+    const double target_mid = log(R::pgamma(2.0, 2.5, 1.0 / HYP_B, 1, 0)
+				  - R::pgamma(0.5, 2.5, 1.0 / HYP_B, 1, 0));
+    const double target_tail = R::pgamma(20.0, 2.5, 1.0 / HYP_B, 0, 1);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target_mid,  out_mid,  EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target_tail, out_tail, EPSILON);
+}
+
+
+
+
+void GammaContAuxTest::test_sample_gamma_bnds() {
+
+    // fixture setup
+    GammaContAux gamma = gen_gamma(u_binary);
+    set_seed(11);
+
+    // exercise SUT and verify outcome
+    for (int s = 0; s < 1000; ++s) {
+	const double out = gamma.sample_gamma(2.5, 0.5, 2.0);
+	CPPUNIT_ASSERT((0.5 <= out) && (out <= 2.0));
+    }
+}
+
+
+
+
+// the mean of the samples is the mean of the truncated gamma distribution,
+// which is
+//
+//     (shape / b) * P(l < G' < u) / P(l < G < u)
+//
+// for `G ~ Gamma(shape, b)` and `G' ~ Gamma(shape + 1, b)`
+
+void GammaContAuxTest::test_sample_gamma_mean() {
+
+    // fixture setup
+    GammaContAux gamma = gen_gamma(u_binary);
+    set_seed(12);
+
+    // exercise SUT
+    double sum_val = 0.0;
+    for (int s = 0; s < N_DRAWS; ++s) {
+	sum_val += gamma.sample_gamma(2.5, 0.5, 2.0);
+    }
+
+    // verify outcome
+    const double scale = 1.0 / HYP_B;
+    const double target = ((2.5 / HYP_B)
+			   * (R::pgamma(2.0, 3.5, scale, 1, 0) - R::pgamma(0.5, 3.5, scale, 1, 0))
+			   / (R::pgamma(2.0, 2.5, scale, 1, 0) - R::pgamma(0.5, 2.5, scale, 1, 0)));
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target, sum_val / N_DRAWS, MEAN_TOL * target);
+}
+
+
+
+
+// an interval in the upper tail, for which the lower tail probabilities are
+// rounded to 1
+
+void GammaContAuxTest::test_sample_gamma_upper_tail() {
+
+    // fixture setup
+    GammaContAux gamma = gen_gamma(u_binary);
+    set_seed(13);
+
+    // exercise SUT and verify outcome
+    for (int s = 0; s < 1000; ++s) {
+	const double out = gamma.sample_gamma(2.5, 60.0, R_PosInf);
+	CPPUNIT_ASSERT((60.0 <= out) && (out < R_PosInf));
+    }
+}
+
+
+
+
+// for a 0/1 column the full conditional of gamma_h has a closed form, and the
+// samples are from it
+
+void GammaContAuxTest::test_sample_binary() {
+
+    // fixture setup
+    GammaContAux gamma = gen_gamma(u_binary);
+    set_seed(14);
+
+    // exercise SUT
+    double frac_one, cont_mean;
+    run_chain(gamma, N_DRAWS, &frac_one, &cont_mean);
+
+    // verify outcome.  With `C` the sum of `X_ijk * xi_i * exp(u_ijk^T beta)`
+    // over the days with `U_ijkh == 1` for `beta_h` equal to 0, and `w_sum` the
+    // sum of `W * U_h`, the continuous part of the full conditional is a
+    // `Gamma(a + w_sum, b + C)` distribution and the point mass at 1 has
+    // probability proportional to `p * exp(-C)`.
+    const double* xi_vals = xi_obj->xi().vals();
+    double c_sum = 0.0;
+    double w_sum = 0.0;
+    for (int r = 0; r < 9; ++r) {
+	c_sum += u_binary[r] * X[r] * xi_vals[ d2s[r] ] * exp(ubeta_init[r]);
+	w_sum += u_binary[r] * w_day_vals[r];
+    }
+    const double shape = HYP_A + w_sum;
+    const double log_p_one = log(HYP_P) - c_sum;
+    const double log_p_cont = (log(1 - HYP_P)
+			       + (HYP_A * log(HYP_B)) - R::lgammafn(HYP_A)
+			       + R::lgammafn(shape) - (shape * log(HYP_B + c_sum)));
+    const double target_p_one = 1.0 / (1.0 + exp(log_p_cont - log_p_one));
+    const double target_mean = shape / (HYP_B + c_sum);
+
+    // the closed form agrees with the numerical integration used for a
+    // continuous column
+    double quad_p_one, quad_mean;
+    calc_target(u_binary, &quad_p_one, &quad_mean);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target_p_one, quad_p_one, 0.000001);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target_mean,  quad_mean,  0.000001);
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target_p_one, frac_one,  PROB_TOL);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target_mean,  cont_mean, MEAN_TOL * target_mean);
+}
+
+
+
+
+// for a continuous column the full conditional of gamma_h is calculated by
+// numerical integration, and the samples are from it
+
+void GammaContAuxTest::test_sample_cont() {
+
+    // fixture setup
+    GammaContAux gamma = gen_gamma(u_cont);
+    set_seed(15);
+
+    // exercise SUT
+    double frac_one, cont_mean;
+    run_chain(gamma, N_DRAWS, &frac_one, &cont_mean);
+
+    // verify outcome
+    double target_p_one, target_mean;
+    calc_target(u_cont, &target_p_one, &target_mean);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target_p_one, frac_one,  PROB_TOL);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target_mean,  cont_mean, MEAN_TOL * target_mean);
+}
+
+
+
+
+// utility functions -----------------------------------------------------------
+
+void GammaContAuxTest::set_seed(int seed_val) {
+
+    // register seed function
+    Rcpp::Environment base("package:base");
+    Rcpp::Function set_seed = base["set.seed"];
+
+    // set R's internal seed
+    set_seed(seed_val);
+}
+
+
+
+
+// creates an object for the column with values `u_vals` with a current value
+// of 0 for `beta_h`, in agreement with the values of `U * beta` in the fixture
+
+GammaContAux GammaContAuxTest::gen_gamma(const double* u_vals) {
+
+    std::copy(u_vals, u_vals + 9, U.begin());
+    Rcpp::NumericVector gamma_specs = Rcpp::NumericVector::create(Rcpp::_["h"]     = 0.0,
+								  Rcpp::_["hyp_a"] = HYP_A,
+								  Rcpp::_["hyp_b"] = HYP_B,
+								  Rcpp::_["hyp_p"] = HYP_P,
+								  Rcpp::_["bnd_l"] = 0.0,
+								  Rcpp::_["bnd_u"] = R_PosInf);
+
+    return GammaContAux(U, gamma_specs);
+}
+
+
+
+
+// run the chain for gamma_h with the other parameters held fixed, and calculate
+// the fraction of the samples at the point mass and the mean of the other
+// samples
+
+void GammaContAuxTest::run_chain(GammaContAux& gamma, int n_iter, double* frac_one, double* cont_mean) {
+
+    int n_one = 0;
+    double cont_sum = 0.0;
+    for (int s = 0; s < n_iter; ++s) {
+	const double gam_val = gamma.sample(w_obj->W(), xi_obj->xi(), ubeta_obj->ubeta(), X);
+	if (gam_val == 1.0) {
+	    ++n_one;
+	}
+	else {
+	    cont_sum += gam_val;
+	}
+    }
+
+    *frac_one = ((double) n_one) / n_iter;
+    *cont_mean = cont_sum / (n_iter - n_one);
+}
+
+
+
+
+// the log-likelihood of `beta_h`, up to a constant, for the column with values
+// `u_vals`
+
+double GammaContAuxTest::log_lik(const double* u_vals, double beta) {
+
+    const double* xi_vals = xi_obj->xi().vals();
+
+    double sum_val = 0.0;
+    for (int r = 0; r < 9; ++r) {
+	const double c_val = X[r] * xi_vals[ d2s[r] ] * exp(ubeta_init[r]);
+	sum_val += (w_day_vals[r] * u_vals[r] * beta) - (c_val * exp(u_vals[r] * beta));
+    }
+
+    return sum_val;
+}
+
+
+
+
+// the probability of the point mass at 1 and the mean of the continuous part
+// of the full conditional of gamma_h, where the continuous part is integrated
+// numerically over `beta_h` by the trapezoid rule
+
+void GammaContAuxTest::calc_target(const double* u_vals, double* p_one, double* cont_mean) {
+
+    const int n_grid = 200001;
+    const double beta_l = -20.0;
+    const double beta_u = 6.0;
+    const double width = (beta_u - beta_l) / (n_grid - 1);
+    const double log_p_one = log(HYP_P) + log_lik(u_vals, 0.0);
+
+    // the log density of the continuous part with respect to `beta_h`, which
+    // includes the Jacobian `gamma_h`, relative to `log_p_one`
+    double den_sum = 0.0;
+    double mean_sum = 0.0;
+    for (int t = 0; t < n_grid; ++t) {
+	const double beta = beta_l + (t * width);
+	const double log_den = (log(1 - HYP_P)
+				+ (HYP_A * log(HYP_B)) - R::lgammafn(HYP_A)
+				+ (HYP_A * beta) - (HYP_B * exp(beta))
+				+ log_lik(u_vals, beta)
+				- log_p_one);
+	const double wt = ((t == 0) || (t == n_grid - 1)) ? 0.5 : 1.0;
+	den_sum += wt * exp(log_den);
+	mean_sum += wt * exp(log_den + beta);
+    }
+    den_sum *= width;
+    mean_sum *= width;
+
+    *p_one = 1.0 / (1.0 + den_sum);
+    *cont_mean = mean_sum / den_sum;
+}
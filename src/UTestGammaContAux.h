@@ -0,0 +1,62 @@
+#ifndef DSP_BAYES_UTEST_GAMMA_CONT_AUX_H
+#define DSP_BAYES_UTEST_GAMMA_CONT_AUX_H
+
+
+#include "cppunit/extensions/HelperMacros.h"
+#include "Rcpp.h"
+
+#include "GammaGen.h"
+#include "UTestGammaContMH.h"
+
+
+
+
+class GammaContAuxTest : public CppUnit::TestFixture {
+
+public:
+
+    // constructor
+    GammaContAuxTest();
+
+    // setUp, tearDown
+    void setUp();
+    void tearDown();
+
+    // test methods
+    void test_log_trunc_prob();
+    void test_sample_gamma_bnds();
+    void test_sample_gamma_mean();
+    void test_sample_gamma_upper_tail();
+    void test_sample_binary();
+    void test_sample_cont();
+
+    // utility functions
+    void set_seed(int seed_val);
+    GammaContAux gen_gamma(const double* u_vals);
+    void run_chain(GammaContAux& gamma, int n_iter, double* frac_one, double* cont_mean);
+    double log_lik(const double* u_vals, double beta);
+    void calc_target(const double* u_vals, double* p_one, double* cont_mean);
+
+    CPPUNIT_TEST_SUITE(GammaContAuxTest);
+    CPPUNIT_TEST(test_log_trunc_prob);
+    CPPUNIT_TEST(test_sample_gamma_bnds);
+    CPPUNIT_TEST(test_sample_gamma_mean);
+    CPPUNIT_TEST(test_sample_gamma_upper_tail);
+    CPPUNIT_TEST(test_sample_binary);
+    CPPUNIT_TEST(test_sample_cont);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    Rcpp::NumericMatrix U;
+    GammaContMHTest::FromScratchDays* days_obj;
+    GammaContMHTest::FromScratchW* w_obj;
+    GammaContMHTest::FromScratchXi* xi_obj;
+    GammaContMHTest::FromScratchUbeta* ubeta_obj;
+    int X[9];
+    const int* w_day_vals;
+    const double* ubeta_init;
+};
+
+
+#endif
@@ -11,30 +11,34 @@
 #define SEED_YIELDS_0_29  24
 #define SEED_YIELDS_0_91  72
 
+// the number of samples and the tolerances used to compare the delayed
+// acceptance and multiple-try Metropolis chains to the Metropolis-Hastings
+// chain
+#define N_DRAWS   50000
+#define PROB_TOL  0.03
+#define MEAN_TOL  0.05
+
 extern int* d2s;
+extern bool g_burn_status;
 
 
 
 
 GammaContMHTest::GammaContMHTest() :
     m_Uh(Rcpp::NumericMatrix(10, 1))
-{
-    std::copy(d2s, d2s + 9, old_d2s);
-    new_d2s[0] = 0;    new_d2s[1] = 0;    new_d2s[2] = 0;    new_d2s[3] = 0;    new_d2s[4] = 0;
-    new_d2s[5] = 1;    new_d2s[6] = 1;    new_d2s[7] = 1;    new_d2s[8] = 1;
-}
+{}
 
 
 
 
 void GammaContMHTest::setUp() {
+    days_obj  = new GammaContMHTest::FromScratchDays();
     gamma_obj = new GammaContMHTest::FromScratchGamma();
     w_obj     = new GammaContMHTest::FromScratchW();
     xi_obj    = new GammaContMHTest::FromScratchXi();
     ubeta_obj = new GammaContMHTest::FromScratchUbeta();
     X         = new int[9];
     std::fill(X, X + 9, 1);
-    std::copy(new_d2s, new_d2s + 9, d2s);
 }
 
 
@@ -46,7 +50,7 @@ void GammaContMHTest::tearDown() {
     delete xi_obj;
     delete ubeta_obj;
     delete[] X;
-    std::copy(old_d2s, old_d2s + 9, d2s);
+    delete days_obj;
 }
 
 
@@ -152,6 +156,165 @@ void GammaContMHTest::test_get_w_log_lik() {
 
 
 
+// for a 0/1 column the surrogate used by delayed acceptance is exact when it is
+// calculated from the current values of the other parameters
+
+void GammaContMHTest::test_get_w_log_lik_surr_binary() {
+
+    // fixture setup.  The column is nonzero on days 0, 2, 3, 5, 6, and 8, of
+    // which the pregnancy cycle days are days 2, 3, and 8 with `W` values of 1,
+    // 0, and 0.
+    Rcpp::NumericMatrix U(9, 1);
+    U[0] = 1.0;    U[1] = 0.0;    U[2] = 1.0;    U[3] = 1.0;    U[4] = 0.0;
+    U[5] = 1.0;    U[6] = 1.0;    U[7] = 0.0;    U[8] = 1.0;
+    GammaContMH gamma = gen_gamma_mh(U, 1, 1);
+    gamma.m_beta_val = 0.5;
+    gamma.m_gam_val = exp(0.5);
+
+    // exercise SUT
+    gamma.calc_surr_stats(xi_obj->xi(), ubeta_obj->ubeta(), X);
+    gamma.m_da_w_sum = 1.0;
+    double out_surr = gamma.get_w_log_lik_surr(0.6);
+    double out_exact = gamma.get_w_log_lik(w_obj->W(), xi_obj->xi(), ubeta_obj->ubeta(), X, 0.6);
+
+    // verify outcome
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, gamma.m_da_u_mean, EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, gamma.m_da_u_var,  EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(out_exact, out_surr, EPSILON);
+}
+
+
+
+
+// the samples obtained with delayed acceptance are from the same distribution
+// as the samples obtained by the Metropolis-Hastings step.  The surrogate is
+// recalculated every 5 proposals after the burn-in phase, and is only
+// approximate for the continuous column of the fixture.
+
+void GammaContMHTest::test_sample_da_matches_mh() {
+
+    // fixture setup.  The values of `U * beta` in the fixture correspond to a
+    // value of 0 for `beta_h`.
+    const bool old_burn_status = g_burn_status;
+    g_burn_status = false;
+    Rcpp::NumericMatrix U(9, 1);
+    std::copy(gamma_obj->U.begin(), gamma_obj->U.end(), U.begin());
+    GammaContMH gamma_mh = gen_gamma_mh(U, 0, 1);
+    GammaContMH gamma_da = gen_gamma_mh(U, 5, 1);
+
+    // exercise SUT
+    double mh_frac_one, mh_cont_mean;
+    set_seed(16);
+    run_chain(gamma_mh, N_DRAWS, &mh_frac_one, &mh_cont_mean);
+
+    double da_frac_one, da_cont_mean;
+    delete ubeta_obj;
+    ubeta_obj = new GammaContMHTest::FromScratchUbeta();
+    set_seed(17);
+    run_chain(gamma_da, N_DRAWS, &da_frac_one, &da_cont_mean);
+
+    g_burn_status = old_burn_status;
+
+    // verify outcome
+    CPPUNIT_ASSERT_EQUAL(0, gamma_mh.m_da_ctr);
+    CPPUNIT_ASSERT_EQUAL(N_DRAWS, gamma_da.m_da_ctr);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(mh_frac_one,  da_frac_one,  PROB_TOL);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(mh_cont_mean, da_cont_mean, MEAN_TOL * mh_cont_mean);
+}
+
+
+
+
+// multiple-try Metropolis with a single proposal is the Metropolis-Hastings
+// step, so that the same seed provides the same samples
+
+void GammaContMHTest::test_sample_mtm_n_try_1() {
+
+    // fixture setup
+    const bool old_burn_status = g_burn_status;
+    g_burn_status = false;
+    Rcpp::NumericMatrix U(9, 1);
+    std::copy(gamma_obj->U.begin(), gamma_obj->U.end(), U.begin());
+    GammaContMH gamma_mtm = gen_gamma_mh(U, 0, 1);
+
+    Rcpp::NumericVector gamma_specs = Rcpp::NumericVector::create(Rcpp::_["h"]        = 0.0,
+								  Rcpp::_["hyp_a"]    = 1.2,
+								  Rcpp::_["hyp_b"]    = 0.9,
+								  Rcpp::_["hyp_p"]    = 0.5,
+								  Rcpp::_["bnd_l"]    = 0.0,
+								  Rcpp::_["bnd_u"]    = R_PosInf,
+								  Rcpp::_["mh_p"]     = 0.3,
+								  Rcpp::_["mh_delta"] = 0.5);
+    GammaContMH gamma_no_spec(U, gamma_specs);
+
+    // exercise SUT
+    const int n_iter = 1000;
+    double mh_draws[n_iter];
+    set_seed(18);
+    for (int s = 0; s < n_iter; ++s) {
+	mh_draws[s] = gamma_no_spec.sample(w_obj->W(), xi_obj->xi(), ubeta_obj->ubeta(), X);
+    }
+
+    delete ubeta_obj;
+    ubeta_obj = new GammaContMHTest::FromScratchUbeta();
+    double mtm_draws[n_iter];
+    set_seed(18);
+    for (int s = 0; s < n_iter; ++s) {
+	mtm_draws[s] = gamma_mtm.sample(w_obj->W(), xi_obj->xi(), ubeta_obj->ubeta(), X);
+    }
+
+    g_burn_status = old_burn_status;
+
+    // verify outcome
+    CPPUNIT_ASSERT_EQUAL(1, gamma_no_spec.m_n_try);
+    CPPUNIT_ASSERT_EQUAL(1, gamma_mtm.m_n_try);
+    for (int s = 0; s < n_iter; ++s) {
+	CPPUNIT_ASSERT_EQUAL(mh_draws[s], mtm_draws[s]);
+    }
+    CPPUNIT_ASSERT_EQUAL(gamma_no_spec.m_mh_accept_ctr, gamma_mtm.m_mh_accept_ctr);
+}
+
+
+
+
+// the samples obtained by multiple-try Metropolis with several proposals are
+// from the same distribution as the samples obtained by the
+// Metropolis-Hastings step
+
+void GammaContMHTest::test_sample_mtm_matches_mh() {
+
+    // fixture setup
+    const bool old_burn_status = g_burn_status;
+    g_burn_status = false;
+    Rcpp::NumericMatrix U(9, 1);
+    std::copy(gamma_obj->U.begin(), gamma_obj->U.end(), U.begin());
+    GammaContMH gamma_mh = gen_gamma_mh(U, 0, 1);
+    GammaContMH gamma_mtm = gen_gamma_mh(U, 5, 4);
+
+    // exercise SUT
+    double mh_frac_one, mh_cont_mean;
+    set_seed(19);
+    run_chain(gamma_mh, N_DRAWS, &mh_frac_one, &mh_cont_mean);
+
+    double mtm_frac_one, mtm_cont_mean;
+    delete ubeta_obj;
+    ubeta_obj = new GammaContMHTest::FromScratchUbeta();
+    set_seed(20);
+    run_chain(gamma_mtm, N_DRAWS, &mtm_frac_one, &mtm_cont_mean);
+
+    g_burn_status = old_burn_status;
+
+    // verify outcome.  Delayed acceptance isn't used together with
+    // multiple-try Metropolis.
+    CPPUNIT_ASSERT_EQUAL(4, gamma_mtm.m_n_try);
+    CPPUNIT_ASSERT_EQUAL(0, gamma_mtm.m_da_refresh);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(mh_frac_one,  mtm_frac_one,  PROB_TOL);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(mh_cont_mean, mtm_cont_mean, MEAN_TOL * mh_cont_mean);
+}
+
+
+
+
 // 1.0 proposal, 1.0 current
 void GammaContMHTest::test_get_gam_log_lik_10_10() {
 
@@ -329,6 +492,47 @@ void GammaContMHTest::test_log_dgamma_trunc_norm_const_bnd_05_1() {
 
 // construct dataset for testing -----------------------------------------------
 
+const int GammaContMHTest::FromScratchDays::d2s_vals[9] = { 0, 0, 0, 0, 0, 1, 1, 1, 1 };
+const double GammaContMHTest::FromScratchDays::u_vals[9] = { 1.0, 0.3, 0.4, 1.2, 1.1, 1.5, 0.2, 0.6, 1.3 };
+const int GammaContMHTest::FromScratchDays::x_vals[9] = { 1, 0, 1, 1, 1, 0, 2, 1, 1 };
+const int GammaContMHTest::FromScratchDays::w_day_vals[9] = { 0, 0, 1, 0, 2, 0, 0, 1, 0 };
+const double GammaContMHTest::FromScratchDays::ubeta_vals[9] = { 0.0, -0.1, 0.6, 0.2, 1.0, -0.3, 0.2, 0.5, 0.3 };
+const int GammaContMHTest::FromScratchDays::w_days_idx[5] = { 2, 3, 4, 7, 8 };
+const int GammaContMHTest::FromScratchDays::w_cyc_to_subj_idx[2] = { 0, 1 };
+
+
+
+
+GammaContMHTest::FromScratchDays::FromScratchDays() {
+    std::copy(d2s, d2s + 9, old_d2s);
+    std::copy(d2s_vals, d2s_vals + 9, d2s);
+}
+
+
+
+
+GammaContMHTest::FromScratchDays::~FromScratchDays() {
+    std::copy(old_d2s, old_d2s + 9, d2s);
+}
+
+
+
+
+// creates a `WGen` object for the pregnancy cycles of the days.  The caller
+// takes ownership of the object.
+
+WGen* GammaContMHTest::FromScratchDays::new_w() {
+
+    PregCyc* preg_cyc = new PregCyc[2];
+    preg_cyc[0] = PregCyc(2, 3, 0);
+    preg_cyc[1] = PregCyc(7, 2, 1);
+
+    return new WGen(preg_cyc, 2, w_days_idx, 5, w_cyc_to_subj_idx, 5);
+}
+
+
+
+
 GammaContMHTest::FromScratchGamma::FromScratchGamma() :
     U(Rcpp::NumericMatrix(9, 1)),
     gamma_specs(Rcpp::NumericVector::create(Rcpp::_["h"]        = 0.0,
@@ -411,15 +615,10 @@ GammaContMHTest::FromScratchUbeta::FromScratchUbeta() :
     ubeta_obj(9)
 {
     // set `ubeta_obj` values
-    ubeta_obj.m_vals[0] =  0.0;    ubeta_obj.m_exp_vals[0] = exp( 0.0);
-    ubeta_obj.m_vals[1] = -0.1;    ubeta_obj.m_exp_vals[1] = exp(-0.1);
-    ubeta_obj.m_vals[2] =  0.6;    ubeta_obj.m_exp_vals[2] = exp( 0.6);
-    ubeta_obj.m_vals[3] =  0.2;    ubeta_obj.m_exp_vals[3] = exp( 0.2);
-    ubeta_obj.m_vals[4] =  1.0;    ubeta_obj.m_exp_vals[4] = exp( 1.0);
-    ubeta_obj.m_vals[5] = -0.3;    ubeta_obj.m_exp_vals[5] = exp(-0.3);
-    ubeta_obj.m_vals[6] =  0.2;    ubeta_obj.m_exp_vals[6] = exp( 0.2);
-    ubeta_obj.m_vals[7] =  0.5;    ubeta_obj.m_exp_vals[7] = exp( 0.5);
-    ubeta_obj.m_vals[8] =  0.3;    ubeta_obj.m_exp_vals[8] = exp( 0.3);
+    for (int r = 0; r < 9; ++r) {
+	ubeta_obj.m_vals[r]     = FromScratchDays::ubeta_vals[r];
+	ubeta_obj.m_exp_vals[r] = exp(FromScratchDays::ubeta_vals[r]);
+    }
 }
 
 
@@ -504,3 +703,52 @@ GammaContMH GammaContMHTest::gen_gamma_curr(double curr) {
 
     return gamma;
 }
+
+
+
+
+// creates an object for the column `U` with a current value of 0 for `beta_h`,
+// which uses delayed acceptance with the surrogate recalculated every
+// `da_refresh` proposals, or multiple-try Metropolis with `n_try` proposals,
+// or otherwise a plain Metropolis-Hastings step
+
+GammaContMH GammaContMHTest::gen_gamma_mh(const Rcpp::NumericMatrix& U, int da_refresh, int n_try) {
+
+    Rcpp::NumericVector gamma_specs = Rcpp::NumericVector::create(Rcpp::_["h"]          = 0.0,
+								  Rcpp::_["hyp_a"]      = 1.2,
+								  Rcpp::_["hyp_b"]      = 0.9,
+								  Rcpp::_["hyp_p"]      = 0.5,
+								  Rcpp::_["bnd_l"]      = 0.0,
+								  Rcpp::_["bnd_u"]      = R_PosInf,
+								  Rcpp::_["mh_p"]       = 0.3,
+								  Rcpp::_["mh_delta"]   = 0.5,
+								  Rcpp::_["da_refresh"] = da_refresh,
+								  Rcpp::_["n_try"]      = n_try);
+
+    return GammaContMH(U, gamma_specs);
+}
+
+
+
+
+// run the chain for gamma_h with the other parameters held fixed, and calculate
+// the fraction of the samples at the point mass and the mean of the other
+// samples
+
+void GammaContMHTest::run_chain(GammaContMH& gamma, int n_iter, double* frac_one, double* cont_mean) {
+
+    int n_one = 0;
+    double cont_sum = 0.0;
+    for (int s = 0; s < n_iter; ++s) {
+	const double gam_val = gamma.sample(w_obj->W(), xi_obj->xi(), ubeta_obj->ubeta(), X);
+	if (gam_val == 1.0) {
+	    ++n_one;
+	}
+	else {
+	    cont_sum += gam_val;
+	}
+    }
+
+    *frac_one = ((double) n_one) / n_iter;
+    *cont_mean = cont_sum / (n_iter - n_one);
+}
@@ -20,6 +20,7 @@ class GammaContMHTest : public CppUnit::TestFixture {
 public:
 
     // inner classes
+    class FromScratchDays;
     class FromScratchW;
     class FromScratchXi;
     class FromScratchUbeta;
@@ -39,6 +40,10 @@ public:
     void test_sample_proposal_beta_from_cont();
     void test_get_log_r();
     void test_get_w_log_lik();
+    void test_get_w_log_lik_surr_binary();
+    void test_sample_da_matches_mh();
+    void test_sample_mtm_n_try_1();
+    void test_sample_mtm_matches_mh();
     void test_get_gam_log_lik_10_10();
     void test_get_gam_log_lik_10_12();
     void test_get_gam_log_lik_12_10();
@@ -55,6 +60,8 @@ public:
     GammaContMH gen_gamma_proposal2_propval04();
     GammaContMH gen_gamma_bndl_bndu(double bnd_l,  double bnd_u);
     GammaContMH gen_gamma_curr(double curr);
+    GammaContMH gen_gamma_mh(const Rcpp::NumericMatrix& U, int da_refresh, int n_try);
+    void run_chain(GammaContMH& gamma, int n_iter, double* frac_one, double* cont_mean);
 
     CPPUNIT_TEST_SUITE(GammaContMHTest);
     CPPUNIT_TEST(test_constructor);
@@ -63,6 +70,10 @@ public:
     CPPUNIT_TEST(test_sample_proposal_beta_from_cont);
     CPPUNIT_TEST(test_get_log_r);
     CPPUNIT_TEST(test_get_w_log_lik);
+    CPPUNIT_TEST(test_get_w_log_lik_surr_binary);
+    CPPUNIT_TEST(test_sample_da_matches_mh);
+    CPPUNIT_TEST(test_sample_mtm_n_try_1);
+    CPPUNIT_TEST(test_sample_mtm_matches_mh);
     CPPUNIT_TEST(test_get_gam_log_lik_10_10);
     CPPUNIT_TEST(test_get_gam_log_lik_10_12);
     CPPUNIT_TEST(test_get_gam_log_lik_12_10);
@@ -77,14 +88,47 @@ public:
 
 private:
 
+    FromScratchDays* days_obj;
     FromScratchGamma* gamma_obj;
     FromScratchW* w_obj;
     FromScratchXi* xi_obj;
     FromScratchUbeta* ubeta_obj;
     int* X;
     Rcpp::NumericMatrix m_Uh;
+};
+
+
+
+
+// the data for the nine days that is shared by the fixtures of the samplers.
+// Creating an object maps days 0 - 4 to the first subject and days 5 - 8 to the
+// second subject in `d2s`, and destroying it restores the previous mapping.
+// Each subject has one pregnancy cycle, which are days 2 - 4 for the first
+// subject and days 7 - 8 for the second subject.
+
+class GammaContMHTest::FromScratchDays {
+
+public:
+
+    // the map from days to subjects, the values of a continuous column of `U`,
+    // of `X` (several of the days don't have intercourse), of `W` for each day,
+    // and of `U * beta`
+    static const int d2s_vals[9];
+    static const double u_vals[9];
+    static const int x_vals[9];
+    static const int w_day_vals[9];
+    static const double ubeta_vals[9];
+
+    // the days that the pregnancy days map to, and the subject of each
+    // pregnancy cycle
+    static const int w_days_idx[5];
+    static const int w_cyc_to_subj_idx[2];
+
     int old_d2s[9];
-    int new_d2s[9];
+
+    FromScratchDays();
+    ~FromScratchDays();
+    static WGen* new_w();
 };
 
 
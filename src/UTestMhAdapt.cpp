@@ -0,0 +1,114 @@
+#include <cmath>
+#include "Rcpp.h"
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "MhAdapt.h"
+#include "UTestMhAdapt.h"
+
+#define EPSILON 0.000000000001
+
+
+
+
+void MhAdaptTest::test_next_gain() {
+
+    // fixture setup
+    MhAdapt adapt;
+
+    // exercise SUT and verify outcome.  The n-th gain is `n^(-0.6)`.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0,                adapt.next_gain(), EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.6597539553864471, adapt.next_gain(), EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5172818579717866, adapt.next_gain(), EPSILON);
+    CPPUNIT_ASSERT_EQUAL(3, adapt.m_n_iter);
+}
+
+
+
+
+void MhAdaptTest::test_adapt_step_at_target() {
+
+    // exercise SUT.  An acceptance probability equal to the target leaves the
+    // step size unchanged.
+    double out = MhAdapt::adapt_step(0.3, 0.5, log(MH_ADAPT_TARGET));
+
+    // verify outcome
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.3, out, EPSILON);
+}
+
+
+
+
+void MhAdaptTest::test_adapt_step_above_target() {
+
+    // exercise SUT.  A proposal that is always accepted gives an acceptance
+    // probability of 1 so that the step size is increased.
+    double out = MhAdapt::adapt_step(0.3, 0.5, 2.0);
+
+    // verify outcome.  Result is hand-calculated as `0.3 * exp(0.5 * (1 -
+    // 0.44))`.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.3969389437012311, out, EPSILON);
+}
+
+
+
+
+void MhAdaptTest::test_adapt_step_below_target() {
+
+    // exercise SUT
+    double out = MhAdapt::adapt_step(0.3, 0.5, log(0.1), MH_ADAPT_TARGET_MALA);
+
+    // verify outcome.  Result is hand-calculated as `0.3 * exp(0.5 * (0.1 -
+    // 0.574))`.
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.2366973864052829, out, EPSILON);
+}
+
+
+
+
+void MhAdaptTest::test_adapt_step_bounds() {
+
+    // exercise SUT
+    double out_upper = MhAdapt::adapt_step(exp(MH_ADAPT_LOG_STEP_MAX), 1.0, 0.0);
+    double out_lower = MhAdapt::adapt_step(exp(MH_ADAPT_LOG_STEP_MIN), 1.0, R_NegInf);
+
+    // verify outcome
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(MH_ADAPT_LOG_STEP_MAX), out_upper, EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(MH_ADAPT_LOG_STEP_MIN), out_lower, EPSILON);
+}
+
+
+
+
+// with an acceptance probability of `exp(-step)`, the step size settles at the
+// value with an acceptance probability equal to the target
+
+void MhAdaptTest::test_adapt_step_converges() {
+
+    // fixture setup
+    MhAdapt adapt;
+    double step = 3.0;
+
+    // exercise SUT
+    for (int s = 0; s < 20000; ++s) {
+	step = MhAdapt::adapt_step(step, adapt.next_gain(), -step);
+    }
+
+    // verify outcome
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(-log(MH_ADAPT_TARGET), step, 0.001);
+}
+
+
+
+
+void MhAdaptTest::test_adapt_prob() {
+
+    // exercise SUT
+    double out_mid   = MhAdapt::adapt_prob(0.5, 0.25, 1.0);
+    double out_upper = MhAdapt::adapt_prob(0.9, 1.0, 1.0);
+    double out_lower = MhAdapt::adapt_prob(0.1, 1.0, 0.0);
+
+    // verify outcome
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.625,             out_mid,   EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(MH_ADAPT_PROB_MAX, out_upper, EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(MH_ADAPT_PROB_MIN, out_lower, EPSILON);
+}
@@ -0,0 +1,35 @@
+#ifndef DSP_BAYES_UTEST_MH_ADAPT_H
+#define DSP_BAYES_UTEST_MH_ADAPT_H
+
+
+#include "cppunit/extensions/HelperMacros.h"
+
+
+
+
+class MhAdaptTest : public CppUnit::TestFixture {
+
+public:
+
+    // test methods
+    void test_next_gain();
+    void test_adapt_step_at_target();
+    void test_adapt_step_above_target();
+    void test_adapt_step_below_target();
+    void test_adapt_step_bounds();
+    void test_adapt_step_converges();
+    void test_adapt_prob();
+
+    CPPUNIT_TEST_SUITE(MhAdaptTest);
+    CPPUNIT_TEST(test_next_gain);
+    CPPUNIT_TEST(test_adapt_step_at_target);
+    CPPUNIT_TEST(test_adapt_step_above_target);
+    CPPUNIT_TEST(test_adapt_step_below_target);
+    CPPUNIT_TEST(test_adapt_step_bounds);
+    CPPUNIT_TEST(test_adapt_step_converges);
+    CPPUNIT_TEST(test_adapt_prob);
+    CPPUNIT_TEST_SUITE_END();
+};
+
+
+#endif
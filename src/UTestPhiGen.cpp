@@ -1,9 +1,21 @@
 #include <algorithm>
+#include <cmath>
 #include "Rcpp.h"
 #include "PhiGen.h"
 #include "XiGen.h"
 #include "UTestPhiGen.h"
 #include "UTestFactory.h"
+#include "UTestGammaContMH.h"
+
+// the number of draws by the slice sampler, and the relative tolerance for the
+// sample mean
+#define N_SLICE_DRAWS   20000
+#define SLICE_MEAN_TOL  0.03
+
+// the upper limit and the number of intervals used to integrate the full
+// conditional distribution of phi
+#define PHI_MAX     40.0
+#define N_PHI_INTS  40000
 
 extern UTestFactory g_ut_factory;
 
@@ -171,3 +183,87 @@ void PhiGenTest::test_sample_no_record() {
     CPPUNIT_ASSERT_EQUAL((long int) 0, phi_no_rec->m_vals - phi_no_rec->m_vals_rcpp.begin());
     CPPUNIT_ASSERT_EQUAL(accept_ctr, phi_no_rec->m_accept_ctr);
 }
+
+
+
+
+// when the proposal value is the same as the current value of phi, the
+// interweaving step should map each value of xi back to itself regardless of
+// whether the proposal is accepted
+void PhiGenTest::test_sample_asis_same_phi() {
+
+    Rcpp::NumericVector phi_specs_asis = Rcpp::clone(g_ut_factory.phi_specs);
+    phi_specs_asis.push_back(1.0, "asis");
+    PhiGen phi_asis(phi_specs_asis, n_samp, false);
+    phi_asis.m_asis_delta = 0.0;
+
+    const int n_subj = xi->n_subj();
+    const Rcpp::NumericVector xi_before(xi->vals(), xi->vals() + n_subj);
+
+    Rcpp::Environment base("package:base");
+    Rcpp::Function set_seed = base["set.seed"];
+    set_seed(seed_val);
+
+    phi_asis.sample_asis(*xi);
+    CPPUNIT_ASSERT_EQUAL(mean, phi_asis.val());
+    for (int i = 0; i < n_subj; ++i) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(xi_before[i], xi->vals()[i], epsilon * xi_before[i]);
+    }
+}
+
+
+
+
+// the draws by the slice sampler are from the full conditional distribution of
+// phi, the mean of which is calculated by numerically integrating the
+// unnormalized density
+//
+//     phi^(c1 - 1) * exp(-c2 * phi)
+//         * prod_i { phi^phi / Gamma(phi) * xi_i^(phi - 1) * exp(-phi * xi_i) }
+//
+// for which `c1` and `c2` are 1
+
+void PhiGenTest::test_sample_slice() {
+
+    // fixture setup
+    GammaContMHTest::FromScratchXi xi_obj;
+    XiGen& xi_slice = xi_obj.xi();
+    xi_slice.calc_sums();
+    Rcpp::NumericVector phi_specs_slice = Rcpp::NumericVector::create(Rcpp::_["c1"]    = 1.0,
+								      Rcpp::_["c2"]    = 1.0,
+								      Rcpp::_["delta"] = 0.5,
+								      Rcpp::_["mean"]  = 1.0,
+								      Rcpp::_["slice"] = 1.0);
+    PhiGen phi_slice(phi_specs_slice, 1, false);
+
+    const double* xi_vals = xi_slice.vals();
+    const double width = PHI_MAX / N_PHI_INTS;
+    double sum_dens = 0.0, sum_phi_dens = 0.0;
+    for (int k = 1; k <= N_PHI_INTS; ++k) {
+	const double phi_val = k * width;
+	double log_dens = -phi_val;
+	for (int i = 0; i < 2; ++i) {
+	    log_dens += ((phi_val * log(phi_val)) - R::lgammafn(phi_val)
+			 + ((phi_val - 1.0) * log(xi_vals[i])) - (phi_val * xi_vals[i]));
+	}
+	const double wt = (k == N_PHI_INTS) ? 0.5 : 1.0;
+	sum_dens += wt * exp(log_dens);
+	sum_phi_dens += wt * phi_val * exp(log_dens);
+    }
+    const double target_mean = sum_phi_dens / sum_dens;
+
+    Rcpp::Environment base("package:base");
+    Rcpp::Function set_seed = base["set.seed"];
+    set_seed(22);
+
+    // exercise SUT
+    double sum_phi = 0.0;
+    for (int s = 0; s < N_SLICE_DRAWS; ++s) {
+	*phi_slice.m_vals = phi_slice.sample_slice(xi_slice, NULL);
+	sum_phi += phi_slice.val();
+    }
+
+    // verify outcome
+    CPPUNIT_ASSERT(phi_slice.m_use_slice);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target_mean, sum_phi / N_SLICE_DRAWS, SLICE_MEAN_TOL * target_mean);
+}
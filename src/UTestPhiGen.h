@@ -5,6 +5,7 @@
 #include "PhiGen.h"
 #include "XiGen.h"
 #include "UTestFactory.h"
+#include "UTestGammaContMH.h"
 #include "cppunit/extensions/HelperMacros.h"
 
 extern UTestFactory g_ut_factory;
@@ -24,6 +25,8 @@ public:
     void test_update();
     void test_sample_yes_record();
     void test_sample_no_record();
+    void test_sample_asis_same_phi();
+    void test_sample_slice();
 
     CPPUNIT_TEST_SUITE(PhiGenTest);
     CPPUNIT_TEST(test_constructor);
@@ -31,6 +34,8 @@ public:
     CPPUNIT_TEST(test_update);
     CPPUNIT_TEST(test_sample_yes_record);
     CPPUNIT_TEST(test_sample_no_record);
+    CPPUNIT_TEST(test_sample_asis_same_phi);
+    CPPUNIT_TEST(test_sample_slice);
     CPPUNIT_TEST_SUITE_END();
 
 
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cmath>
+#include "Rcpp.h"
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "CoefGen.h"
+#include "FwDays.h"
+#include "PhiGen.h"
+#include "TemperLadder.h"
+#include "ULevels.h"
+#include "UTestTemperLadder.h"
+#include "WGen.h"
+
+#define EPSILON 0.000000000001
+
+// the current value of the coefficient for the untempered chain, and the ratio
+// of the temperatures of the chains
+#define BETA_CURR   0.5
+#define TEMP_RATIO  1.5
+
+// the number of proposed swaps, and the tolerance for the acceptance rate
+#define N_SWAPS    20000
+#define PROB_TOL   0.02
+
+extern int* d2s;
+extern bool g_burn_status;
+
+
+
+
+// the data for the days is that of the `CycLikTest` fixture, with a single
+// day-level coefficient and a ladder of two chains.  The values of `U * beta`
+// for the untempered chain are those of the `GammaContMHTest` fixture, which
+// are taken to include the term for the current value of the coefficient.
+
+TemperLadderTest::TemperLadderTest() :
+    U(Rcpp::NumericMatrix(9, 1)),
+    X(GammaContMHTest::FromScratchDays::x_vals)
+{
+    std::copy(GammaContMHTest::FromScratchDays::u_vals,
+	      GammaContMHTest::FromScratchDays::u_vals + 9,
+	      U.begin());
+
+    const int d2c_vals[9] = { 0, 0, 1, 1, 1, 2, 2, 3, 3 };
+    const double u_cyc_vals[4] = { 0.5, 1.0, 0.0, 2.0 };
+    const double u_subj_vals[2] = { 0.7, -0.2 };
+    const int fw_pos_vals[9] = { -1, -1, 0, 1, 0, -1, -1, 0, 1 };
+    std::copy(d2c_vals, d2c_vals + 9, d2c);
+    std::copy(u_cyc_vals, u_cyc_vals + 4, u_cyc);
+    std::copy(u_subj_vals, u_subj_vals + 2, u_subj);
+    std::copy(fw_pos_vals, fw_pos_vals + 9, fw_pos);
+
+    Rcpp::NumericVector curr_specs = Rcpp::NumericVector::create(Rcpp::_["type"]     = 1.0,
+								 Rcpp::_["h"]        = 0.0,
+								 Rcpp::_["hyp_a"]    = 1.2,
+								 Rcpp::_["hyp_b"]    = 0.9,
+								 Rcpp::_["hyp_p"]    = 0.5,
+								 Rcpp::_["bnd_l"]    = 0.0,
+								 Rcpp::_["bnd_u"]    = R_PosInf,
+								 Rcpp::_["mh_p"]     = 0.1,
+								 Rcpp::_["mh_delta"] = 0.2);
+    gamma_specs = Rcpp::List::create(curr_specs);
+    phi_specs = Rcpp::NumericVector::create(Rcpp::_["c1"]    = 1.0,
+					    Rcpp::_["c2"]    = 1.0,
+					    Rcpp::_["delta"] = 0.1,
+					    Rcpp::_["mean"]  = 1.0);
+    pt_specs = Rcpp::NumericVector::create(Rcpp::_["n_temps"]    = 2,
+					   Rcpp::_["temp_ratio"] = TEMP_RATIO,
+					   Rcpp::_["swap_every"] = 1);
+}
+
+
+
+
+void TemperLadderTest::setUp() {
+
+    // `ULevels` maps the cycles to subjects using `d2s`
+    days_obj  = new GammaContMHTest::FromScratchDays();
+    old_burn_status = g_burn_status;
+
+    W         = GammaContMHTest::FromScratchDays::new_w();
+    xi_obj    = new GammaContMHTest::FromScratchXi();
+    ubeta_obj = new GammaContMHTest::FromScratchUbeta();
+    levels    = new ULevels(u_cyc, 4, u_subj, 2, d2c, 9);
+    fw        = new FwDays(fw_pos, 9);
+    coefs     = new CoefGen(U.begin(), 9, gamma_specs, 10, levels, fw, NULL, true);
+    phi       = new PhiGen(phi_specs, 10, false);
+    ladder    = new TemperLadder(pt_specs,
+				 *W,
+				 xi_obj->xi(),
+				 *coefs,
+				 *phi,
+				 ubeta_obj->ubeta(),
+				 U.begin(),
+				 9,
+				 gamma_specs,
+				 phi_specs,
+				 10);
+}
+
+
+
+
+void TemperLadderTest::tearDown() {
+    delete ladder;
+    delete coefs;
+    delete phi;
+    delete W;
+    delete xi_obj;
+    delete ubeta_obj;
+    delete levels;
+    delete fw;
+    g_burn_status = old_burn_status;
+    delete days_obj;
+}
+
+
+
+
+// the untempered chain uses the caller's objects, while the tempered chain
+// shares the cycle-level and subject-level data and the fertile window day
+// effects and doesn't record its samples
+
+void TemperLadderTest::test_constructor() {
+
+    const TemperLadder::Chain& cold = ladder->m_chains[0];
+    const TemperLadder::Chain& hot = ladder->m_chains[1];
+
+    CPPUNIT_ASSERT_EQUAL(2, ladder->m_n_chains);
+    CPPUNIT_ASSERT(cold.xi == &xi_obj->xi());
+    CPPUNIT_ASSERT(cold.coefs == coefs);
+    CPPUNIT_ASSERT(cold.phi == phi);
+    CPPUNIT_ASSERT(cold.ubeta == &ubeta_obj->ubeta());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, cold.lik->m_inv_temp, EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0 / TEMP_RATIO, hot.lik->m_inv_temp, EPSILON);
+
+    CPPUNIT_ASSERT(hot.coefs->m_levels == levels);
+    CPPUNIT_ASSERT(hot.coefs->m_fw == fw);
+    CPPUNIT_ASSERT(hot.coefs->m_patterns == NULL);
+    CPPUNIT_ASSERT(! hot.coefs->m_record_status);
+    CPPUNIT_ASSERT_EQUAL(1, (int) hot.coefs->m_vals_rcpp.size());
+}
+
+
+
+
+// the states of the chains are exchanged, including the sums for the
+// likelihood, while the temperatures stay with the chains.  The terms for the
+// scan in the Rao-Blackwellized sums are replaced by the values after the swap.
+
+void TemperLadderTest::test_swap_chains() {
+
+    // fixture setup
+    set_states();
+    TemperLadder::Chain& cold = ladder->m_chains[0];
+    TemperLadder::Chain& hot = ladder->m_chains[1];
+    g_burn_status = false;
+
+    double cold_xi[2], hot_xi[2], cold_cyc[2], hot_cyc[2], cold_subj[2], hot_subj[2];
+    for (int i = 0; i < 2; ++i) {
+	cold_xi[i]   = cold.xi->vals()[i];
+	hot_xi[i]    = hot.xi->vals()[i];
+	cold_cyc[i]  = cold.lik->m_cyc_sums[i];
+	hot_cyc[i]   = hot.lik->m_cyc_sums[i];
+	cold_subj[i] = cold.lik->m_subj_sums[i];
+	hot_subj[i]  = hot.lik->m_subj_sums[i];
+    }
+    double cold_ubeta[9], hot_ubeta[9];
+    std::copy(cold.ubeta->vals(), cold.ubeta->vals() + 9, cold_ubeta);
+    std::copy(hot.ubeta->vals(), hot.ubeta->vals() + 9, hot_ubeta);
+
+    // exercise SUT
+    ladder->swap_chains(0);
+
+    // verify outcome
+    for (int i = 0; i < 2; ++i) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(hot_xi[i],    cold.xi->vals()[i],       EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(cold_xi[i],   hot.xi->vals()[i],        EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(hot_cyc[i],   cold.lik->m_cyc_sums[i],  EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(cold_cyc[i],  hot.lik->m_cyc_sums[i],   EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(hot_subj[i],  cold.lik->m_subj_sums[i], EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(cold_subj[i], hot.lik->m_subj_sums[i],  EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(hot_xi[i] - cold_xi[i], cold.xi->m_rb_sums[i], EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(cold_xi[i] - hot_xi[i], hot.xi->m_rb_sums[i],  EPSILON);
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(hot_xi[0] + hot_xi[1], cold.xi->sum_vals(), EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(cold_xi[0] + cold_xi[1], hot.xi->sum_vals(), EPSILON);
+
+    for (int r = 0; r < 9; ++r) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(hot_ubeta[r],  cold.ubeta->vals()[r], EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(cold_ubeta[r], hot.ubeta->vals()[r],  EPSILON);
+    }
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0,            cold.coefs->m_gamma[0]->m_beta_val, EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0,            cold.coefs->vals()[0],              EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(BETA_CURR,      hot.coefs->m_gamma[0]->m_beta_val,  EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(BETA_CURR), hot.coefs->vals()[0],               EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0 - exp(BETA_CURR), cold.coefs->m_rb_sums[0],     EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(BETA_CURR) - 1.0, hot.coefs->m_rb_sums[0],      EPSILON);
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(2.5, cold.phi->val(), EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.7, hot.phi->val(),  EPSILON);
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, cold.lik->m_inv_temp, EPSILON);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0 / TEMP_RATIO, hot.lik->m_inv_temp, EPSILON);
+}
+
+
+
+
+// the acceptance rate of the proposed swaps is close to
+//
+//     min{ 1, exp((1 / T_0 - 1 / T_1) * (L_1 - L_0)) }
+//
+// where the states are restored after each accepted swap so that each of the
+// proposals is the same
+
+void TemperLadderTest::test_sample_swaps() {
+
+    // fixture setup
+    set_states();
+    const TemperLadder::Chain& cold = ladder->m_chains[0];
+    const TemperLadder::Chain& hot = ladder->m_chains[1];
+    g_burn_status = false;
+
+    const double log_lik_0 = cold.lik->log_lik(cold.xi->vals());
+    const double log_lik_1 = hot.lik->log_lik(hot.xi->vals());
+    const double log_r = (1.0 - (1.0 / TEMP_RATIO)) * (log_lik_1 - log_lik_0);
+    const double target = std::min(1.0, exp(log_r));
+
+    // exercise SUT
+    set_seed(21);
+    for (int s = 0; s < N_SWAPS; ++s) {
+	const int prev_accept_ctr = ladder->m_swap_accept_ctr[0];
+	ladder->sample_swaps();
+	if (ladder->m_swap_accept_ctr[0] > prev_accept_ctr) {
+	    ladder->swap_chains(0);
+	}
+    }
+
+    // verify outcome
+    CPPUNIT_ASSERT_EQUAL(N_SWAPS, ladder->m_swap_prop_ctr[0]);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target, ladder->swap_rates()[0], PROB_TOL);
+}
+
+
+
+
+// utility functions -----------------------------------------------------------
+
+// give the chains different states.  The untempered chain has the coefficient
+// `BETA_CURR` and the values of xi from the `GammaContMHTest` fixture, while the
+// tempered chain has the coefficient 0, for which `U * beta` is 0 for each day.
+
+void TemperLadderTest::set_states() {
+
+    TemperLadder::Chain& cold = ladder->m_chains[0];
+    TemperLadder::Chain& hot = ladder->m_chains[1];
+
+    cold.coefs->m_gamma[0]->m_beta_val = BETA_CURR;
+    cold.coefs->m_gamma[0]->m_gam_val = exp(BETA_CURR);
+    cold.coefs->m_vals[0] = exp(BETA_CURR);
+    hot.coefs->m_vals[0] = 1.0;
+
+    hot.xi->m_vals[0] = 0.4;
+    hot.xi->m_vals[1] = 2.1;
+    hot.xi->calc_sums();
+    cold.xi->calc_sums();
+
+    *cold.phi->m_vals = 1.7;
+    *hot.phi->m_vals = 2.5;
+
+    cold.lik->calc_stats(*cold.ubeta, X);
+    hot.lik->calc_stats(*hot.ubeta, X);
+}
+
+
+
+
+void TemperLadderTest::set_seed(int seed_val) {
+
+    // register seed function
+    Rcpp::Environment base("package:base");
+    Rcpp::Function set_seed = base["set.seed"];
+
+    // set R's internal seed
+    set_seed(seed_val);
+}
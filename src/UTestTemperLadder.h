@@ -0,0 +1,69 @@
+#ifndef DSP_BAYES_UTEST_TEMPER_LADDER_H
+#define DSP_BAYES_UTEST_TEMPER_LADDER_H
+
+
+#include "cppunit/extensions/HelperMacros.h"
+#include "Rcpp.h"
+
+#include "CoefGen.h"
+#include "FwDays.h"
+#include "PhiGen.h"
+#include "TemperLadder.h"
+#include "ULevels.h"
+#include "UTestGammaContMH.h"
+#include "WGen.h"
+
+
+
+
+class TemperLadderTest : public CppUnit::TestFixture {
+
+public:
+
+    // constructor
+    TemperLadderTest();
+
+    // setUp, tearDown
+    void setUp();
+    void tearDown();
+
+    // test methods
+    void test_constructor();
+    void test_swap_chains();
+    void test_sample_swaps();
+
+    // utility functions
+    void set_states();
+    void set_seed(int seed_val);
+
+    CPPUNIT_TEST_SUITE(TemperLadderTest);
+    CPPUNIT_TEST(test_constructor);
+    CPPUNIT_TEST(test_swap_chains);
+    CPPUNIT_TEST(test_sample_swaps);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    Rcpp::NumericMatrix U;
+    Rcpp::List gamma_specs;
+    Rcpp::NumericVector phi_specs;
+    Rcpp::NumericVector pt_specs;
+    TemperLadder* ladder;
+    WGen* W;
+    CoefGen* coefs;
+    PhiGen* phi;
+    ULevels* levels;
+    FwDays* fw;
+    GammaContMHTest::FromScratchDays* days_obj;
+    GammaContMHTest::FromScratchXi* xi_obj;
+    GammaContMHTest::FromScratchUbeta* ubeta_obj;
+    const int* X;
+    double u_cyc[4];
+    double u_subj[2];
+    int d2c[9];
+    int fw_pos[9];
+    bool old_burn_status;
+};
+
+
+#endif
@@ -66,8 +66,8 @@ void UGenVarCategTest::setUp() {
     u_var = g_ut_factory.u_categ(u_rcpp_copy);
 
     // so changes to underlying data in `utau` aren't persistent
-    utau_vals_copy = new double[utau->m_vals_rcpp.size()];
-    std::copy(utau->m_vals_rcpp.begin(), utau->m_vals_rcpp.end(), utau_vals_copy);
+    utau_vals_copy = new double[utau->n_days()];
+    std::copy(utau->m_vals, utau->m_vals + utau->n_days(), utau_vals_copy);
     utau->m_vals = utau_vals_copy;
 }
 
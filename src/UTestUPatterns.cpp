@@ -0,0 +1,129 @@
+#include <cmath>
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "UPatterns.h"
+#include "UProdBeta.h"
+#include "UTestUPatterns.h"
+
+#define EPSILON 0.000000000001
+
+
+
+
+void UPatternsTest::setUp() {
+
+    // two 0/1 columns for 9 days, giving the patterns {0}, {}, {0, 1}, {1}
+    const double U0[9] = { 1.0, 0.0, 1.0, 1.0, 0.0, 0.0, 1.0, 0.0, 1.0 };
+    const double U1[9] = { 0.0, 0.0, 1.0, 0.0, 1.0, 1.0, 1.0, 0.0, 0.0 };
+    for (int r = 0; r < 9; ++r) {
+	U[r] = U0[r];
+	U[9 + r] = U1[r];
+    }
+
+    cols.clear();
+    cols.push_back(UCol(U));
+    cols.push_back(UCol(U + 9));
+}
+
+
+
+
+void UPatternsTest::tearDown() {
+    cols.clear();
+}
+
+
+
+
+void UPatternsTest::test_constructor() {
+
+    // exercise SUT
+    UPatterns patterns(cols, 9);
+
+    // verify outcome.  The patterns are numbered in the order that they first
+    // occur.
+    CPPUNIT_ASSERT_EQUAL(4, patterns.m_n_pat);
+    const int target_day_pat[9] = { 0, 1, 2, 0, 3, 3, 2, 1, 0 };
+    for (int r = 0; r < 9; ++r) {
+	CPPUNIT_ASSERT_EQUAL(target_day_pat[r], patterns.m_day_pat[r]);
+    }
+    CPPUNIT_ASSERT_EQUAL((size_t) 2, patterns.m_col_pats[0].size());
+    CPPUNIT_ASSERT_EQUAL((size_t) 2, patterns.m_col_pats[1].size());
+    CPPUNIT_ASSERT(UPatterns::is_binary(cols, 9));
+}
+
+
+
+
+// `U * beta` after applying changes in the coefficients by way of the patterns
+// is the same as after applying the changes one column at a time
+
+void UPatternsTest::test_apply() {
+
+    // fixture setup
+    UPatterns patterns(cols, 9);
+    UProdBeta ubeta_pat(9);
+    UProdBeta ubeta_col(9);
+    init_ubeta(ubeta_pat);
+    init_ubeta(ubeta_col);
+
+    // exercise SUT
+    patterns.update(0, 0.4, exp(0.4));
+    patterns.update(1, -0.7, exp(-0.7));
+    patterns.apply(ubeta_pat);
+    ubeta_col.update(cols[0], 0.4, 0.0);
+    ubeta_col.update(cols[1], -0.7, 0.0);
+
+    // verify outcome
+    for (int r = 0; r < 9; ++r) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(ubeta_col.m_vals[r], ubeta_pat.m_vals[r], EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(ubeta_col.m_exp_vals[r], ubeta_pat.m_exp_vals[r], EPSILON);
+    }
+}
+
+
+
+
+// only the changes since the last call to `apply` are applied
+
+void UPatternsTest::test_apply_repeated() {
+
+    // fixture setup
+    UPatterns patterns(cols, 9);
+    UProdBeta ubeta_pat(9);
+    UProdBeta ubeta_col(9);
+    init_ubeta(ubeta_pat);
+    init_ubeta(ubeta_col);
+
+    // exercise SUT
+    patterns.update(0, 0.4, exp(0.4));
+    patterns.apply(ubeta_pat);
+    patterns.update(0, -0.1, exp(-0.1));
+    patterns.update(1, 1.2, exp(1.2));
+    patterns.apply(ubeta_pat);
+    patterns.apply(ubeta_pat);
+    ubeta_col.update(cols[0], 0.4, 0.0);
+    ubeta_col.update(cols[0], 0.3, 0.4);
+    ubeta_col.update(cols[1], 1.2, 0.0);
+
+    // verify outcome
+    for (int r = 0; r < 9; ++r) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(ubeta_col.m_vals[r], ubeta_pat.m_vals[r], EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(ubeta_col.m_exp_vals[r], ubeta_pat.m_exp_vals[r], EPSILON);
+    }
+}
+
+
+
+
+// utility functions -----------------------------------------------------------
+
+// the terms of `U * beta` for the columns that aren't day-level columns
+
+void UPatternsTest::init_ubeta(UProdBeta& ubeta) {
+    const double vals[9] = { 0.0, -0.1, 0.6, 0.2, 1.0, -0.3, 0.2, 0.5, 0.3 };
+    for (int r = 0; r < 9; ++r) {
+	ubeta.m_vals[r] = vals[r];
+	ubeta.m_exp_vals[r] = exp(vals[r]);
+    }
+}
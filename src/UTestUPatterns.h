@@ -0,0 +1,43 @@
+#ifndef DSP_BAYES_UTEST_U_PATTERNS_H
+#define DSP_BAYES_UTEST_U_PATTERNS_H
+
+
+#include <vector>
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "UCol.h"
+#include "UProdBeta.h"
+
+
+
+
+class UPatternsTest : public CppUnit::TestFixture {
+
+public:
+
+    // setUp, tearDown
+    void setUp();
+    void tearDown();
+
+    // test methods
+    void test_constructor();
+    void test_apply();
+    void test_apply_repeated();
+
+    // utility functions
+    void init_ubeta(UProdBeta& ubeta);
+
+    CPPUNIT_TEST_SUITE(UPatternsTest);
+    CPPUNIT_TEST(test_constructor);
+    CPPUNIT_TEST(test_apply);
+    CPPUNIT_TEST(test_apply_repeated);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    double U[18];
+    std::vector<UCol> cols;
+};
+
+
+#endif
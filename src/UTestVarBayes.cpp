@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cmath>
+#include "Rcpp.h"
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "CoefGen.h"
+#include "PhiGen.h"
+#include "UProdBeta.h"
+#include "UTestVarBayes.h"
+#include "VarBayes.h"
+#include "WGen.h"
+
+#define EPSILON 0.000000000001
+
+// the largest number of coordinate ascent iterations and the tolerance
+#define MAX_ITER  1000
+#define VB_TOL    0.00000001
+
+
+
+
+// the data for the days is that of the `CycLikTest` fixture, with two
+// day-level 0/1 columns.  The coefficients are either sampled by the
+// categorical sampler or by a Metropolis-Hastings step, for which the
+// approximation is the same.
+
+VarBayesTest::VarBayesTest() :
+    U(Rcpp::NumericMatrix(9, 2)),
+    X(GammaContMHTest::FromScratchDays::x_vals)
+{
+    const double u_vals[18] = { 1.0, 0.0, 1.0, 0.0, 1.0, 1.0, 0.0, 1.0, 0.0,
+				0.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 1.0 };
+    std::copy(u_vals, u_vals + 18, U.begin());
+
+    categ_specs = Rcpp::List(2);
+    mh_specs = Rcpp::List(2);
+    for (int h = 0; h < 2; ++h) {
+	categ_specs[h] = Rcpp::NumericVector::create(Rcpp::_["type"]  = 0.0,
+						     Rcpp::_["h"]     = (double) h,
+						     Rcpp::_["hyp_a"] = 1.0,
+						     Rcpp::_["hyp_b"] = 1.0,
+						     Rcpp::_["hyp_p"] = 0.5,
+						     Rcpp::_["bnd_l"] = 0.0,
+						     Rcpp::_["bnd_u"] = R_PosInf);
+	mh_specs[h] = Rcpp::NumericVector::create(Rcpp::_["type"]     = 1.0,
+						  Rcpp::_["h"]        = (double) h,
+						  Rcpp::_["hyp_a"]    = 1.0,
+						  Rcpp::_["hyp_b"]    = 1.0,
+						  Rcpp::_["hyp_p"]    = 0.5,
+						  Rcpp::_["bnd_l"]    = 0.0,
+						  Rcpp::_["bnd_u"]    = R_PosInf,
+						  Rcpp::_["mh_p"]     = 0.1,
+						  Rcpp::_["mh_delta"] = 0.2);
+    }
+
+    phi_specs = Rcpp::NumericVector::create(Rcpp::_["c1"]    = 1.0,
+					    Rcpp::_["c2"]    = 1.0,
+					    Rcpp::_["delta"] = 0.1,
+					    Rcpp::_["mean"]  = 1.0);
+    vb_specs = Rcpp::NumericVector::create(Rcpp::_["max_iter"] = MAX_ITER,
+					   Rcpp::_["tol"]      = VB_TOL,
+					   Rcpp::_["init"]     = 0.0);
+}
+
+
+
+
+void VarBayesTest::setUp() {
+    create_objs(categ_specs);
+}
+
+
+
+
+void VarBayesTest::tearDown() {
+    delete_objs();
+}
+
+
+
+
+// the coordinate ascent converges, after which the values of the coefficients
+// are `E[gamma_h]` and `ubeta` contains the corresponding values of `U *
+// beta`
+
+void VarBayesTest::test_fit() {
+
+    // exercise SUT
+    vb->fit();
+
+    // verify outcome
+    CPPUNIT_ASSERT(vb->m_is_converged);
+    CPPUNIT_ASSERT(vb->m_n_iter <= MAX_ITER);
+    for (int h = 0; h < 2; ++h) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(vb->m_gamma[h]->m_gam_val,  coefs->m_gamma[h]->m_gam_val,  EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(vb->m_gamma[h]->m_beta_val, coefs->m_gamma[h]->m_beta_val, EPSILON);
+	CPPUNIT_ASSERT(vb->m_gamma[h]->m_gam_val > 0.0);
+    }
+    for (int r = 0; r < 9; ++r) {
+	const double ubeta_val = (U(r, 0) * coefs->m_gamma[0]->m_beta_val) + (U(r, 1) * coefs->m_gamma[1]->m_beta_val);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(ubeta_val,      ubeta->vals()[r],     0.000001);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(exp(ubeta_val), ubeta->exp_vals()[r], 0.000001);
+    }
+}
+
+
+
+
+// the inclusion probabilities are in [0, 1] and the parameters of `q(gamma_h)`
+// and `q(xi_i)` are positive
+
+void VarBayesTest::test_fit_params() {
+
+    // exercise SUT
+    vb->fit();
+    Rcpp::List params = vb->params();
+
+    // verify outcome
+    Rcpp::NumericVector incl_probs = params["incl_probs"];
+    CPPUNIT_ASSERT_EQUAL(2, (int) incl_probs.size());
+    for (int h = 0; h < 2; ++h) {
+	CPPUNIT_ASSERT(incl_probs[h] >= 0.0);
+	CPPUNIT_ASSERT(incl_probs[h] <= 1.0);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(vb->m_p_tilde[h], incl_probs[h], EPSILON);
+	CPPUNIT_ASSERT(vb->m_a_tilde[h] > 0.0);
+	CPPUNIT_ASSERT(vb->m_b_tilde[h] > 0.0);
+    }
+    for (int i = 0; i < 2; ++i) {
+	CPPUNIT_ASSERT(vb->m_xi_shape[i] > 0.0);
+	CPPUNIT_ASSERT(vb->m_xi_rate[i] > 0.0);
+    }
+    CPPUNIT_ASSERT(((bool) params["converged"]));
+    CPPUNIT_ASSERT(((double) params["phi_mode"]) > 0.0);
+}
+
+
+
+
+// the approximation doesn't depend on the sampler that is used for the
+// coefficients
+
+void VarBayesTest::test_fit_mh() {
+
+    // fixture setup
+    vb->fit();
+    const std::vector<double> categ_a_tilde = vb->m_a_tilde;
+    const std::vector<double> categ_b_tilde = vb->m_b_tilde;
+    const std::vector<double> categ_p_tilde = vb->m_p_tilde;
+    const double categ_phi = phi->val();
+    delete_objs();
+    create_objs(mh_specs);
+
+    // exercise SUT
+    vb->fit();
+
+    // verify outcome
+    CPPUNIT_ASSERT(vb->m_is_converged);
+    for (int h = 0; h < 2; ++h) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(categ_a_tilde[h], vb->m_a_tilde[h], EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(categ_b_tilde[h], vb->m_b_tilde[h], EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(categ_p_tilde[h], vb->m_p_tilde[h], EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(vb->m_gamma[h]->m_gam_val, coefs->m_gamma[h]->m_gam_val, EPSILON);
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(categ_phi, phi->val(), EPSILON);
+}
+
+
+
+
+// the sampler objects start out with each coefficient having a value of 1, so
+// that the values of `U * beta` are 0
+
+void VarBayesTest::create_objs(Rcpp::List& gamma_specs) {
+
+    days_obj = new GammaContMHTest::FromScratchDays();
+    W        = GammaContMHTest::FromScratchDays::new_w();
+    xi_obj = new GammaContMHTest::FromScratchXi();
+    ubeta  = new UProdBeta(9);
+    coefs  = new CoefGen(U.begin(), 9, gamma_specs, 10, NULL, NULL, NULL, true);
+    phi    = new PhiGen(phi_specs, 10, false);
+    vb     = new VarBayes(vb_specs, *W, xi_obj->xi(), *coefs, *phi, *ubeta, X, U.begin(), 9, gamma_specs);
+}
+
+
+
+
+void VarBayesTest::delete_objs() {
+    delete vb;
+    delete coefs;
+    delete phi;
+    delete ubeta;
+    delete xi_obj;
+    delete W;
+    delete days_obj;
+}
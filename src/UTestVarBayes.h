@@ -0,0 +1,62 @@
+#ifndef DSP_BAYES_UTEST_VAR_BAYES_H
+#define DSP_BAYES_UTEST_VAR_BAYES_H
+
+
+#include "cppunit/extensions/HelperMacros.h"
+#include "Rcpp.h"
+
+#include "CoefGen.h"
+#include "PhiGen.h"
+#include "UProdBeta.h"
+#include "UTestGammaContMH.h"
+#include "VarBayes.h"
+#include "WGen.h"
+
+
+
+
+class VarBayesTest : public CppUnit::TestFixture {
+
+public:
+
+    // constructor
+    VarBayesTest();
+
+    // setUp, tearDown
+    void setUp();
+    void tearDown();
+
+    // test methods
+    void test_fit();
+    void test_fit_params();
+    void test_fit_mh();
+
+    // utility functions
+    void create_objs(Rcpp::List& gamma_specs);
+    void delete_objs();
+
+    CPPUNIT_TEST_SUITE(VarBayesTest);
+    CPPUNIT_TEST(test_fit);
+    CPPUNIT_TEST(test_fit_params);
+    CPPUNIT_TEST(test_fit_mh);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    Rcpp::NumericMatrix U;
+    Rcpp::List categ_specs;
+    Rcpp::List mh_specs;
+    Rcpp::NumericVector phi_specs;
+    Rcpp::NumericVector vb_specs;
+    VarBayes* vb;
+    WGen* W;
+    CoefGen* coefs;
+    PhiGen* phi;
+    UProdBeta* ubeta;
+    GammaContMHTest::FromScratchDays* days_obj;
+    GammaContMHTest::FromScratchXi* xi_obj;
+    const int* X;
+};
+
+
+#endif
@@ -76,8 +76,9 @@ void XGenTest::test_constructor() {
     PregCyc* miss_cyc = PregCyc::list_to_arr(miss_cyc_rcpp);
     XGen::XMissDay* miss_day = XGen::XMissDay::list_to_arr(miss_day_rcpp);
 
-    CPPUNIT_ASSERT(Rcpp::is_true(Rcpp::all(x_rcpp == X->m_x_rcpp)));
-    CPPUNIT_ASSERT_EQUAL(X->m_vals, X->m_x_rcpp.begin());
+    CPPUNIT_ASSERT(std::equal(x_rcpp.begin(), x_rcpp.end(), X->m_vals));
+    CPPUNIT_ASSERT_EQUAL(X->m_vals, x_rcpp_copy->begin());
+    CPPUNIT_ASSERT_EQUAL((int) x_rcpp.size(), X->m_n_days);
     // TODO: test m_miss_cyc
     CPPUNIT_ASSERT_EQUAL((int) miss_cyc_rcpp.size(), X->m_n_miss_cyc);
     // TODO: test m_miss_day
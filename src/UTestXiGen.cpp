@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <cmath>
+#include <vector>
 #include "Rcpp.h"
 #include "XiGen.h"
 #include "WGen.h"
@@ -10,6 +12,7 @@
 using Rcpp::as;
 
 extern UTestFactory g_ut_factory;
+extern bool g_burn_status;
 
 
 
@@ -124,3 +127,48 @@ void XiGenTest::test_sample_no_record() {
 			      xi_no_rec->m_vals,
 			      UTestFactory::eq_dbl));
 }
+
+
+
+
+// the Rao-Blackwellized estimates are the averages over the scans after the
+// burn-in phase of the full conditional means `(phi + W_i) / (phi + S_i)`,
+// where `W_i` is `sum_jk W_ijk` and `S_i` is `sum_jk X_ijk * exp(u_ijk^T
+// beta)`.  The value of phi is changed between the scans so that the means
+// differ.
+
+void XiGenTest::test_rb_means() {
+
+    // fixture setup
+    const bool old_burn_status = g_burn_status;
+    const double phi_vals[3] = { 0.5, 1.0, 2.0 };
+    Rcpp::Environment base("package:base");
+    Rcpp::Function set_seed = base["set.seed"];
+    set_seed(seed_val);
+
+    // exercise SUT.  The scans during the burn-in phase aren't included.
+    g_burn_status = true;
+    xi_no_rec->sample(*W, *phi, *ubeta, *X);
+    CPPUNIT_ASSERT_EQUAL(0, xi_no_rec->m_rb_n);
+    CPPUNIT_ASSERT(std::isnan(xi_no_rec->rb_means()[0]));
+
+    g_burn_status = false;
+    std::vector<double> target_means(n_subj, 0.0);
+    for (int s = 0; s < 3; ++s) {
+	*phi->m_vals = phi_vals[s];
+	xi_no_rec->sample(*W, *phi, *ubeta, *X);
+	for (int i = 0; i < n_subj; ++i) {
+	    target_means[i] += ((phi_vals[s] + xi_no_rec->w_sums()[i])
+				/ (phi_vals[s] + xi_no_rec->exp_sums()[i])) / 3;
+	}
+    }
+
+    g_burn_status = old_burn_status;
+
+    // verify outcome
+    Rcpp::NumericVector rb_means = xi_no_rec->rb_means();
+    CPPUNIT_ASSERT_EQUAL(3, xi_no_rec->m_rb_n);
+    for (int i = 0; i < n_subj; ++i) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(target_means[i], rb_means[i], UTestFactory::epsilon);
+    }
+}
@@ -21,11 +21,13 @@ public:
     void test_constructor();
     void test_sample_yes_record();
     void test_sample_no_record();
+    void test_rb_means();
 
     CPPUNIT_TEST_SUITE(XiGenTest);
     CPPUNIT_TEST(test_constructor);
     CPPUNIT_TEST(test_sample_yes_record);
     CPPUNIT_TEST(test_sample_no_record);
+    CPPUNIT_TEST(test_rb_means);
     CPPUNIT_TEST_SUITE_END();
 
 
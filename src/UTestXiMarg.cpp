@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cmath>
+#include "Rcpp.h"
+#include "cppunit/extensions/HelperMacros.h"
+
+#include "GammaGen.h"
+#include "UTestXiMarg.h"
+#include "XiMarg.h"
+
+#define EPSILON 0.000000000001
+
+// the current value of the coefficient and the value of phi
+#define BETA_CURR  0.5
+#define PHI_VAL    1.7
+
+extern int* d2s;
+
+
+
+
+// the data for the days is that of the `GammaContMHTest` fixture, with several
+// of the days not having intercourse.  The values of `U * beta` in the fixture
+// are taken to include the term for the current value of the coefficient.
+
+XiMargTest::XiMargTest() :
+    U(Rcpp::NumericMatrix(9, 1)),
+    X(GammaContMHTest::FromScratchDays::x_vals),
+    w_day_vals(GammaContMHTest::FromScratchDays::w_day_vals),
+    ubeta_init(GammaContMHTest::FromScratchDays::ubeta_vals)
+{
+    std::copy(GammaContMHTest::FromScratchDays::u_vals,
+	      GammaContMHTest::FromScratchDays::u_vals + 9,
+	      U.begin());
+}
+
+
+
+
+void XiMargTest::setUp() {
+
+    Rcpp::NumericVector gamma_specs = Rcpp::NumericVector::create(Rcpp::_["h"]        = 0.0,
+								  Rcpp::_["hyp_a"]    = 1.2,
+								  Rcpp::_["hyp_b"]    = 0.9,
+								  Rcpp::_["hyp_p"]    = 0.5,
+								  Rcpp::_["bnd_l"]    = 0.0,
+								  Rcpp::_["bnd_u"]    = R_PosInf,
+								  Rcpp::_["mh_p"]     = 0.1,
+								  Rcpp::_["mh_delta"] = 0.2);
+    gamma = new GammaContMH(U, gamma_specs);
+    gamma->m_beta_val = BETA_CURR;
+    gamma->m_gam_val = exp(BETA_CURR);
+
+    w_obj     = new GammaContMHTest::FromScratchW();
+    xi_obj    = new GammaContMHTest::FromScratchXi();
+    ubeta_obj = new GammaContMHTest::FromScratchUbeta();
+    marg      = new XiMarg(xi_obj->xi());
+    days_obj  = new GammaContMHTest::FromScratchDays();
+}
+
+
+
+
+void XiMargTest::tearDown() {
+    delete marg;
+    delete gamma;
+    delete w_obj;
+    delete xi_obj;
+    delete ubeta_obj;
+    delete days_obj;
+}
+
+
+
+
+// the statistics are `sum_jk W_ijk` and `sum_jk X_ijk * exp(u_ijk^T beta)` for
+// each subject
+
+void XiMargTest::test_calc_stats() {
+
+    // exercise SUT
+    marg->calc_stats(w_obj->W(), ubeta_obj->ubeta(), X);
+
+    // verify outcome
+    double w_sums[2], exp_sums[2];
+    calc_sums(BETA_CURR, w_sums, exp_sums);
+    CPPUNIT_ASSERT_EQUAL(2, marg->n_subj());
+    for (int i = 0; i < 2; ++i) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(w_sums[i],   marg->m_w_sums[i],   EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(exp_sums[i], marg->m_exp_sums[i], EPSILON);
+    }
+}
+
+
+
+
+// the return value is the log-likelihood ratio of the proposal value with xi
+// integrated out
+
+void XiMargTest::test_get_marg_log_lik() {
+
+    // fixture setup
+    marg->calc_stats(w_obj->W(), ubeta_obj->ubeta(), X);
+
+    // exercise SUT
+    double out = gamma->get_marg_log_lik(w_obj->W(), *marg, PHI_VAL, ubeta_obj->ubeta(), X, 0.8);
+
+    // verify outcome
+    const double target = marg_log_lik(0.8, PHI_VAL) - marg_log_lik(BETA_CURR, PHI_VAL);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target, out, EPSILON);
+}
+
+
+
+
+// after committing the proposal the statistics are those for the proposal
+// value, as would be calculated by `calc_stats`
+
+void XiMargTest::test_commit() {
+
+    // fixture setup
+    UProdBeta& ubeta = ubeta_obj->ubeta();
+    marg->calc_stats(w_obj->W(), ubeta, X);
+
+    // exercise SUT
+    gamma->get_marg_log_lik(w_obj->W(), *marg, PHI_VAL, ubeta, X, -0.4);
+    ubeta.commit_prop(gamma->m_Uh, -0.4 - BETA_CURR);
+    marg->commit();
+
+    // verify outcome
+    double w_sums[2], exp_sums[2];
+    calc_sums(-0.4, w_sums, exp_sums);
+    for (int i = 0; i < 2; ++i) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(w_sums[i],   marg->m_w_sums[i],   EPSILON);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(exp_sums[i], marg->m_exp_sums[i], EPSILON);
+    }
+}
+
+
+
+
+// the log-likelihood as a function of phi, as a sum over the subjects
+
+void XiMargTest::test_log_lik_phi() {
+
+    // fixture setup
+    marg->calc_stats(w_obj->W(), ubeta_obj->ubeta(), X);
+
+    // exercise SUT
+    double out_1 = marg->log_lik_phi(PHI_VAL);
+    double out_2 = marg->log_lik_phi(0.6);
+
+    // verify outcome.  The terms of `marg_log_lik` that don't depend on phi
+    // are the same for each value of phi.
+    const double target = marg_log_lik(BETA_CURR, PHI_VAL) - marg_log_lik(BETA_CURR, 0.6);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(target, out_1 - out_2, EPSILON);
+}
+
+
+
+
+// utility functions -----------------------------------------------------------
+
+// calculate `sum_jk W_ijk` and `sum_jk X_ijk * exp(u_ijk^T beta)` for each
+// subject by brute force, where `beta` is the value of the coefficient
+
+void XiMargTest::calc_sums(double beta, double* w_sums, double* exp_sums) {
+
+    for (int i = 0; i < 2; ++i) {
+	w_sums[i] = 0.0;
+	exp_sums[i] = 0.0;
+    }
+    for (int r = 0; r < 9; ++r) {
+	const int i = d2s[r];
+	w_sums[i] += w_day_vals[r];
+	exp_sums[i] += X[r] * exp(ubeta_init[r] + (U[r] * (beta - BETA_CURR)));
+    }
+}
+
+
+
+
+// the log-likelihood of `W` with xi integrated out, up to a constant, where
+// `beta` is the value of the coefficient (see XiMarg.h)
+
+double XiMargTest::marg_log_lik(double beta, double phi) {
+
+    double w_sums[2], exp_sums[2];
+    calc_sums(beta, w_sums, exp_sums);
+
+    double sum_val = 0.0;
+    for (int r = 0; r < 9; ++r) {
+	sum_val += w_day_vals[r] * U[r] * beta;
+    }
+    for (int i = 0; i < 2; ++i) {
+	sum_val += ((phi * log(phi)) - R::lgammafn(phi) + R::lgammafn(phi + w_sums[i])
+		    - ((phi + w_sums[i]) * log(phi + exp_sums[i])));
+    }
+
+    return sum_val;
+}
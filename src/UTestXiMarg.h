@@ -0,0 +1,58 @@
+#ifndef DSP_BAYES_UTEST_XI_MARG_H
+#define DSP_BAYES_UTEST_XI_MARG_H
+
+
+#include "cppunit/extensions/HelperMacros.h"
+#include "Rcpp.h"
+
+#include "GammaGen.h"
+#include "UTestGammaContMH.h"
+#include "XiMarg.h"
+
+
+
+
+class XiMargTest : public CppUnit::TestFixture {
+
+public:
+
+    // constructor
+    XiMargTest();
+
+    // setUp, tearDown
+    void setUp();
+    void tearDown();
+
+    // test methods
+    void test_calc_stats();
+    void test_get_marg_log_lik();
+    void test_commit();
+    void test_log_lik_phi();
+
+    // utility functions
+    void calc_sums(double beta, double* w_sums, double* exp_sums);
+    double marg_log_lik(double beta, double phi);
+
+    CPPUNIT_TEST_SUITE(XiMargTest);
+    CPPUNIT_TEST(test_calc_stats);
+    CPPUNIT_TEST(test_get_marg_log_lik);
+    CPPUNIT_TEST(test_commit);
+    CPPUNIT_TEST(test_log_lik_phi);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    Rcpp::NumericMatrix U;
+    GammaContMH* gamma;
+    XiMarg* marg;
+    GammaContMHTest::FromScratchDays* days_obj;
+    GammaContMHTest::FromScratchW* w_obj;
+    GammaContMHTest::FromScratchXi* xi_obj;
+    GammaContMHTest::FromScratchUbeta* ubeta_obj;
+    const int* X;
+    const int* w_day_vals;
+    const double* ubeta_init;
+};
+
+
+#endif
@@ -0,0 +1,417 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Rcpp.h"
+#include "CoefGen.h"
+#include "DayBlock.h"
+#include "DayChunks.h"
+#include "GammaGen.h"
+#include "IdxType.h"
+#include "PhiGen.h"
+#include "UCol.h"
+#include "UPatterns.h"
+#include "UProdBeta.h"
+#include "VarBayes.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+
+
+
+// `vb_specs` provides the largest number of iterations `max_iter` and the
+// tolerance `tol` for the coordinate ascent.  `U` and `gamma_specs` are the
+// data and specifications that `coefs` was constructed from, which are used
+// to construct the objects for `q(gamma_h)`.  The approximation requires that
+// each of the columns is a day-level 0/1 column that isn't a fertile window day
+// effect, but the coefficients may be sampled by any of the samplers.
+
+VarBayes::VarBayes(const Rcpp::NumericVector& vb_specs,
+		   const WGen& W,
+		   XiGen& xi,
+		   CoefGen& coefs,
+		   PhiGen& phi,
+		   UProdBeta& ubeta,
+		   const int* X,
+		   const double* U,
+		   dsp_idx_t n_days,
+		   const Rcpp::List& gamma_specs) :
+    // initialization list
+    m_W(W),
+    m_xi(xi),
+    m_coefs(coefs),
+    m_phi(phi),
+    m_ubeta(ubeta),
+    m_X(X),
+    m_max_iter(vb_specs["max_iter"]),
+    m_tol(vb_specs["tol"]),
+    m_n_iter(0),
+    m_is_converged(false),
+    m_w_means(W.m_n_preg_days, 0.0),
+    m_w_sums(xi.m_n_subj, 0.0),
+    m_xi_elog(xi.m_n_subj, 0.0),
+    m_xi_shape(xi.m_n_subj, 0.0),
+    m_xi_rate(xi.m_n_subj, 0.0),
+    m_a_tilde(coefs.m_n_gamma, 0.0),
+    m_b_tilde(coefs.m_n_gamma, 0.0),
+    m_p_tilde(coefs.m_n_gamma, 0.0),
+    m_gam_elog(coefs.m_n_gamma, 0.0),
+    m_phi_sd(0.0) {
+
+    if ((! coefs.m_level_idx[U_LEVEL_CYC].empty())
+	|| (! coefs.m_level_idx[U_LEVEL_SUBJ].empty())
+	|| (! coefs.m_fw_idx.empty())) {
+	Rcpp::stop("the variational approximation requires all of the columns to be day-level columns");
+    }
+
+    std::vector<UCol> cols;
+    for (int h = 0; h < coefs.m_n_gamma; ++h) {
+	cols.push_back(coefs.m_gamma[h]->m_Uh);
+    }
+    if (! UPatterns::is_binary(cols, n_days)) {
+	Rcpp::stop("the variational approximation requires all of the columns to only have values of 0 or 1");
+    }
+
+    // the objects for `q(gamma_h)` start out at the current values of the
+    // coefficients, and share the covariate patterns if they are in use and
+    // the parents of the interaction columns
+    for (int h = 0; h < coefs.m_n_gamma; ++h) {
+	const GammaGen* curr_coef = coefs.m_gamma[h];
+	const Rcpp::NumericVector curr_specs = gamma_specs[h];
+	GammaCateg* curr_gamma = new GammaCateg(U,
+						n_days,
+						curr_specs,
+						coefs.m_levels,
+						coefs.m_fw,
+						&coefs.m_parent_cache);
+	curr_gamma->m_beta_val = curr_coef->m_beta_val;
+	curr_gamma->m_gam_val = curr_coef->m_gam_val;
+	curr_gamma->set_patterns(curr_coef->m_patterns, curr_coef->m_pat_col);
+	m_gamma.push_back(curr_gamma);
+    }
+}
+
+
+
+
+VarBayes::~VarBayes() {
+    for (size_t h = 0; h < m_gamma.size(); ++h) {
+	delete m_gamma[h];
+    }
+}
+
+
+
+
+// fit the approximation by coordinate ascent, starting from the current values
+// of the sampler objects
+
+void VarBayes::fit() {
+
+    const double* xi_vals = m_xi.vals();
+    for (int i = 0; i < m_xi.n_subj(); ++i) {
+	m_xi_elog[i] = log(xi_vals[i]);
+    }
+    for (size_t h = 0; h < m_gamma.size(); ++h) {
+	m_gam_elog[h] = m_gamma[h]->m_beta_val;
+    }
+
+    for (m_n_iter = 0; m_n_iter < m_max_iter; ) {
+
+	update_w();
+	update_xi();
+	const double gam_change = update_gamma();
+	const double phi_change = update_phi();
+	++m_n_iter;
+
+	if (std::fmax(gam_change, phi_change) < m_tol) {
+	    m_is_converged = true;
+	    break;
+	}
+
+	Rcpp::checkUserInterrupt();
+    }
+
+    // remove the rounding error accumulated by the updates of `ubeta`
+    m_ubeta.update_exp();
+}
+
+
+
+
+// update `q(W)`.  The days in each pregnancy cycle are consecutive, and their
+// values of `E[W]` are stored in the same order as the values of `W` are by
+// `WGen`.
+
+void VarBayes::update_w() {
+
+    const PregCyc* preg_cyc = m_W.m_preg_cyc;
+    const int n_gamma = m_gamma.size();
+    double* w_means = m_w_means.data();
+
+    std::fill(m_w_sums.begin(), m_w_sums.end(), 0.0);
+
+    for (int q = 0; q < m_W.m_n_preg_cyc; ++q) {
+
+	const dsp_idx_t beg_idx = preg_cyc[q].beg_idx;
+	const int n_days = preg_cyc[q].n_days;
+	const int i = preg_cyc[q].subj_idx;
+
+	// the terms `X_ijk * exp(E[u_ijk^T beta])` for the days in the cycle,
+	// and their sum
+	double sum_val = 0.0;
+	for (int v = 0; v < n_days; ++v) {
+
+	    const dsp_idx_t r = beg_idx + v;
+	    double ub_elog = 0.0;
+	    for (int h = 0; h < n_gamma; ++h) {
+		if (m_gamma[h]->m_Uh[r]) {
+		    ub_elog += m_gam_elog[h];
+		}
+	    }
+
+	    w_means[v] = m_X[r] ? m_X[r] * exp(ub_elog) : 0.0;
+	    sum_val += w_means[v];
+	}
+
+	// a pregnancy cycle without intercourse in the fertile window has no
+	// contribution to the likelihood
+	if (sum_val == 0.0) {
+	    w_means += n_days;
+	    continue;
+	}
+
+	// the mean of the zero-truncated Poisson distribution for `sum_k W_ijk`
+	// split over the days
+	const double pois_mean = exp(m_xi_elog[i]) * sum_val;
+	const double w_sum = pois_mean / (-expm1(-pois_mean));
+	for (int v = 0; v < n_days; ++v) {
+	    w_means[v] *= w_sum / sum_val;
+	}
+
+	m_w_sums[i] += w_sum;
+	w_means += n_days;
+    }
+}
+
+
+
+
+// update `q(xi)`, and set the values of xi to `E[xi]`
+
+void VarBayes::update_xi() {
+
+    const double phi_val = m_phi.val();
+    const dsp_store_t* ubeta_exp_vals = m_ubeta.exp_vals();
+    const DayBlock* subj = m_xi.m_subj;
+    const int n_subj = m_xi.n_subj();
+    double* xi_vals = m_xi.m_vals;
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const int chunk_end = g_day_chunks.subj_end(c, n_subj);
+
+	for (int i = g_day_chunks.subj_beg(c); i < chunk_end; ++i) {
+
+	    double exp_sum = 0.0;
+	    const dsp_idx_t curr_end = subj[i].beg_idx + subj[i].n_days;
+	    for (dsp_idx_t r = subj[i].beg_idx; r < curr_end; ++r) {
+		if (m_X[r]) {
+		    exp_sum += m_X[r] * ubeta_exp_vals[r];
+		}
+	    }
+
+	    m_xi_shape[i] = phi_val + m_w_sums[i];
+	    m_xi_rate[i] = phi_val + exp_sum;
+	    m_xi_elog[i] = R::digamma(m_xi_shape[i]) - log(m_xi_rate[i]);
+	    xi_vals[i] = m_xi_shape[i] / m_xi_rate[i];
+	}
+    }
+
+    m_xi.calc_sums();
+}
+
+
+
+
+// update `q(gamma_h)` for each coefficient, and set the value of each gamma_h
+// to `E[gamma_h]`, both for the objects for `q(gamma_h)` and for the sampler
+// objects.  Returns the largest change in `log E[gamma_h]`.
+
+double VarBayes::update_gamma() {
+
+    const int* w_days_idx = m_W.days_idx();
+    const dsp_idx_t n_preg_days = m_W.n_preg_days();
+    double max_change = 0.0;
+
+    for (size_t h = 0; h < m_gamma.size(); ++h) {
+
+	GammaCateg* curr_gamma = m_gamma[h];
+
+	double a_tilde = curr_gamma->m_hyp_a;
+	for (dsp_idx_t t = 0; t < n_preg_days; ++t) {
+	    if (curr_gamma->m_Uh[ w_days_idx[t] ]) {
+		a_tilde += m_w_means[t];
+	    }
+	}
+
+	// note that `calc_b_tilde` removes the terms for gamma_h from `ubeta`,
+	// and they are added back in for the new value below
+	const double b_tilde = curr_gamma->calc_b_tilde(m_ubeta, m_xi, m_X);
+	const double p_tilde = curr_gamma->m_incl_one ? curr_gamma->calc_p_tilde(a_tilde, b_tilde) : 0.0;
+	const double gam_mean = curr_gamma->calc_cond_mean(a_tilde, b_tilde, p_tilde);
+
+	const double beta_diff = log(gam_mean) - curr_gamma->m_beta_val;
+	max_change = std::fmax(max_change, std::fabs(beta_diff));
+	curr_gamma->m_gam_val = gam_mean;
+	curr_gamma->m_beta_val = log(gam_mean);
+	m_ubeta.add_uh_prod_beta_h(curr_gamma->m_Uh, curr_gamma->m_beta_val, curr_gamma->m_gam_val);
+
+	// the value of the coefficient for the sampler is kept in step as well
+	m_coefs.m_gamma[h]->m_beta_val = curr_gamma->m_beta_val;
+	m_coefs.m_gamma[h]->m_gam_val = curr_gamma->m_gam_val;
+
+	// keep the terms for the covariate patterns in step with `ubeta`
+	if (curr_gamma->m_patterns) {
+	    curr_gamma->m_patterns->update(curr_gamma->m_pat_col, beta_diff, exp(beta_diff));
+	    curr_gamma->m_patterns->mark_applied();
+	}
+
+	m_a_tilde[h] = a_tilde;
+	m_b_tilde[h] = b_tilde;
+	m_p_tilde[h] = p_tilde;
+	m_gam_elog[h] = (1 - p_tilde) * (R::digamma(a_tilde) - log(b_tilde));
+    }
+
+    return max_change;
+}
+
+
+
+
+// update the point estimate of phi, which is the mode of
+//
+//     log q(phi) = (c1 - 1) * log(phi) - c2 * phi
+//                  + n * { phi * log(phi) - log Gamma(phi) }
+//                  + (phi - 1) * sum_i E[log xi_i] - phi * sum_i E[xi_i]
+//
+// found by Newton's method, and set the value of phi to the estimate.  Returns
+// the change in `log(phi)`.
+
+double VarBayes::update_phi() {
+
+    const double n_subj = m_xi.n_subj();
+    const double prev_val = m_phi.val();
+    const double c1 = m_phi.m_hyp_c1;
+    const double c2 = m_phi.m_hyp_c2;
+
+    // the values of xi are `E[xi_i]`, so that `sum_vals` is `sum_i E[xi_i]`
+    double stat = -m_xi.sum_vals();
+    for (int i = 0; i < m_xi.n_subj(); ++i) {
+	stat += m_xi_elog[i];
+    }
+
+    double phi_val = prev_val;
+    double d2 = -1.0;
+    for (int k = 0; k < VAR_BAYES_PHI_MAX_NEWTON; ++k) {
+
+	const double d1 = (((c1 - 1) / phi_val)
+			   - c2
+			   + (n_subj * (log(phi_val) + 1 - R::digamma(phi_val)))
+			   + stat);
+	d2 = (-(c1 - 1) / (phi_val * phi_val)) + (n_subj * ((1 / phi_val) - R::trigamma(phi_val)));
+	if (d2 >= 0.0) {
+	    break;
+	}
+
+	// halve the value rather than stepping outside of the support
+	double next_val = phi_val - (d1 / d2);
+	if (next_val <= 0.0) {
+	    next_val = phi_val / 2;
+	}
+
+	const bool is_done = std::fabs(next_val - phi_val) < (1e-10 * phi_val);
+	phi_val = next_val;
+	if (is_done) {
+	    break;
+	}
+    }
+
+    *m_phi.m_vals = phi_val;
+    m_phi.m_is_same_as_prev = false;
+    m_phi_sd = (d2 < 0.0) ? sqrt(-1 / d2) : 0.0;
+
+    return std::fabs(log(phi_val) - log(prev_val));
+}
+
+
+
+
+// the parameters of the approximation, including the probability that each
+// gamma_h is 1
+
+Rcpp::List VarBayes::params() const {
+    return Rcpp::List::create(Rcpp::Named("incl_probs") = m_p_tilde,
+			      Rcpp::Named("a_tilde")    = m_a_tilde,
+			      Rcpp::Named("b_tilde")    = m_b_tilde,
+			      Rcpp::Named("xi_shape")   = m_xi_shape,
+			      Rcpp::Named("xi_rate")    = m_xi_rate,
+			      Rcpp::Named("phi_mode")   = m_phi.val(),
+			      Rcpp::Named("phi_sd")     = m_phi_sd,
+			      Rcpp::Named("n_iter")     = m_n_iter,
+			      Rcpp::Named("converged")  = m_is_converged);
+}
+
+
+
+
+// the output in the same form as that of the sampler, with `n_samp` draws from
+// the approximation in place of the samples, and with the expectations in place
+// of the Rao-Blackwellized estimates
+
+Rcpp::List VarBayes::output(int n_samp) {
+
+    const int n_gamma = m_gamma.size();
+    const int n_subj = m_xi.n_subj();
+    const double phi_val = m_phi.val();
+
+    Rcpp::NumericVector coef_draws(Rcpp::no_init((dsp_idx_t) n_gamma * n_samp));
+    Rcpp::NumericVector xi_draws(Rcpp::no_init((dsp_idx_t) n_subj * n_samp));
+    Rcpp::NumericVector phi_draws = Rcpp::NumericVector(Rcpp::no_init(n_samp));
+
+    for (int s = 0; s < n_samp; ++s) {
+
+	for (int h = 0; h < n_gamma; ++h) {
+	    coef_draws[(dsp_idx_t) s * n_gamma + h] = m_gamma[h]->sample_gamma(m_a_tilde[h],
+									       m_b_tilde[h],
+									       m_p_tilde[h]);
+	}
+
+	for (int i = 0; i < n_subj; ++i) {
+	    xi_draws[(dsp_idx_t) s * n_subj + i] = R::rgamma(m_xi_shape[i], 1 / m_xi_rate[i]);
+	}
+
+	// the Laplace approximation truncated to the positive values
+	double phi_draw = phi_val;
+	if (m_phi_sd > 0.0) {
+	    do {
+		phi_draw = phi_val + (m_phi_sd * R::norm_rand());
+	    } while (phi_draw <= 0.0);
+	}
+	phi_draws[s] = phi_draw;
+    }
+
+    Rcpp::NumericVector coefs_mean(n_gamma);
+    for (int h = 0; h < n_gamma; ++h) {
+	coefs_mean[h] = m_gamma[h]->m_gam_val;
+    }
+    const double* xi_vals = m_xi.vals();
+    Rcpp::NumericVector xi_mean(xi_vals, xi_vals + n_subj);
+
+    return Rcpp::List::create(Rcpp::Named("coefs")    = coef_draws,
+			      Rcpp::Named("xi")       = xi_draws,
+			      Rcpp::Named("phi")      = phi_draws,
+			      Rcpp::Named("coefs_rb") = coefs_mean,
+			      Rcpp::Named("xi_rb")    = xi_mean,
+			      Rcpp::Named("vb")       = params());
+}
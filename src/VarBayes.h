@@ -0,0 +1,125 @@
+#ifndef DSP_BAYES_SRC_VAR_BAYES_H
+#define DSP_BAYES_SRC_VAR_BAYES_H
+
+#include <vector>
+#include "Rcpp.h"
+#include "CoefGen.h"
+#include "GammaGen.h"
+#include "IdxType.h"
+#include "PhiGen.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+#define VAR_BAYES_PHI_MAX_NEWTON 50
+
+
+// a mean-field variational approximation to the posterior distribution,
+//
+//     q(W) * q(xi) * prod_h q(gamma_h) * q(phi),
+//
+// which is fitted by coordinate ascent.  Each factor other than `q(phi)` has
+// the same form as the full conditional distribution that is sampled from by
+// the Gibbs sampler, with the values of the other parameters replaced by
+// expectations:
+//
+//   q(W_ij):  for a pregnancy cycle, `sum_k W_ijk` has a zero-truncated
+//     Poisson distribution with mean `exp(E[log xi_i]) * sum_k X_ijk *
+//     exp(E[u_ijk^T beta])`, and is split over the days in proportion to the
+//     terms of the sum
+//
+//   q(xi_i):  a `Gamma(E[phi] + sum_jk E[W_ijk], E[phi] + sum_jk X_ijk *
+//     E[exp(u_ijk^T beta)])` distribution
+//
+//   q(gamma_h):  the mixture of the point mass at 1 and a truncated gamma
+//     distribution (see GammaCateg), with `a_tilde` and `b_tilde` calculated
+//     using `E[W]`, `E[xi]`, and `E[exp(u^T beta)]`
+//
+// The form of `q(gamma_h)` only depends on the prior for gamma_h and on the
+// column being a 0/1 column, and not on the sampler that is used for the
+// coefficient.  So each factor is calculated by a `GammaCateg` object that is
+// constructed from the specifications of the coefficient and owned by the
+// approximation, whichever sampler the coefficient has in `coefs`.
+//
+// Since each column is a 0/1 column, `E[exp(u_ijk^T beta)]` is the product of
+// `E[gamma_h]` over the columns with `u_ijkh` equal to 1.  The current values
+// of the sampler objects are set to the expectations, so that `ubeta` contains
+// `log E[exp(u^T beta)]` and the calculations for `b_tilde` are those of
+// `GammaCateg::calc_b_tilde`.  This also means that after the approximation is
+// fitted the sampler objects are in a valid state from which to start the
+// sampler.
+//
+// The approximation requires that each of the columns is a day-level 0/1
+// column that isn't a fertile window day effect, and that there is no missing
+// data (see `create_vb` in Dsp.cpp).
+//
+// `q(phi)` isn't a standard distribution, so phi is given a point estimate at
+// the mode of `q(phi)` and a Laplace approximation is used for the spread.  The
+// expectation `E[log gamma_h]` ignores the truncation of the gamma
+// distribution.
+
+class VarBayes {
+
+public:
+
+    // the sampler objects, which are not owned by the object
+    const WGen& m_W;
+    XiGen& m_xi;
+    CoefGen& m_coefs;
+    PhiGen& m_phi;
+    UProdBeta& m_ubeta;
+    const int* m_X;
+
+    // the objects that calculate `q(gamma_h)` for each coefficient, in the
+    // same order as in `m_coefs`.  Owned by the object.
+    std::vector<GammaCateg*> m_gamma;
+
+    // the largest number of coordinate ascent iterations, and the tolerance
+    // for the largest change in `log E[gamma_h]` and in `log E[phi]` at which
+    // the iterations stop
+    const int m_max_iter;
+    const double m_tol;
+    int m_n_iter;
+    bool m_is_converged;
+
+    // `E[W]` for each day in a pregnancy cycle, and `sum_jk E[W_ijk]`,
+    // `E[log xi_i]`, and the parameters of `q(xi_i)` for each subject
+    std::vector<double> m_w_means;
+    std::vector<double> m_w_sums;
+    std::vector<double> m_xi_elog;
+    std::vector<double> m_xi_shape;
+    std::vector<double> m_xi_rate;
+
+    // the parameters of `q(gamma_h)` and `E[log gamma_h]` for each coefficient
+    std::vector<double> m_a_tilde;
+    std::vector<double> m_b_tilde;
+    std::vector<double> m_p_tilde;
+    std::vector<double> m_gam_elog;
+
+    // the standard deviation of the Laplace approximation to `q(phi)`, or 0 if
+    // the log density isn't concave at the mode
+    double m_phi_sd;
+
+    VarBayes(const Rcpp::NumericVector& vb_specs,
+	     const WGen& W,
+	     XiGen& xi,
+	     CoefGen& coefs,
+	     PhiGen& phi,
+	     UProdBeta& ubeta,
+	     const int* X,
+	     const double* U,
+	     dsp_idx_t n_days,
+	     const Rcpp::List& gamma_specs);
+    ~VarBayes();
+
+    void fit();
+    void update_w();
+    void update_xi();
+    double update_gamma();
+    double update_phi();
+    Rcpp::List params() const;
+    Rcpp::List output(int n_samp);
+};
+
+
+#endif
@@ -1,24 +1,47 @@
 #include "Rcpp.h"
 #include "WGen.h"
 #include "DayBlock.h"
+#include "DayChunks.h"
 #include "XGen.h"
 
 
 
 
-WGen::WGen(Rcpp::List& preg_cyc,
+WGen::WGen(SEXP preg_cyc,
 	   Rcpp::IntegerVector& w_to_days_idx,
 	   Rcpp::IntegerVector& w_cyc_to_subj_idx,
 	   int fw_len) :
-    // subtract 1 from number of days and storage of values b/c we've included
-    // an extra value as a sentinal for loops
-    m_vals(new int[w_to_days_idx.size() - 1]),
-    m_sums(new int[preg_cyc.size()]),
+    // subtract 1 from number of days b/c we've included an extra value as a
+    // sentinal for loops
+    WGen(block_descr_to_arr<PregCyc>(preg_cyc),
+	 block_descr_size(preg_cyc),
+	 w_to_days_idx.begin(),
+	 w_to_days_idx.size() - 1,
+	 w_cyc_to_subj_idx.begin(),
+	 fw_len) {
+}
+
+
+
+
+// constructor for when the data is not stored in R objects (e.g. when it is
+// read from a model file).  `preg_cyc` is expected to have been allocated using
+// `new[]`, and ownership of it is taken by the object.  `n_preg_days` does not
+// include the sentinal value at the end of `w_to_days_idx`.
+
+WGen::WGen(PregCyc* preg_cyc,
+	   int n_preg_cyc,
+	   const int* w_to_days_idx,
+	   dsp_idx_t n_preg_days,
+	   const int* w_cyc_to_subj_idx,
+	   int fw_len) :
+    m_vals(new int[n_preg_days]),
+    m_sums(new int[n_preg_cyc]),
     m_days_idx(w_to_days_idx),
     m_subj_idx(w_cyc_to_subj_idx),
-    m_preg_cyc(PregCyc::list_to_arr(preg_cyc)),
-    m_n_preg_days(w_to_days_idx.size() - 1),
-    m_n_preg_cyc(preg_cyc.size()),
+    m_preg_cyc(preg_cyc),
+    m_n_preg_days(n_preg_days),
+    m_n_preg_cyc(n_preg_cyc),
     m_fw_len(fw_len) {
 }
 
@@ -46,11 +69,17 @@ void WGen::sample(XiGen& xi, UProdBeta& ubeta, XGen& X) {
     const int* x_vals = X.vals();
     // point to the beginning of the array storing the current values of `X_ijk
     // * exp( u_{ijk}^T beta )`
-    const double* ubeta_exp_vals = ubeta.exp_vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
 
     // scratch storage for multinomial probabilities
     double mult_probs[m_fw_len];
 
+    // the chunk of days containing the current cycle (see DayChunks.h).  Since
+    // the cycles are stored in the order of the days, we request the next
+    // chunk each time that we move into a new chunk.
+    int curr_chunk = 0;
+    g_day_chunks.prefetch(1);
+
     // each iteration samples new values for the `W_ijk` that were both (i) in
     // cycles that resulted in a pregnancy and were also (ii) days in which
     // intercourse occurred (or at least there was a missing value for
@@ -59,10 +88,17 @@ void WGen::sample(XiGen& xi, UProdBeta& ubeta, XGen& X) {
 
 	// the day-specific index and number of days in the current cycle
 	PregCyc curr_cyc = m_preg_cyc[q];
-	int curr_beg_idx = curr_cyc.beg_idx;
+	dsp_idx_t curr_beg_idx = curr_cyc.beg_idx;
 	int curr_n_days = curr_cyc.n_days;
 	int curr_subj_idx = curr_cyc.subj_idx;
 
+	// case: the current cycle is in a later chunk than the previous cycle
+	while ((curr_chunk < g_day_chunks.n_chunks() - 1)
+	       && (curr_beg_idx >= g_day_chunks.day_beg(curr_chunk + 1))) {
+	    ++curr_chunk;
+	    g_day_chunks.prefetch(curr_chunk + 1);
+	}
+
 	// variable to store the value of `sum_k W_ijk` for the current cycle
 	double curr_sum_val = 0;
 
@@ -73,7 +109,7 @@ void WGen::sample(XiGen& xi, UProdBeta& ubeta, XGen& X) {
 	for (int v = 0; v < curr_n_days; ++v) {
 
 	    // day-specific index of the v-th day in the current cycle
-	    int r = curr_beg_idx + v;
+	    dsp_idx_t r = curr_beg_idx + v;
 
 	    // copy and add in the `X_ijk * exp( u_{ijk}^T beta )` term to the
 	    // running total for `sum_k W_ijk`
@@ -18,15 +18,38 @@ using std::exp;
 
 // constructor
 XGen::XGen(Rcpp::IntegerVector& X_rcpp,
-	   Rcpp::List& miss_cyc,
-	   Rcpp::List& miss_day,
+	   SEXP miss_cyc,
+	   SEXP miss_day,
 	   double cohort_sex_prob,
 	   double sex_coef) :
-    m_x_rcpp(X_rcpp),
-    m_vals(X_rcpp.begin()),
-    m_miss_cyc(XMissCyc::list_to_arr(miss_cyc)),
-    m_n_miss_cyc(miss_cyc.size()),
-    m_miss_day(XGen::XMissDay::list_to_arr(miss_day)),
+    XGen(X_rcpp.begin(),
+	 X_rcpp.size(),
+	 block_descr_to_arr<XMissCyc>(miss_cyc),
+	 block_descr_size(miss_cyc),
+	 block_descr_to_arr<XMissDay>(miss_day),
+	 cohort_sex_prob,
+	 sex_coef) {
+}
+
+
+
+
+// constructor for when the data is not stored in R objects.  `miss_cyc` and
+// `miss_day` are expected to have been allocated using `new[]`, and ownership
+// of them is taken by the object.  Note that `X` is modified by the sampler.
+
+XGen::XGen(int* X,
+	   dsp_idx_t n_days,
+	   XMissCyc* miss_cyc,
+	   int n_miss_cyc,
+	   XMissDay* miss_day,
+	   double cohort_sex_prob,
+	   double sex_coef) :
+    m_vals(X),
+    m_n_days(n_days),
+    m_miss_cyc(miss_cyc),
+    m_n_miss_cyc(n_miss_cyc),
+    m_miss_day(miss_day),
     m_cohort_sex_prob(cohort_sex_prob),
     m_sex_coef(sex_coef) {
 }
@@ -60,10 +83,37 @@ XGen::XMissCyc* XGen::XMissCyc::list_to_arr(Rcpp::List& block_list) {
     for (int t = 0; t < block_list.size(); ++t) {
 
     	Rcpp::IntegerVector block_list_t = Rcpp::as<Rcpp::IntegerVector>(block_list[t]);
-    	block_arr[t] = XMissCyc(block_list_t["beg_idx"],
+    	block_arr[t] = XMissCyc((int) block_list_t["beg_idx"],
 				block_list_t["n_days"],
 				block_list_t["subj_idx"],
-				block_list_t["preg_idx"]);
+				(int) block_list_t["preg_idx"]);
+    }
+
+    return block_arr;
+}
+
+
+
+
+// similar to `XMissCyc::list_to_arr`, but now the blocks are specified by the
+// rows of an integer matrix with columns named `beg_idx`, `n_days`, `subj_idx`,
+// and `preg_idx`
+
+XGen::XMissCyc* XGen::XMissCyc::mat_to_arr(Rcpp::IntegerMatrix& block_mat) {
+
+    const int n_blocks = block_mat.nrow();
+    XMissCyc* block_arr = new XMissCyc[n_blocks];
+    if (n_blocks == 0) {
+	return block_arr;
+    }
+
+    const int* beg_idx  = block_mat_col(block_mat, "beg_idx");
+    const int* n_days   = block_mat_col(block_mat, "n_days");
+    const int* subj_idx = block_mat_col(block_mat, "subj_idx");
+    const int* preg_idx = block_mat_col(block_mat, "preg_idx");
+
+    for (int t = 0; t < n_blocks; ++t) {
+	block_arr[t] = XMissCyc(beg_idx[t], n_days[t], subj_idx[t], preg_idx[t]);
     }
 
     return block_arr;
@@ -89,7 +139,7 @@ XGen::XMissDay* XGen::XMissDay::list_to_arr(Rcpp::List& block_list) {
     for (int t = 0; t < block_list.size(); ++t) {
 
     	Rcpp::IntegerVector block_list_t = Rcpp::as<Rcpp::IntegerVector>(block_list[t]);
-    	block_arr[t] = XMissDay(block_list_t["idx"],
+    	block_arr[t] = XMissDay((int) block_list_t["idx"],
     				block_list_t["prev"]);
     }
 
@@ -99,6 +149,30 @@ XGen::XMissDay* XGen::XMissDay::list_to_arr(Rcpp::List& block_list) {
 
 
 
+// similar to `XMissDay::list_to_arr`, but now the missing days are specified by
+// the rows of an integer matrix with columns named `idx` and `prev`
+
+XGen::XMissDay* XGen::XMissDay::mat_to_arr(Rcpp::IntegerMatrix& block_mat) {
+
+    const int n_blocks = block_mat.nrow();
+    XMissDay* block_arr = new XMissDay[n_blocks];
+    if (n_blocks == 0) {
+	return block_arr;
+    }
+
+    const int* idx  = block_mat_col(block_mat, "idx");
+    const int* prev = block_mat_col(block_mat, "prev");
+
+    for (int t = 0; t < n_blocks; ++t) {
+	block_arr[t] = XMissDay(idx[t], prev[t]);
+    }
+
+    return block_arr;
+}
+
+
+
+
 // update the missing values of X
 void XGen::sample(const WGen& W,
 		  const XiGen& xi,
@@ -137,7 +211,7 @@ void XGen::sample_cycle(const XMissCyc* miss_cyc,
 
     // either the value of `NON_PREG_CYC` or the index in `W` of the first day
     // in the cycle
-    int curr_preg_idx = miss_cyc->preg_idx;
+    dsp_idx_t curr_preg_idx = miss_cyc->preg_idx;
 
     // if we don't have missing intercourse data for the day before the fertile
     // window, then we sample it using a global probability.  Note that
@@ -153,10 +227,10 @@ void XGen::sample_cycle(const XMissCyc* miss_cyc,
 
     // each iteration samples `X_{ijk_r}` for the day corresponding to
     // `curr_miss_day`
-    const int r_end = miss_cyc->beg_idx + miss_cyc->n_days;
-    for (int r = miss_cyc->beg_idx; r < r_end; ++r) {
+    const dsp_idx_t r_end = miss_cyc->beg_idx + miss_cyc->n_days;
+    for (dsp_idx_t r = miss_cyc->beg_idx; r < r_end; ++r) {
 
-	const int curr_day_idx = m_miss_day[r].idx;
+	const dsp_idx_t curr_day_idx = m_miss_day[r].idx;
 
 	// case: sex in the previous day was not missing, so the value of
 	// `prev_day_sex` is given by the known value rather than whatever
@@ -194,7 +268,7 @@ void XGen::sample_cycle(const XMissCyc* miss_cyc,
 
 
 inline double XGen::calc_prior_prob(const UProdTau& utau,
-				    const int miss_day_idx,
+				    const dsp_idx_t miss_day_idx,
 				    const int prev_day_sex) const {
 
     const double* utau_vals = utau.vals();
@@ -208,9 +282,9 @@ inline double XGen::calc_prior_prob(const UProdTau& utau,
 
 inline double XGen::calc_posterior_prob(const UProdBeta& ubeta,
 					const double xi_i,
-					const int day_idx) {
+					const dsp_idx_t day_idx) {
 
-    const double* ubeta_exp_vals = ubeta.exp_vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
     return exp(-xi_i * ubeta_exp_vals[day_idx]);
 }
 
@@ -246,7 +320,7 @@ inline int XGen::sample_day_before_fw_sex() const {
 // from non-imputed values.  Thus if the value is negative it was imputed (and
 // hence was missing), otherwise it was not imputed.
 
-inline bool XGen::check_if_prev_sex_miss(int miss_day_idx) const {
+inline bool XGen::check_if_prev_sex_miss(dsp_idx_t miss_day_idx) const {
     return (m_miss_day[miss_day_idx].prev < 0);
 }
 
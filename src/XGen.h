@@ -19,8 +19,8 @@ public:
     class XMissDay;
 
     // storage for the X values
-    Rcpp::IntegerVector& m_x_rcpp;
-    Rcpp::IntegerVector::iterator m_vals;
+    int* m_vals;
+    const dsp_idx_t m_n_days;
 
     // information about the number of X missing for a given cycle
     const XMissCyc* m_miss_cyc;
@@ -40,8 +40,15 @@ public:
 
 
     XGen(Rcpp::IntegerVector& X_rcpp,
-	 Rcpp::List& miss_cyc,
-	 Rcpp::List& miss_day,
+	 SEXP miss_cyc,
+	 SEXP miss_day,
+	 double cohort_sex_prob,
+	 double sex_coef);
+    XGen(int* X,
+	 dsp_idx_t n_days,
+	 XMissCyc* miss_cyc,
+	 int n_miss_cyc,
+	 XMissDay* miss_day,
 	 double cohort_sex_prob,
 	 double sex_coef);
     ~XGen();
@@ -58,23 +65,23 @@ public:
 		      const UProdTau& utau);
 
     double calc_prior_prob(const UProdTau& utau,
-			   const int miss_day_idx,
+			   const dsp_idx_t miss_day_idx,
 			   const int prev_day_sex) const;
 
     static double calc_posterior_prob(const UProdBeta& ubeta,
 				      const double xi_i,
-				      const int day_idx);
+				      const dsp_idx_t day_idx);
 
     static int sample_x_ijk(const double prior_prob_yes,
 			    const double posterior_prob_yes);
 
     int sample_day_before_fw_sex() const;
-    bool check_if_prev_sex_miss(int miss_day_idx) const;
+    bool check_if_prev_sex_miss(dsp_idx_t miss_day_idx) const;
 
     int* vals() { return m_vals; }
     const int* vals() const { return m_vals; }
     const XMissDay* miss_day() const { return m_miss_day; }
-    int n_days() const { return m_x_rcpp.size(); }
+    dsp_idx_t n_days() const { return m_n_days; }
     double sex_coef() const { return m_sex_coef; }
 
     // int calc_prior_probs(double prior_probs[][2],
@@ -121,16 +128,17 @@ class XGen::XMissCyc : public PregCyc {
 public:
 
     // either -1 or the index in W of the first day in the cycle
-    int preg_idx;
+    dsp_idx_t preg_idx;
 
     XMissCyc() : PregCyc(), preg_idx(0) {}
 
-    XMissCyc(int beg_idx, int n_days, int subj_idx, int preg_idx) :
+    XMissCyc(dsp_idx_t beg_idx, int n_days, int subj_idx, dsp_idx_t preg_idx) :
     	PregCyc(beg_idx, n_days, subj_idx),
     	preg_idx(preg_idx) {
     }
 
     static XMissCyc* list_to_arr(Rcpp::List& block_list);
+    static XMissCyc* mat_to_arr(Rcpp::IntegerMatrix& block_mat);
 };
 
 
@@ -140,17 +148,18 @@ class XGen::XMissDay {
 
 public:
 
-    int idx;   // index in day specific data
+    dsp_idx_t idx;   // index in day specific data
     int prev;  // whether intercourse occurred in the previous day
 
     XMissDay() : idx(0), prev(0) {}
 
-    XMissDay(int idx, int prev) :
+    XMissDay(dsp_idx_t idx, int prev) :
 	idx(idx),
 	prev(prev) {
     }
 
     static XMissDay* list_to_arr(Rcpp::List& block_list);
+    static XMissDay* mat_to_arr(Rcpp::IntegerMatrix& block_mat);
 };
 
 
@@ -1,21 +1,50 @@
+#include <algorithm>
+#include <cmath>
 #include "Rcpp.h"
 #include "XiGen.h"
 #include "WGen.h"
 #include "PhiGen.h"
 #include "XGen.h"
+#include "CycLik.h"
 #include "DayBlock.h"
+#include "DayChunks.h"
 #include "UProdBeta.h"
 
 
 
 
-XiGen::XiGen(Rcpp::List& subj_day_blocks, int n_samp, bool record_status) :
-    // m_vals_rcpp(Rcpp::NumericVector(Rcpp::no_init(subj_day_blocks.size() * (record_status ? n_samp : 1)))),
-    m_vals_rcpp(Rcpp::NumericVector(subj_day_blocks.size() * (record_status ? n_samp : 1))),
+XiGen::XiGen(SEXP subj_day_blocks, int n_samp, bool record_status) :
+    XiGen(block_descr_to_arr<DayBlock>(subj_day_blocks),
+	  block_descr_size(subj_day_blocks),
+	  n_samp,
+	  record_status) {
+}
+
+
+
+
+// `subj` is expected to have been allocated using `new[]`, and ownership of it
+// is taken by the object
+
+XiGen::XiGen(DayBlock* subj, int n_subj, int n_samp, bool record_status) :
+    // m_vals_rcpp(Rcpp::NumericVector(Rcpp::no_init(n_subj * (record_status ? n_samp : 1)))),
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    m_vals_rcpp(Rcpp::NumericVector(n_subj)),
+    m_vals(m_vals_rcpp.begin()),
+    m_draws((dsp_idx_t) n_subj * (record_status ? n_samp : 0)),
+#else
+    m_vals_rcpp(Rcpp::NumericVector((dsp_idx_t) n_subj * (record_status ? n_samp : 1))),
     m_vals(m_vals_rcpp.begin()),
-    m_subj(DayBlock::list_to_arr(subj_day_blocks)),
-    m_n_subj(subj_day_blocks.size()),
-    m_record_status(record_status)
+#endif
+    m_subj(subj),
+    m_n_subj(n_subj),
+    m_record_status(record_status),
+    m_sum_log_vals(0.0),
+    m_sum_vals(n_subj),
+    m_w_sums(n_subj, 0.0),
+    m_exp_sums(n_subj, 0.0),
+    m_rb_sums(n_subj, 0.0),
+    m_rb_n(0)
 {
     // initialize values for all subjects to 1 (i.e. no fecundability effect)
     for (int i = 0; i < m_n_subj; ++i) {
@@ -39,43 +68,215 @@ void XiGen::sample(const WGen& W, const PhiGen& phi, const UProdBeta& ubeta, con
     const int* w_sum_vals = W.sum_vals();
     const double phi_val = phi.val();
     const int* x_vals = X.vals();
-    const double* ubeta_exp_vals = ubeta.exp_vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+    const bool is_rb = ! g_burn_status;
+
+    double sum_log_vals = 0.0;
+    double sum_vals = 0.0;
 
     // if we are past the burn phase then move the pointer past the samples so
     // that we don't overwrite them
+#ifndef DSP_BAYES_FLOAT_DRAWS
     if (m_record_status && g_record_status) {
 	m_vals += m_n_subj;
     }
+#endif
 
-    // each iteration samples the i-th value of `xi_i` and stores it `m_xi_vals`
-    for (int i = 0; i < m_n_subj; ++i) {
+    // each iteration samples the i-th value of `xi_i` and stores it `m_xi_vals`.
+    // The subjects are processed a chunk at a time (see DayChunks.h).
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const int chunk_end = g_day_chunks.subj_end(c, m_n_subj);
 
-	int curr_idx, curr_end;
-	double curr_w_sum, curr_sum_exp_ubeta;
-
-    	// obtain `sum_jk W_ijk`
-    	if (i == *w_subj_idx) {
-    	    curr_w_sum = *w_sum_vals++;
-    	    ++w_subj_idx;
-    	}
-    	else {
-    	    curr_w_sum = 0;
-    	}
-
-    	// index in the day-specific data of the first day and one past the last
-    	// day for the current subject
-    	curr_idx = m_subj[i].beg_idx;
-    	curr_end = curr_idx + m_subj[i].n_days;
-
-    	// obtain `sum_jk { X_ijk * exp( u_{ijk}^T beta ) }`
-    	curr_sum_exp_ubeta = 0;
-    	for ( ; curr_idx < curr_end; ++curr_idx) {
-	    if (x_vals[curr_idx]) {
-		curr_sum_exp_ubeta += ubeta_exp_vals[curr_idx];
+	for (int i = g_day_chunks.subj_beg(c); i < chunk_end; ++i) {
+
+	    dsp_idx_t curr_idx, curr_end;
+	    double curr_w_sum, curr_sum_exp_ubeta;
+
+	    // obtain `sum_jk W_ijk`
+	    if (i == *w_subj_idx) {
+		curr_w_sum = *w_sum_vals++;
+		++w_subj_idx;
+	    }
+	    else {
+		curr_w_sum = 0;
 	    }
-    	}
 
-    	// sample new value of `xi_i`
-    	m_vals[i] = R::rgamma(phi_val + curr_w_sum, 1 / (phi_val + curr_sum_exp_ubeta));
+	    // index in the day-specific data of the first day and one past the
+	    // last day for the current subject
+	    curr_idx = m_subj[i].beg_idx;
+	    curr_end = curr_idx + m_subj[i].n_days;
+
+	    // obtain `sum_jk { X_ijk * exp( u_{ijk}^T beta ) }`.  Note that `X_ijk`
+	    // can be larger than 1 for a day that represents several collapsed
+	    // non-pregnancy days.
+	    curr_sum_exp_ubeta = 0;
+	    for ( ; curr_idx < curr_end; ++curr_idx) {
+		if (x_vals[curr_idx]) {
+		    curr_sum_exp_ubeta += x_vals[curr_idx] * ubeta_exp_vals[curr_idx];
+		}
+	    }
+
+	    // sample new value of `xi_i` and add it to the sufficient statistics
+	    // for phi.  After the burn-in phase the expected value of the full
+	    // conditional distribution is also accumulated.
+	    const double xi_shape = phi_val + curr_w_sum;
+	    const double xi_rate = phi_val + curr_sum_exp_ubeta;
+	    const double xi_val = R::rgamma(xi_shape, 1 / xi_rate);
+	    if (is_rb) {
+		m_rb_sums[i] += xi_shape / xi_rate;
+	    }
+	    m_vals[i] = xi_val;
+	    sum_log_vals += log(xi_val);
+	    sum_vals += xi_val;
+	    m_w_sums[i] = curr_w_sum;
+	    m_exp_sums[i] = curr_sum_exp_ubeta;
+	}
+    }
+    m_sum_log_vals = sum_log_vals;
+    m_sum_vals = sum_vals;
+    m_rb_n += is_rb;
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status && ! g_burn_status) {
+	m_draws.record(m_vals, m_n_subj);
+    }
+#endif
+}
+
+
+
+
+// sample xi against the likelihood of the pregnancy outcomes of the cycles with
+// `W` integrated out (see CycLik.h).  The full conditional distribution of each
+// `xi_i` is no longer a gamma distribution, so each `xi_i` is sampled by a slice
+// sampler given its current value, and since there is no closed form for the
+// expected value the samples themselves are accumulated for the
+// Rao-Blackwellized estimates.  The sums used by the interweaving step for phi
+// aren't calculated.
+
+void XiGen::sample_lik(const CycLik& lik, const PhiGen& phi) {
+
+    const double phi_val = phi.val();
+    const bool is_rb = ! g_burn_status;
+    const double* prev_vals = m_vals;
+
+    double sum_log_vals = 0.0;
+    double sum_vals = 0.0;
+
+#ifndef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status && g_record_status) {
+	m_vals += m_n_subj;
+    }
+#endif
+
+    for (int i = 0; i < m_n_subj; ++i) {
+	const double xi_val = lik.sample_xi(i, prev_vals[i], phi_val);
+	if (is_rb) {
+	    m_rb_sums[i] += xi_val;
+	}
+	m_vals[i] = xi_val;
+	sum_log_vals += log(xi_val);
+	sum_vals += xi_val;
+    }
+    m_sum_log_vals = sum_log_vals;
+    m_sum_vals = sum_vals;
+    m_rb_n += is_rb;
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status && ! g_burn_status) {
+	m_draws.record(m_vals, m_n_subj);
+    }
+#endif
+}
+
+
+
+
+// recalculate `sum_i log(xi_i)` and `sum_i xi_i`, which is needed after the
+// values of xi have been set other than by `sample`
+
+void XiGen::calc_sums() {
+    m_sum_log_vals = 0.0;
+    m_sum_vals = 0.0;
+    for (int i = 0; i < m_n_subj; ++i) {
+	m_sum_log_vals += log(m_vals[i]);
+	m_sum_vals += m_vals[i];
+    }
+}
+
+
+
+
+// replace the values of xi recorded by the last call to `sample` with the
+// current values, which is needed after the values have been changed in place
+// (see `PhiGen::sample_asis`).  This is only needed when recording samples in
+// single precision, since otherwise `m_vals` points to the recorded values.
+
+void XiGen::replace_recorded() {
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status && ! g_burn_status) {
+	m_draws.replace_last(m_vals, m_n_subj);
+    }
+#endif
+}
+
+
+
+
+// exchange the current values of xi with those of `other`, which is used to
+// swap the states of two chains of a temperature ladder (see TemperLadder.h).
+// The swap is performed after the values for the scan have been recorded, so
+// the recorded values are replaced by the values after the swap.  The same
+// goes for the terms for the scan in the Rao-Blackwellized sums, which for the
+// likelihood engine are the sampled values (see `sample_lik`).
+
+void XiGen::swap_state(XiGen& other) {
+    if (! g_burn_status) {
+	for (int i = 0; i < m_n_subj; ++i) {
+	    const double xi_diff = other.m_vals[i] - m_vals[i];
+	    m_rb_sums[i] += xi_diff;
+	    other.m_rb_sums[i] -= xi_diff;
+	}
+    }
+    std::swap_ranges(m_vals, m_vals + m_n_subj, other.m_vals);
+    calc_sums();
+    other.calc_sums();
+    replace_recorded();
+    other.replace_recorded();
+}
+
+
+
+
+// the Rao-Blackwellized estimates of the posterior means of xi, given by the
+// average over the scans after the burn-in phase of the expected value of the
+// full conditional distribution of each `xi_i`,
+//
+//     (phi + sum_jk W_ijk) / (phi + sum_jk X_ijk * exp(u_ijk^T beta)),
+//
+// which have lower variance than the averages of the samples
+
+Rcpp::NumericVector XiGen::rb_means() const {
+
+    Rcpp::NumericVector out(m_n_subj);
+    for (int i = 0; i < m_n_subj; ++i) {
+	out[i] = (m_rb_n > 0) ? (m_rb_sums[i] / m_rb_n) : NA_REAL;
+    }
+
+    return out;
+}
+
+
+
+
+// the recorded samples of xi.  See Precision.h for the form of the return value
+// when the samples are recorded in single precision.
+
+Rcpp::RObject XiGen::recorded_draws() const {
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    if (m_record_status) {
+	return m_draws.rcpp();
     }
+#endif
+    return m_vals_rcpp;
 }
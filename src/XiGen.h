@@ -1,14 +1,18 @@
 #ifndef DSP_BAYES_SRC_XI_GEN_H
 #define DSP_BAYES_SRC_XI_GEN_H
 
+#include <vector>
 #include "Rcpp.h"
 class WGen;
 class PhiGen;
 class XGen;
+class CycLik;
 #include "DayBlock.h"
+#include "Precision.h"
 #include "UProdBeta.h"
 
 extern bool g_record_status;
+extern bool g_burn_status;
 
 
 class XiGen {
@@ -19,6 +23,12 @@ public:
     Rcpp::NumericVector m_vals_rcpp;
     Rcpp::NumericVector::iterator m_vals;
 
+#ifdef DSP_BAYES_FLOAT_DRAWS
+    // when recording samples in single precision, `m_vals_rcpp` only stores
+    // the current values of xi, and the samples are recorded in `m_draws`
+    FloatDraws m_draws;
+#endif
+
     // the elements of `m_subj` each map an individual to a block of days from
     // the day-specific data
     const DayBlock* m_subj;
@@ -31,13 +41,41 @@ public:
     // tracks whether we wish to save the samples of xi to return to the user
     bool m_record_status;
 
-    XiGen(Rcpp::List& subj_day_blocks, int n_samp, bool record_status);
+    // `sum_i log(xi_i)` and `sum_i xi_i` for the current values of xi, which
+    // are the sufficient statistics for phi (see PhiGen.h).  These are
+    // accumulated as xi is sampled.
+    double m_sum_log_vals;
+    double m_sum_vals;
+
+    // `sum_jk W_ijk` and `sum_jk X_ijk * exp(u_ijk^T beta)` for each subject,
+    // as calculated by the last call to `sample`
+    std::vector<double> m_w_sums;
+    std::vector<double> m_exp_sums;
+
+    // the sum over the scans after the burn-in phase of the expected value of
+    // each `xi_i` given the other parameters, and the number of such scans,
+    // for the Rao-Blackwellized estimates of the posterior means
+    std::vector<double> m_rb_sums;
+    int m_rb_n;
+
+    XiGen(SEXP subj_day_blocks, int n_samp, bool record_status);
+    XiGen(DayBlock* subj, int n_subj, int n_samp, bool record_status);
     ~XiGen();
 
     void sample(const WGen& W, const PhiGen& phi, const UProdBeta& ubeta, const XGen& X);
+    void sample_lik(const CycLik& lik, const PhiGen& phi);
+    void calc_sums();
+    void replace_recorded();
+    void swap_state(XiGen& other);
 
+    Rcpp::RObject recorded_draws() const;
+    Rcpp::NumericVector rb_means() const;
     const double* vals() const { return m_vals; }
     const int n_subj() const { return m_n_subj; }
+    double sum_log_vals() const { return m_sum_log_vals; }
+    double sum_vals() const { return m_sum_vals; }
+    const double* w_sums() const { return m_w_sums.data(); }
+    const double* exp_sums() const { return m_exp_sums.data(); }
 };
 
 
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Rcpp.h"
+#include "XiMarg.h"
+#include "DayBlock.h"
+#include "DayChunks.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+
+
+
+XiMarg::XiMarg(const XiGen& xi) :
+    // initialization list
+    m_subj(xi.m_subj),
+    m_n_subj(xi.m_n_subj),
+    m_w_sums(xi.m_n_subj, 0.0),
+    m_exp_sums(xi.m_n_subj, 0.0),
+    m_exp_diffs(xi.m_n_subj, 0.0) {
+}
+
+
+
+
+// calculate `W_i` and `S_i` for each subject.  This is the same sweep over the
+// days that is performed by `XiGen::sample`.
+
+void XiMarg::calc_stats(const WGen& W, const UProdBeta& ubeta, const int* X) {
+
+    const int* w_subj_idx = W.subj_idx();
+    const int* w_sum_vals = W.sum_vals();
+    const dsp_store_t* ubeta_exp_vals = ubeta.exp_vals();
+
+    for (int c = 0; c < g_day_chunks.n_chunks(); ++c) {
+
+	g_day_chunks.prefetch(c + 1);
+	const int chunk_end = g_day_chunks.subj_end(c, m_n_subj);
+
+	for (int i = g_day_chunks.subj_beg(c); i < chunk_end; ++i) {
+
+	    // obtain `sum_jk W_ijk`
+	    double curr_w_sum = 0.0;
+	    if (i == *w_subj_idx) {
+		curr_w_sum = *w_sum_vals++;
+		++w_subj_idx;
+	    }
+
+	    double curr_exp_sum = 0.0;
+	    const dsp_idx_t curr_end = m_subj[i].beg_idx + m_subj[i].n_days;
+	    for (dsp_idx_t r = m_subj[i].beg_idx; r < curr_end; ++r) {
+		if (X[r]) {
+		    curr_exp_sum += X[r] * ubeta_exp_vals[r];
+		}
+	    }
+
+	    m_w_sums[i] = curr_w_sum;
+	    m_exp_sums[i] = curr_exp_sum;
+	}
+    }
+}
+
+
+
+
+// set the changes in `S_i` to 0 before they are accumulated for a proposal
+
+void XiMarg::reset_diffs() {
+    std::fill(m_exp_diffs.begin(), m_exp_diffs.end(), 0.0);
+}
+
+
+
+
+// the log-likelihood ratio of a proposal value of a coefficient, for which the
+// change in `S_i` is `D_i`, given by
+//
+//     - sum_i (phi + W_i) * log{ (phi + S_i + D_i) / (phi + S_i) }
+//
+// plus the term `sum W * U_h * (beta_h* - beta_h^(s))`, which is calculated by
+// the caller
+
+double XiMarg::log_lik_diff(double phi_val) const {
+
+    double sum_log_lik = 0.0;
+    for (int i = 0; i < m_n_subj; ++i) {
+	const double exp_diff = m_exp_diffs[i];
+	if (exp_diff != 0.0) {
+	    const double shape = phi_val + m_w_sums[i];
+	    sum_log_lik -= shape * log1p(exp_diff / (phi_val + m_exp_sums[i]));
+	}
+    }
+
+    return sum_log_lik;
+}
+
+
+
+
+// update `S_i` based upon accepting a proposal value of a coefficient
+
+void XiMarg::commit() {
+    for (int i = 0; i < m_n_subj; ++i) {
+	m_exp_sums[i] += m_exp_diffs[i];
+    }
+}
+
+
+
+
+// the log-likelihood as a function of phi, given by
+//
+//     sum_i { phi * log(phi) - log Gamma(phi) + log Gamma(phi + W_i)
+//             - (phi + W_i) * log(phi + S_i) }
+
+double XiMarg::log_lik_phi(double phi_val) const {
+
+    double sum_log_lik = m_n_subj * ((phi_val * log(phi_val)) - R::lgammafn(phi_val));
+    for (int i = 0; i < m_n_subj; ++i) {
+	const double shape = phi_val + m_w_sums[i];
+	sum_log_lik += R::lgammafn(shape) - (shape * log(phi_val + m_exp_sums[i]));
+    }
+
+    return sum_log_lik;
+}
@@ -0,0 +1,52 @@
+#ifndef DSP_BAYES_SRC_XI_MARG_H
+#define DSP_BAYES_SRC_XI_MARG_H
+
+#include <vector>
+#include "DayBlock.h"
+#include "UProdBeta.h"
+#include "WGen.h"
+#include "XiGen.h"
+
+
+// the sufficient statistics for the likelihood of `W` with xi integrated out.
+//
+// Given `xi_i` the `W_ijk` are independent `Poisson(X_ijk * xi_i * exp(u_ijk^T
+// beta))` random variables, and `xi_i` has a `Gamma(phi, phi)` prior, so that
+// integrating out `xi_i` gives, up to terms that don't depend on beta or phi,
+//
+//                          Gamma(phi + W_i)          phi^phi
+//     p(W_i | beta, phi) = ---------------- * --------------------- * prod_jk exp(u_ijk^T beta)^W_ijk
+//                            Gamma(phi)       (phi + S_i)^(phi + W_i)
+//
+// where `W_i = sum_jk W_ijk` and `S_i = sum_jk X_ijk * exp(u_ijk^T beta)`.  The
+// object stores `W_i` and `S_i` for each subject, so that the likelihood for a
+// proposal value of phi or of a coefficient is able to be calculated without
+// xi (see `PhiGen::sample_marg` and `GammaContMH::sample_marg`).
+
+class XiMarg {
+
+public:
+
+    // the elements of `m_subj` each map an individual to a block of days from
+    // the day-specific data.  Not owned by the object.
+    const DayBlock* m_subj;
+    const int m_n_subj;
+
+    // `W_i` and `S_i` for each subject, and storage for the change in `S_i`
+    // under a proposal value of a coefficient
+    std::vector<double> m_w_sums;
+    std::vector<double> m_exp_sums;
+    std::vector<double> m_exp_diffs;
+
+    XiMarg(const XiGen& xi);
+
+    void calc_stats(const WGen& W, const UProdBeta& ubeta, const int* X);
+    void reset_diffs();
+    double log_lik_diff(double phi_val) const;
+    void commit();
+    double log_lik_phi(double phi_val) const;
+    int n_subj() const { return m_n_subj; }
+};
+
+
+#endif
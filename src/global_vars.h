@@ -6,5 +6,12 @@ extern int* d2s;
 
 
 
+// whether the sampler is in the burn-in phase, during which the tuning
+// parameters of the Metropolis-Hastings steps are adapted (see MhAdapt.h)
+extern bool g_burn_status;
+
+
+
+
 // each element corresponds to a cycle index with a pregnancy
 extern int* cycs_w_preg;